@@ -26,7 +26,7 @@ struct Result {
     /**
      * @brief 默认构造函数，初始化为成功状态
      */
-    Result() : code(0), message("成功") {}
+    Result() : code(0), message(QStringLiteral("成功")) {}
 
     /**
      * @brief 带状态码和消息的构造函数
@@ -61,7 +61,7 @@ struct Result {
      * @return 成功的Result对象
      */
     static Result success(const QVariant& data = QVariant()) {
-        return Result(0, "成功", data);
+        return Result(0, QStringLiteral("成功"), data);
     }
 
     /**
@@ -0,0 +1,84 @@
+/**
+ * @file spscqueue.h
+ * @brief 单生产者单消费者无锁队列
+ *
+ * 本文件定义了固定容量的SPSC环形队列，用于采集线程向界面线程传递结果。
+ * 生产者和消费者各自只写自己的下标，通过acquire/release保证可见性，
+ * 不使用互斥锁，也不会在入队/出队时分配内存。
+ */
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/**
+ * @class SpscQueue
+ * @brief 单生产者单消费者无锁环形队列
+ * @tparam T 元素类型
+ * @tparam Capacity 容量，必须为2的幂
+ *
+ * 同一时刻只能有一个线程调用tryPush，另一个线程调用tryPop。
+ */
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscQueue capacity must be a power of two");
+
+public:
+    SpscQueue() : m_head(0), m_tail(0) {}
+
+    /**
+     * @brief 入队（仅生产者线程调用）
+     * @param value 元素
+     * @return false表示队列已满，元素未入队
+     */
+    bool tryPush(T value)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) >= Capacity) {
+            return false;
+        }
+        m_slots[tail & (Capacity - 1)] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 出队（仅消费者线程调用）
+     * @param value 输出元素
+     * @return false表示队列为空
+     */
+    bool tryPop(T &value)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = std::move(m_slots[head & (Capacity - 1)]);
+        m_slots[head & (Capacity - 1)] = T();   // 尽早释放元素持有的资源
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 当前元素个数（近似值，仅用于统计）
+     */
+    size_t size() const
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+private:
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    T m_slots[Capacity];                    ///< 环形缓冲区
+    alignas(64) std::atomic<size_t> m_head; ///< 消费者下标
+    alignas(64) std::atomic<size_t> m_tail; ///< 生产者下标
+};
+
+#endif // SPSCQUEUE_H
@@ -10,12 +10,12 @@
 #include "../common/appstyle.h"
 #include "../common/toast.h"
 #include "../common/confirmdialog.h"
+#include "../service/busscanner.h"
 #include "../service/deviceservice.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QHeaderView>
-#include <QTimer>
 
 DeviceListPage::DeviceListPage(QWidget *parent)
     : QWidget(parent)
@@ -32,6 +32,9 @@ DeviceListPage::DeviceListPage(QWidget *parent)
 {
     setupUI();
     loadDevices();
+
+    connect(BusScanner::instance(), &BusScanner::progress, this, &DeviceListPage::onScanProgress);
+    connect(BusScanner::instance(), &BusScanner::finished, this, &DeviceListPage::onScanFinished);
 }
 
 DeviceListPage::~DeviceListPage()
@@ -261,28 +264,42 @@ void DeviceListPage::onDeleteClicked()
 
 void DeviceListPage::onScanClicked()
 {
-    m_scanBtn->setEnabled(false);
-    m_scanProgress->setVisible(true);
+    if (BusScanner::instance()->isRunning()) {
+        BusScanner::instance()->cancel();
+        return;
+    }
+
+    m_scanProgress->setRange(0, BusScanner::MaxAddress - BusScanner::MinAddress + 1);
     m_scanProgress->setValue(0);
+    m_scanProgress->setVisible(true);
+    m_scanBtn->setText("取消");
 
-    // 模拟扫描进度
-    QTimer *timer = new QTimer(this);
-    connect(timer, &QTimer::timeout, this, [this, timer]() {
-        int value = m_scanProgress->value() + 10;
-        m_scanProgress->setValue(value);
-
-        if (value >= 100) {
-            timer->stop();
-            timer->deleteLater();
-            m_scanProgress->setVisible(false);
-            m_scanBtn->setEnabled(true);
-
-            Result result = DeviceService::scanModbusDevices();
-            if (result.isSuccess()) {
-                QVariantList found = result.data.toList();
-                Toast::showSuccess(this, QString("发现 %1 个设备").arg(found.size()));
-            }
-        }
-    });
-    timer->start(200);
+    Result result = BusScanner::instance()->start();
+    if (!result.isSuccess()) {
+        m_scanProgress->setVisible(false);
+        m_scanBtn->setText("扫描");
+        Toast::showError(this, result.message);
+    }
+}
+
+void DeviceListPage::onScanProgress(int done, int total, int found)
+{
+    m_scanProgress->setRange(0, total);
+    m_scanProgress->setValue(done);
+    m_scanProgress->setFormat(QString("%p%  已发现 %1 个").arg(found));
+}
+
+void DeviceListPage::onScanFinished(const Result &result)
+{
+    m_scanProgress->setVisible(false);
+    m_scanBtn->setText("扫描");
+
+    QVariantMap data = result.data.toMap();
+    int found = data["found"].toList().size();
+    double seconds = data["elapsedMs"].toLongLong() / 1000.0;
+    if (result.isSuccess()) {
+        Toast::showSuccess(this, QString("发现 %1 个设备，用时 %2 秒").arg(found).arg(seconds, 0, 'f', 1));
+    } else {
+        Toast::showError(this, QString("%1，已发现 %2 个设备").arg(result.message).arg(found));
+    }
 }
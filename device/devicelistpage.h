@@ -15,6 +15,8 @@
 #include <QProgressBar>
 #include <QLabel>
 
+#include "../common/result.h"
+
 /**
  * @class DeviceListPage
  * @brief 设备列表页面类
@@ -44,6 +46,8 @@ private slots:
     void onEditClicked();
     void onDeleteClicked();
     void onScanClicked();
+    void onScanProgress(int done, int total, int found);
+    void onScanFinished(const Result &result);
     void onTableSelectionChanged();
 
 private:
@@ -9,8 +9,7 @@
 #include "homepage.h"
 #include "../common/appstyle.h"
 #include "../service/systemservice.h"
-#include "../service/deviceservice.h"
-#include "../service/alarmservice.h"
+#include "../service/eventbus.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -44,12 +43,12 @@ HomePage::HomePage(QWidget *parent)
     connect(m_timeTimer, &QTimer::timeout, this, &HomePage::updateTime);
     m_timeTimer->start(1000);
 
+    // 状态刷新在页面可见时开始（见showEvent）
     connect(m_refreshTimer, &QTimer::timeout, this, &HomePage::onRefreshTimer);
-    m_refreshTimer->start(5000);
+    m_refreshTimer->setInterval(5000);
 
     // 初始更新
     updateTime();
-    updateStatusCards();
 }
 
 HomePage::~HomePage()
@@ -241,15 +240,42 @@ void HomePage::updateTime()
 
 void HomePage::onRefreshTimer()
 {
-    updateStatusCards();
+    updateStatusBar();
 }
 
 void HomePage::refreshStatus()
 {
+    updateStatusBar();
     updateStatusCards();
 }
 
-void HomePage::updateStatusCards()
+void HomePage::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+
+    if (m_subscriptions.isEmpty()) {
+        EventBus *bus = EventBus::instance();
+        m_subscriptions << connect(bus, &EventBus::deviceCountChanged, this, &HomePage::onDeviceCountChanged)
+                        << connect(bus, &EventBus::alarmCountChanged, this, &HomePage::onAlarmCountChanged)
+                        << connect(bus, &EventBus::commRateChanged, this, &HomePage::onCommRateChanged);
+    }
+    refreshStatus();
+    m_refreshTimer->start();
+}
+
+void HomePage::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+
+    // 不可见时不处理任何推送
+    for (const QMetaObject::Connection &c : m_subscriptions) {
+        disconnect(c);
+    }
+    m_subscriptions.clear();
+    m_refreshTimer->stop();
+}
+
+void HomePage::updateStatusBar()
 {
     // 获取系统信息
     Result sysResult = SystemService::getSystemInfo();
@@ -271,47 +297,49 @@ void HomePage::updateStatusCards()
         // 更新RS485状态
         bool rs485Ok = status["rs485"].toBool();
         m_rs485Icon->setStyleSheet(rs485Ok ? "color: #00ff88; font-size: 9pt;" : "color: #ff4444; font-size: 9pt;");
+    }
+}
+
+void HomePage::updateStatusCards()
+{
+    // 订阅开始时用当前计数初始化，之后由推送增量更新
+    StatusCounters counters = EventBus::instance()->counters();
+    onDeviceCountChanged(counters.deviceOnline, counters.deviceTotal);
+    onAlarmCountChanged(counters.alarmActive, counters.alarmTotal);
+    onCommRateChanged(counters.commRate);
+}
 
-        // 更新通信正常率
-        int commRate = status["commRate"].toInt();
-        m_commRateLabel->setText(QString("%1%").arg(commRate));
-        if (commRate >= 90) {
-            m_commRateLabel->setStyleSheet("color: #00ff88; font-size: 20pt; font-weight: bold; background: transparent;");
-        } else if (commRate >= 70) {
-            m_commRateLabel->setStyleSheet("color: #ffaa00; font-size: 20pt; font-weight: bold; background: transparent;");
-        } else {
-            m_commRateLabel->setStyleSheet("color: #ff4444; font-size: 20pt; font-weight: bold; background: transparent;");
-        }
+void HomePage::onDeviceCountChanged(int online, int total)
+{
+    Q_UNUSED(total)
+    m_deviceCountLabel->setText(QString::number(online));
+}
+
+void HomePage::onAlarmCountChanged(int active, int total)
+{
+    Q_UNUSED(total)
+    m_alarmCountLabel->setText(QString::number(active));
+    if (active > 0) {
+        m_alarmCountLabel->setStyleSheet("color: #ff4444; font-size: 20pt; font-weight: bold; background: transparent;");
+    } else {
+        m_alarmCountLabel->setStyleSheet("color: #00ff88; font-size: 20pt; font-weight: bold; background: transparent;");
     }
+}
 
-    // 获取设备数量
-    Result deviceResult = DeviceService::getDeviceList();
-    if (deviceResult.isSuccess()) {
-        QVariantList devices = deviceResult.data.toList();
-        int onlineCount = 0;
-        for (const QVariant &dev : devices) {
-            if (dev.toMap()["online"].toBool()) {
-                onlineCount++;
-            }
-        }
-        m_deviceCountLabel->setText(QString::number(onlineCount));
+void HomePage::onCommRateChanged(int percent)
+{
+    if (percent < 0) {
+        m_commRateLabel->setText("--%");
+        m_commRateLabel->setStyleSheet("color: #ffffff; font-size: 20pt; font-weight: bold; background: transparent;");
+        return;
     }
 
-    // 获取告警数量
-    Result alarmResult = AlarmService::getAlarmList();
-    if (alarmResult.isSuccess()) {
-        QVariantList alarms = alarmResult.data.toList();
-        int activeCount = 0;
-        for (const QVariant &alarm : alarms) {
-            if (!alarm.toMap()["acknowledged"].toBool()) {
-                activeCount++;
-            }
-        }
-        m_alarmCountLabel->setText(QString::number(activeCount));
-        if (activeCount > 0) {
-            m_alarmCountLabel->setStyleSheet("color: #ff4444; font-size: 20pt; font-weight: bold; background: transparent;");
-        } else {
-            m_alarmCountLabel->setStyleSheet("color: #00ff88; font-size: 20pt; font-weight: bold; background: transparent;");
-        }
+    m_commRateLabel->setText(QString("%1%").arg(percent));
+    if (percent >= 90) {
+        m_commRateLabel->setStyleSheet("color: #00ff88; font-size: 20pt; font-weight: bold; background: transparent;");
+    } else if (percent >= 70) {
+        m_commRateLabel->setStyleSheet("color: #ffaa00; font-size: 20pt; font-weight: bold; background: transparent;");
+    } else {
+        m_commRateLabel->setStyleSheet("color: #ff4444; font-size: 20pt; font-weight: bold; background: transparent;");
     }
 }
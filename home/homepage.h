@@ -4,7 +4,8 @@
  *
  * 本文件定义了工业设备监控系统的主页面，显示顶部状态栏（时间、网络状态、
  * RS485状态、CPU/内存使用率），中部状态卡片（在线设备数、告警数、通信正常率），
- * 以及导航按钮（设备管理、实时监控、告警中心、系统设置）。
+ * 以及导航按钮（设备管理、实时监控、告警中心、系统设置）。状态卡片在页面可见期间
+ * 订阅EventBus，由各服务推送的变化驱动更新。
  */
 
 #ifndef HOMEPAGE_H
@@ -35,6 +36,10 @@ public:
      */
     void refreshStatus();
 
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
 signals:
     void navigateToDevices();   ///< 跳转到设备管理页面
     void navigateToMonitor();   ///< 跳转到实时监控页面
@@ -43,13 +48,17 @@ signals:
 
 private slots:
     void updateTime();          ///< 更新时间显示
-    void onRefreshTimer();      ///< 定时刷新状态
+    void onRefreshTimer();      ///< 定时刷新状态栏（CPU、内存等采样值）
+    void onDeviceCountChanged(int online, int total);
+    void onAlarmCountChanged(int active, int total);
+    void onCommRateChanged(int percent);
 
 private:
     void setupUI();
     void setupStatusBar();
     void setupStatusCards();
     void setupNavigationButtons();
+    void updateStatusBar();
     void updateStatusCards();
 
     // 状态栏控件
@@ -76,7 +85,9 @@ private:
 
     // 定时器
     QTimer *m_timeTimer;        ///< 时间更新定时器
-    QTimer *m_refreshTimer;     ///< 状态刷新定时器
+    QTimer *m_refreshTimer;     ///< 状态栏刷新定时器（仅页面可见时运行）
+
+    QList<QMetaObject::Connection> m_subscriptions;    ///< 页面可见期间对EventBus的订阅
 };
 
 #endif // HOMEPAGE_H
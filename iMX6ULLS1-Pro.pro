@@ -1,4 +1,4 @@
-QT += core gui network widgets
+QT += core gui network sql widgets
 CONFIG += c++17
 
 # 目标文件名
@@ -33,6 +33,7 @@ SOURCES += common/appstyle.cpp \
 HEADERS += common/appstyle.h \
            common/confirmdialog.h \
            common/result.h \
+           common/spscqueue.h \
            common/toast.h
 
 # Device目录
@@ -54,19 +55,7 @@ HEADERS += monitor/datadetailpage.h \
            monitor/monitorpage.h
 
 # Service目录
-SOURCES += service/alarmservice.cpp \
-           service/deviceservice.cpp \
-           service/modbusservice.cpp \
-           service/mqttservice.cpp \
-           service/networkservice.cpp \
-           service/systemservice.cpp
-
-HEADERS += service/alarmservice.h \
-           service/deviceservice.h \
-           service/modbusservice.h \
-           service/mqttservice.h \
-           service/networkservice.h \
-           service/systemservice.h
+include(service/service.pri)
 
 # 包含路径
 INCLUDEPATH += . \
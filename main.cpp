@@ -8,6 +8,11 @@
 
 #include "mainwindow.h"
 #include "common/appstyle.h"
+#include "service/acquisitionservice.h"
+#include "service/alarmservice.h"
+#include "service/databaseservice.h"
+#include "service/systemservice.h"
+#include "service/timeseriesstore.h"
 
 #include <QApplication>
 
@@ -32,5 +37,17 @@ int main(int argc, char *argv[])
     MainWindow w;
     w.show();
 
-    return a.exec();
+    // 打开数据库和历史数据目录（失败时只保留在内存中）并应用保存的保留天数，再加载
+    // 告警数据并按各设备的轮询间隔启动后台采集，初始计数经EventBus推送到首页
+    DatabaseService::open(DatabaseService::defaultPath());
+    TimeSeriesStore::open(TimeSeriesStore::defaultDirectory());
+    SystemService::loadRetention();
+    AlarmService::initialize();
+    AcquisitionService::instance()->start();
+
+    int ret = a.exec();
+    AcquisitionService::instance()->shutdown();     // 在QApplication析构前停止采集线程
+    TimeSeriesStore::close();                       // 采集停止后把内存中的历史写盘
+    DatabaseService::close();                       // 提交队列中剩余的写任务
+    return ret;
 }
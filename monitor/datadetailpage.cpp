@@ -9,10 +9,12 @@
 #include "datadetailpage.h"
 #include "../common/appstyle.h"
 #include "../service/modbusservice.h"
+#include "../service/registersnapshot.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QGridLayout>
+#include <QDateTime>
 
 DataDetailPage::DataDetailPage(QWidget *parent)
     : QWidget(parent)
@@ -204,17 +206,37 @@ void DataDetailPage::updateData()
     if (m_deviceId < 0 || m_registerAddr < 0) return;
 
     Result result = ModbusService::getHistoryData(m_deviceId, m_registerAddr);
-    if (!result.isSuccess()) {
-        return;
+
+    // 当前值取自实时值缓存，不占用总线
+    Result realtime = ModbusService::getRealtimeValue(m_deviceId, m_registerAddr);
+    if (realtime.isSuccess()) {
+        QVariantMap value = realtime.data.toMap();
+        m_currentValueLabel->setText(QString::number(value["value"].toDouble(), 'f', 1));
+        bool good = value["qualityCode"].toInt() == RegisterSnapshot::Good;
+        m_currentValueLabel->setStyleSheet(QString("color: %1; font-size: 36pt; font-weight: bold; background: transparent;")
+                                           .arg(good ? "#00ff88" : "#606060"));
+        m_unitLabel->setText(value["unit"].toString());
+        QDateTime updated = QDateTime::fromMSecsSinceEpoch(value["timestampNs"].toLongLong() / 1000000);
+        m_updateTimeLabel->setText(QString("最后更新: %1  %2")
+                                   .arg(updated.toString("hh:mm:ss.zzz")).arg(value["quality"].toString()));
+    } else {
+        m_currentValueLabel->setText("--");
+        m_unitLabel->setText("");
+        m_updateTimeLabel->setText(realtime.message);
     }
 
+    // 统计取自最近1小时的历史数据
     QVariantMap data = result.data.toMap();
-
-    m_currentValueLabel->setText(QString::number(data["currentValue"].toDouble(), 'f', 1));
-    m_unitLabel->setText("℃");
-    m_updateTimeLabel->setText(QString("最后更新: %1").arg(data["updateTime"].toString()));
-
-    m_minValueLabel->setText(QString::number(data["minValue"].toDouble(), 'f', 1));
-    m_maxValueLabel->setText(QString::number(data["maxValue"].toDouble(), 'f', 1));
-    m_avgValueLabel->setText(QString::number(data["avgValue"].toDouble(), 'f', 1));
+    if (result.isSuccess() && data["sampleCount"].toLongLong() > 0) {
+        m_minValueLabel->setText(QString::number(data["minValue"].toDouble(), 'f', 1));
+        m_maxValueLabel->setText(QString::number(data["maxValue"].toDouble(), 'f', 1));
+        m_avgValueLabel->setText(QString::number(data["avgValue"].toDouble(), 'f', 1));
+    } else {
+        m_minValueLabel->setText("--");
+        m_maxValueLabel->setText("--");
+        m_avgValueLabel->setText("--");
+    }
+    m_chartLabel->setText(result.isSuccess()
+                          ? QString("趋势图\n（QChart占位）\n最近1小时 %1个样本").arg(data["sampleCount"].toLongLong())
+                          : QString("趋势图\n（QChart占位）\n%1").arg(result.message));
 }
@@ -11,10 +11,13 @@
 #include "../common/toast.h"
 #include "../service/deviceservice.h"
 #include "../service/modbusservice.h"
+#include "../service/acquisitionservice.h"
+#include "../service/registersnapshot.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QHeaderView>
+#include <QDateTime>
 
 MonitorPage::MonitorPage(QWidget *parent)
     : QWidget(parent)
@@ -26,21 +29,19 @@ MonitorPage::MonitorPage(QWidget *parent)
     , m_statusLed(nullptr)
     , m_statusLabel(nullptr)
     , m_table(nullptr)
-    , m_pollTimer(new QTimer(this))
     , m_isPolling(false)
     , m_currentDeviceId(-1)
+    , m_rowsFlagged(false)
 {
     setupUI();
     loadDevices();
 
-    connect(m_pollTimer, &QTimer::timeout, this, &MonitorPage::onPollTimer);
+    connect(AcquisitionService::instance(), &AcquisitionService::dataBatchUpdated,
+            this, &MonitorPage::onDataBatchUpdated);
 }
 
 MonitorPage::~MonitorPage()
 {
-    if (m_isPolling) {
-        ModbusService::stopPolling(m_currentDeviceId);
-    }
 }
 
 void MonitorPage::setupUI()
@@ -179,34 +180,44 @@ void MonitorPage::loadDevices()
 
 void MonitorPage::onDeviceChanged(int index)
 {
-    // Stop current polling if active
-    if (m_isPolling) {
-        setPollingState(false);
-    }
-
     m_currentDeviceId = m_deviceCombo->itemData(index).toInt();
     m_table->setRowCount(0);
+    m_layout.clear();
+    m_rowsFlagged = false;
 
     m_startStopBtn->setEnabled(m_currentDeviceId >= 0);
+
+    // 采集在后台按设备周期持续进行，切换设备只切换显示
+    updatePollingUi(m_currentDeviceId >= 0 && ModbusService::isPolling(m_currentDeviceId));
+    if (m_isPolling) {
+        updateData();
+    }
 }
 
 void MonitorPage::onStartStopClicked()
 {
-    if (m_isPolling) {
-        setPollingState(false);
+    setPollingState(!m_isPolling);
+}
+
+void MonitorPage::setPollingState(bool polling)
+{
+    if (polling) {
+        Result result = ModbusService::startPolling(m_currentDeviceId);
+        if (!result.isSuccess()) {
+            Toast::showError(this, result.message);
+            return;
+        }
     } else {
-        setPollingState(true);
-        updateData();  // Initial read
+        ModbusService::stopPolling(m_currentDeviceId);
     }
+    updatePollingUi(polling);
 }
 
-void MonitorPage::setPollingState(bool polling)
+void MonitorPage::updatePollingUi(bool polling)
 {
     m_isPolling = polling;
 
     if (polling) {
-        ModbusService::startPolling(m_currentDeviceId);
-        m_pollTimer->start(1000);
         m_startStopBtn->setText("停止");
         m_startStopBtn->setStyleSheet(
             "QPushButton { background-color: #ff4444; color: #ffffff; border: none; "
@@ -217,8 +228,6 @@ void MonitorPage::setPollingState(bool polling)
         m_statusLabel->setText("采集中");
         m_statusLabel->setStyleSheet("color: #00ff88; font-size: 11pt;");
     } else {
-        ModbusService::stopPolling(m_currentDeviceId);
-        m_pollTimer->stop();
         m_startStopBtn->setText("启动");
         m_startStopBtn->setStyleSheet(AppStyle::getButtonStyle(true));
         m_statusLed->setStyleSheet("background-color: #606060; border-radius: 8px;");
@@ -227,52 +236,110 @@ void MonitorPage::setPollingState(bool polling)
     }
 }
 
-void MonitorPage::onPollTimer()
+void MonitorPage::onDataBatchUpdated(const SnapshotBatchPtr &batch)
 {
-    updateData();
+    // 批中已带快照，不再按设备查询
+    if (!m_isPolling) return;
+    int index = batch->indexOf(m_currentDeviceId);
+    if (index < 0) return;
+
+    if (batch->errorCodes[index] != 0) {
+        showError();
+    } else {
+        showSnapshot(batch->snapshots[index]);
+    }
 }
 
 void MonitorPage::updateData()
 {
     if (m_currentDeviceId < 0) return;
 
-    Result result = ModbusService::readHoldingRegisters(m_currentDeviceId);
+    Result result = ModbusService::getLatestData(m_currentDeviceId);
     if (!result.isSuccess()) {
-        m_statusLed->setStyleSheet("background-color: #ff4444; border-radius: 8px;");
-        m_statusLabel->setText("错误");
-        m_statusLabel->setStyleSheet("color: #ff4444; font-size: 11pt;");
+        showError();
         return;
     }
+    showSnapshot(result.data.value<RegisterSnapshotPtr>());
+}
 
-    m_statusLed->setStyleSheet("background-color: #00ff88; border-radius: 8px;");
-    m_statusLabel->setText("正常");
-    m_statusLabel->setStyleSheet("color: #00ff88; font-size: 11pt;");
+void MonitorPage::showError()
+{
+    m_statusLed->setStyleSheet("background-color: #ff4444; border-radius: 8px;");
+    m_statusLabel->setText("错误");
+    m_statusLabel->setStyleSheet("color: #ff4444; font-size: 11pt;");
+}
 
-    QVariantList registers = result.data.toList();
-    m_table->setRowCount(registers.size());
+void MonitorPage::showSnapshot(const RegisterSnapshotPtr &snapshot)
+{
+    if (!snapshot) {
+        return;
+    }
 
-    for (int i = 0; i < registers.size(); ++i) {
-        QVariantMap reg = registers[i].toMap();
+    if (snapshot->stale.any()) {
+        m_statusLed->setStyleSheet("background-color: #ffaa00; border-radius: 8px;");
+        m_statusLabel->setText("数据过期");
+        m_statusLabel->setStyleSheet("color: #ffaa00; font-size: 11pt;");
+    } else {
+        m_statusLed->setStyleSheet("background-color: #00ff88; border-radius: 8px;");
+        m_statusLabel->setText("正常");
+        m_statusLabel->setStyleSheet("color: #00ff88; font-size: 11pt;");
+    }
 
-        QTableWidgetItem *addrItem = new QTableWidgetItem(QString::number(reg["address"].toInt()));
-        addrItem->setTextAlignment(Qt::AlignCenter);
-        addrItem->setData(Qt::UserRole, reg["address"]);
-        m_table->setItem(i, 0, addrItem);
+    // 布局不变时只更新数值和时间，不重建表格项
+    int rows = snapshot->size();
+    if (m_table->rowCount() != rows || snapshot->layout != m_layout) {
+        m_layout = snapshot->layout;
+        m_rowsFlagged = false;
+        m_table->setRowCount(rows);
+        for (int i = 0; i < rows; ++i) {
+            QTableWidgetItem *addrItem = new QTableWidgetItem(QString::number(snapshot->address(i)));
+            addrItem->setTextAlignment(Qt::AlignCenter);
+            addrItem->setData(Qt::UserRole, snapshot->address(i));
+            m_table->setItem(i, 0, addrItem);
+
+            m_table->setItem(i, 1, new QTableWidgetItem(snapshot->name(i)));
+
+            QTableWidgetItem *valueItem = new QTableWidgetItem();
+            valueItem->setTextAlignment(Qt::AlignCenter);
+            valueItem->setForeground(QColor("#00ff88"));
+            m_table->setItem(i, 2, valueItem);
+
+            QTableWidgetItem *timeItem = new QTableWidgetItem();
+            timeItem->setTextAlignment(Qt::AlignCenter);
+            timeItem->setForeground(QColor("#a0a0a0"));
+            m_table->setItem(i, 3, timeItem);
+        }
+    }
 
-        QTableWidgetItem *nameItem = new QTableWidgetItem(reg["name"].toString());
-        m_table->setItem(i, 1, nameItem);
+    // 时间戳只在显示时格式化，同一秒内的值共用一个字符串
+    qint64 lastSecond = -1;
+    QString timeText;
+    for (int i = 0; i < rows; ++i) {
+        m_table->item(i, 2)->setText(QString("%1 %2").arg(snapshot->values[i], 0, 'g', 7).arg(snapshot->unit(i)));
 
-        QString valueStr = QString("%1 %2").arg(reg["value"].toInt()).arg(reg["unit"].toString());
-        QTableWidgetItem *valueItem = new QTableWidgetItem(valueStr);
-        valueItem->setTextAlignment(Qt::AlignCenter);
-        valueItem->setForeground(QColor("#00ff88"));
-        m_table->setItem(i, 2, valueItem);
+        qint64 second = snapshot->timestampsNs[i] / 1000000000;
+        if (second != lastSecond) {
+            lastSecond = second;
+            timeText = QDateTime::fromMSecsSinceEpoch(second * 1000).toString("hh:mm:ss");
+        }
+        m_table->item(i, 3)->setText(timeText);
+    }
 
-        QTableWidgetItem *timeItem = new QTableWidgetItem(reg["updateTime"].toString());
-        timeItem->setTextAlignment(Qt::AlignCenter);
-        timeItem->setForeground(QColor("#a0a0a0"));
-        m_table->setItem(i, 3, timeItem);
+    // 标志按位集整字判断：没有任何标志且上次也没有时不逐行着色
+    bool flagged = snapshot->anyFlags();
+    if (flagged || m_rowsFlagged) {
+        PointBitset grey = snapshot->stale | snapshot->bad | snapshot->commLost;
+        for (int i = 0; i < rows; ++i) {
+            QColor color("#00ff88");
+            if (grey.test(i)) {
+                color = QColor("#606060");
+            } else if (snapshot->outOfRange.test(i)) {
+                color = QColor("#ffaa00");
+            }
+            m_table->item(i, 2)->setForeground(color);
+        }
     }
+    m_rowsFlagged = flagged;
 }
 
 void MonitorPage::onTableDoubleClicked(int row, int column)
@@ -3,18 +3,21 @@
  * @brief 实时监控页面定义
  *
  * 本文件定义了实时监控页面，用于显示选定设备的实时数据，
- * 支持启动/停止轮询采集、显示通信状态等功能。
+ * 支持启动/停止轮询采集、显示通信状态等功能。采集由AcquisitionService
+ * 按设备的轮询间隔驱动，本页面只在数据更新时刷新表格。
  */
 
 #ifndef MONITORPAGE_H
 #define MONITORPAGE_H
 
+#include "../service/registersnapshot.h"
+
 #include <QWidget>
 #include <QTableWidget>
 #include <QPushButton>
 #include <QComboBox>
 #include <QLabel>
-#include <QTimer>
+#include <QSharedPointer>
 
 /**
  * @class MonitorPage
@@ -37,7 +40,7 @@ signals:
 private slots:
     void onDeviceChanged(int index);
     void onStartStopClicked();
-    void onPollTimer();
+    void onDataBatchUpdated(const SnapshotBatchPtr &batch);
     void onTableDoubleClicked(int row, int column);
 
 private:
@@ -47,7 +50,10 @@ private:
     void setupTable();
     void loadDevices();
     void updateData();
+    void showSnapshot(const RegisterSnapshotPtr &snapshot);
+    void showError();
     void setPollingState(bool polling);
+    void updatePollingUi(bool polling);
 
     // 标题栏
     QWidget *m_titleBar;        ///< 标题栏容器
@@ -62,9 +68,10 @@ private:
 
     // 数据表格
     QTableWidget *m_table;      ///< 数据表格
+    QSharedPointer<const RegisterLayout> m_layout;  ///< 表格当前显示的地址/名称布局
+    bool m_rowsFlagged;         ///< 表格中是否有按标志着色的行
 
-    // 定时器和状态
-    QTimer *m_pollTimer;        ///< 轮询定时器
+    // 状态
     bool m_isPolling;           ///< 是否正在轮询
     int m_currentDeviceId;      ///< 当前选中的设备ID
 };
@@ -0,0 +1,412 @@
+/**
+ * @file acquisitionservice.cpp
+ * @brief 数据采集服务实现
+ *
+ * 本文件实现了采集线程的管理：按设备所在总线创建BusWorker，把设备的增删
+ * 转交给对应线程，并在界面线程中取出各线程的结果队列、更新缓存和发出通知。
+ */
+
+#include "acquisitionservice.h"
+#include "alarmservice.h"
+#include "alloccounter.h"
+#include "busworker.h"
+#include "commandqueue.h"
+#include "databaseservice.h"
+#include "deviceservice.h"
+#include "eventbus.h"
+#include "readplanner.h"
+#include "systemservice.h"
+
+AcquisitionService *AcquisitionService::instance()
+{
+    static AcquisitionService s_instance;
+    return &s_instance;
+}
+
+AcquisitionService::AcquisitionService(QObject *parent)
+    : QObject(parent)
+    , m_onlineCount(0)
+{
+}
+
+AcquisitionService::~AcquisitionService()
+{
+    shutdown();
+}
+
+void AcquisitionService::start()
+{
+    Result result = DeviceService::getDeviceList();
+    if (!result.isSuccess()) {
+        return;
+    }
+
+    for (const QVariant &v : result.data.toList()) {
+        QVariantMap dev = v.toMap();
+        if (dev.value("enabled", true).toBool()) {
+            addDevice(dev["id"].toInt());
+        }
+    }
+}
+
+void AcquisitionService::shutdown()
+{
+    for (BusWorker *worker : m_workers) {
+        worker->stop();
+        delete worker;
+    }
+    m_workers.clear();
+
+    // 随采集线程丢弃的写命令
+    for (auto it = m_openCommands.constBegin(); it != m_openCommands.constEnd(); ++it) {
+        CommandQueue::updateStatus(it.key(), CommandQueue::Failed, 0, "通信服务已重启，命令未执行完");
+        emit commandUpdated(it.key());
+    }
+    m_openCommands.clear();
+}
+
+Result AcquisitionService::restart()
+{
+    QList<int> devices = m_deviceBus.keys();
+    shutdown();
+    m_deviceBus.clear();
+
+    for (int deviceId : devices) {
+        addDevice(deviceId);
+    }
+
+    // 默认总线即使没有设备也要打开，以便返回串口状态
+    BusWorker *worker = busWorker(QString());
+    Result result = worker->waitOpened(responseTimeout() + 1000);
+    for (BusWorker *w : m_workers) {
+        if (w != worker && result.isSuccess()) {
+            result = w->waitOpened(responseTimeout() + 1000);
+        }
+    }
+    return result;
+}
+
+BusWorker *AcquisitionService::busWorker(const QString &busPort)
+{
+    SerialConfig serial = SystemService::serialConfigFor(busPort);
+    BusWorker *worker = m_workers.value(serial.port);
+    if (!worker) {
+        worker = new BusWorker(serial);
+        connect(worker, &BusWorker::resultsReady, this, &AcquisitionService::onResultsReady);
+        connect(worker, &BusWorker::commandStatusChanged, this, &AcquisitionService::onCommandStatusChanged);
+        m_workers.insert(serial.port, worker);
+        worker->start();
+    }
+    worker->setResponseTimeout(responseTimeout());
+    return worker;
+}
+
+int AcquisitionService::responseTimeout() const
+{
+    return AlarmService::currentRules().commTimeout;
+}
+
+Result AcquisitionService::addDevice(int deviceId)
+{
+    DeviceConfig cfg;
+    if (!DeviceService::getDeviceConfig(deviceId, cfg)) {
+        return Result::error(404, "设备不存在");
+    }
+
+    BusWorker *worker = busWorker(cfg.busPort);
+    auto it = m_deviceBus.constFind(deviceId);
+    if (it != m_deviceBus.constEnd() && *it != worker->busName()) {
+        BusWorker *old = m_workers.value(*it);
+        if (old) {
+            old->removeDevice(deviceId);    // 设备换了总线
+        }
+    }
+    worker->addDevice(cfg);
+    m_deviceBus.insert(deviceId, worker->busName());
+    publishCommRate();
+
+    QVector<RegisterPoint> points = ReadPlanner::devicePoints(cfg);
+    m_transactions.insert(deviceId, qMakePair(points.size(),
+                                              ReadPlanner::plan(points, cfg.gapThreshold).size()));
+    return Result::success();
+}
+
+void AcquisitionService::removeDevice(int deviceId)
+{
+    BusWorker *worker = m_workers.value(m_deviceBus.take(deviceId));
+    if (worker) {
+        worker->removeDevice(deviceId);
+    }
+    m_latest.remove(deviceId);
+    m_transactions.remove(deviceId);
+    if (m_online.take(deviceId)) {
+        m_onlineCount--;
+    }
+    publishCommRate();
+}
+
+bool AcquisitionService::isPolling(int deviceId) const
+{
+    return m_deviceBus.contains(deviceId);
+}
+
+Result AcquisitionService::readOnce(const DeviceConfig &cfg)
+{
+    BusWorker *worker = busWorker(cfg.busPort);
+
+    // 最坏情况：等待总线上正在进行的一次采集，再完成本次的所有读请求
+    int blocks = ReadPlanner::plan(ReadPlanner::devicePoints(cfg), cfg.gapThreshold).size();
+    return worker->readOnce(cfg, responseTimeout() * (blocks + 8) + 1000);
+}
+
+Result AcquisitionService::submitWrite(const DeviceConfig &cfg, const WriteRequest &request)
+{
+    QVariantList values;
+    for (quint16 v : request.values) {
+        values << v;
+    }
+    QVariantMap payload;
+    payload["address"] = request.address;
+    payload["values"] = values;
+
+    // 写线圈是控制命令，写寄存器是参数配置
+    WriteRequest cmd = request;
+    cmd.deviceId = cfg.id;
+    cmd.slave = cfg.modbusAddress;
+    cmd.commandId = CommandQueue::enqueue(request.coils ? "control" : "write_config", cfg.id, payload);
+
+    BusWorker *worker = busWorker(cfg.busPort);
+    m_openCommands.insert(cmd.commandId, worker->busName());
+    worker->submitWrite(cmd);
+
+    QVariantMap data;
+    data["commandId"] = cmd.commandId;
+    return Result::success(data);
+}
+
+void AcquisitionService::onCommandStatusChanged(qint64 commandId, int status, int attempts, const QString &error)
+{
+    if (!m_openCommands.contains(commandId)) {
+        return;     // 已按重启处理
+    }
+    if (status == CommandQueue::Acked || status == CommandQueue::Failed) {
+        m_openCommands.remove(commandId);
+    }
+    CommandQueue::updateStatus(commandId, static_cast<CommandQueue::Status>(status), attempts, error);
+    emit commandUpdated(commandId);
+}
+
+Result AcquisitionService::latestData(int deviceId) const
+{
+    auto it = m_latest.constFind(deviceId);
+    if (it == m_latest.constEnd()) {
+        return Result::error(1, "暂无采集数据");
+    }
+    return *it;
+}
+
+SnapshotBatchPtr AcquisitionService::latestBatch(const QVector<int> &deviceIds) const
+{
+    QSharedPointer<SnapshotBatch> batch = QSharedPointer<SnapshotBatch>::create();
+    const QVector<int> ids = deviceIds.isEmpty() ? m_deviceBus.keys().toVector() : deviceIds;
+    batch->reserve(ids.size());
+    for (int deviceId : ids) {
+        auto it = m_latest.constFind(deviceId);
+        if (it == m_latest.constEnd()) {
+            continue;
+        }
+        if (it->isSuccess()) {
+            batch->append(deviceId, it->data.value<RegisterSnapshotPtr>());
+        } else {
+            batch->append(deviceId, RegisterSnapshotPtr(), it->code, it->message);
+        }
+    }
+    return batch;
+}
+
+void AcquisitionService::onResultsReady()
+{
+    BusWorker *worker = qobject_cast<BusWorker *>(sender());
+    if (!worker) {
+        return;
+    }
+
+    // 一次取空队列，合成一批只通知一次；同一设备在通知批中只保留最新结果。
+    // 各快照的changed只列出相对上一个快照超出死区的值，早先的快照被覆盖后这些变化
+    // 不会再出现，所以入库批保留每一个快照
+    QSharedPointer<SnapshotBatch> batch = QSharedPointer<SnapshotBatch>::create();
+    QSharedPointer<SnapshotBatch> persisted = QSharedPointer<SnapshotBatch>::create();
+    QHash<int, int> indexes;
+    PollResult item;
+    while (worker->takeResult(item)) {
+        // 已移出调度的设备可能还有在途结果，丢弃
+        if (m_deviceBus.value(item.deviceId) != worker->busName()) {
+            continue;
+        }
+        m_latest.insert(item.deviceId, item.result);
+        updateOnline(item.deviceId, item.result.isSuccess());
+
+        RegisterSnapshotPtr snapshot;
+        QString error;
+        if (item.result.isSuccess()) {
+            snapshot = item.result.data.value<RegisterSnapshotPtr>();
+            persisted->append(item.deviceId, snapshot);
+        } else {
+            error = item.result.message;
+        }
+        auto index = indexes.constFind(item.deviceId);
+        if (index == indexes.constEnd()) {
+            indexes.insert(item.deviceId, batch->size());
+            batch->append(item.deviceId, snapshot, item.result.code, error);
+        } else {
+            batch->snapshots[*index] = snapshot;
+            batch->errorCodes[*index] = item.result.code;
+            batch->errorMessages[*index] = error;
+        }
+    }
+
+    if (persisted->size() > 0) {
+        DatabaseService::submitBatch(persisted);
+    }
+    if (batch->size() > 0) {
+        emit dataBatchUpdated(batch);
+    }
+}
+
+void AcquisitionService::updateOnline(int deviceId, bool online)
+{
+    // 采集线程保证通信恢复后的第一轮一定入队，这里能看到每一次上下线切换
+    auto it = m_online.constFind(deviceId);
+    bool known = it != m_online.constEnd();
+    if (known && *it == online) {
+        return;
+    }
+    if (online) {
+        m_onlineCount++;
+    } else if (known) {
+        m_onlineCount--;
+    }
+    m_online.insert(deviceId, online);
+    DeviceService::setDeviceOnline(deviceId, online);
+    publishCommRate();
+}
+
+void AcquisitionService::publishCommRate()
+{
+    int polled = m_deviceBus.size();
+    EventBus::instance()->publishCommRate(polled > 0 ? m_onlineCount * 100 / polled : -1);
+}
+
+Result AcquisitionService::pollingStats() const
+{
+    qint64 totalRuns = 0;
+    qint64 totalOverruns = 0;
+    int transactionsBefore = 0;
+    int transactionsAfter = 0;
+    int deviceCount = 0;
+    double maxUtilization = 0.0;
+
+    QVariantList devices;
+    QVariantList buses;
+    for (BusWorker *worker : m_workers) {
+        QList<PollingStats> all = worker->pollingStats();
+        QHash<int, LinkStats> links;
+        for (const LinkStats &l : worker->linkStats()) {
+            links.insert(l.deviceId, l);
+        }
+        double utilization = worker->utilization();
+        maxUtilization = qMax(maxUtilization, utilization);
+        deviceCount += all.size();
+
+        QVariantMap bus;
+        bus["port"] = worker->busName();
+        bus["simulated"] = worker->isSimulated();
+        bus["deviceCount"] = all.size();
+        bus["utilization"] = qRound(utilization * 1000) / 10.0;   // 百分比，保留1位
+        bus["droppedResults"] = worker->droppedResults();
+
+        QVariantList classes;
+        for (const PriorityClassStats &c : worker->classStats()) {
+            QVariantMap cls;
+            cls["priority"] = c.priority;
+            cls["name"] = PollingScheduler::priorityName(c.priority);
+            cls["deviceCount"] = c.deviceCount;
+            cls["demand"] = qRound(c.demand * 1000) / 10.0;        // 百分比，保留1位
+            cls["stretch"] = qRound(c.stretch * 100) / 100.0;
+            cls["configuredIntervalMs"] = qRound(c.configuredIntervalMs);
+            cls["achievedIntervalMs"] = qRound(c.achievedIntervalMs);
+            classes.append(cls);
+        }
+        bus["classes"] = classes;
+        if (AllocCounter::isEnabled()) {
+            bus["steadyAllocCycles"] = worker->steadyAllocCycles();
+            bus["steadyAllocations"] = worker->steadyAllocations();
+        }
+
+        PipelineStats pipeline = worker->pipelineStats();
+        QVariantList stages;
+        for (const PipelineStageStats &st : pipeline.stages) {
+            QVariantMap stage;
+            stage["name"] = st.name;
+            stage["frames"] = st.frames;
+            stage["dropped"] = st.dropped;
+            stage["avgUs"] = st.frames > 0 ? qRound64(st.totalNs / 1000.0 / st.frames * 10) / 10.0 : 0.0;
+            stage["maxUs"] = qRound64(st.maxNs / 100.0) / 10.0;
+            stages.append(stage);
+        }
+        QVariantMap pipelineMap;
+        pipelineMap["valuesIn"] = pipeline.valuesIn;
+        pipelineMap["valuesChanged"] = pipeline.valuesChanged;
+        pipelineMap["stages"] = stages;
+        bus["pipeline"] = pipelineMap;
+        buses.append(bus);
+
+        for (const PollingStats &s : all) {
+            QVariantMap dev;
+            dev["deviceId"] = s.deviceId;
+            dev["bus"] = worker->busName();
+            dev["intervalMs"] = s.intervalMs;
+            dev["priority"] = s.priority;
+            dev["effectiveIntervalMs"] = s.effectiveIntervalMs;
+            dev["achievedIntervalMs"] = s.periods > 0 ? s.totalPeriodUs / 1000.0 / s.periods : 0.0;
+            dev["runs"] = s.runs;
+            dev["overruns"] = s.overruns;
+            dev["skipped"] = s.skipped;
+            dev["avgJitterMs"] = s.runs > 0 ? s.totalJitterUs / 1000.0 / s.runs : 0.0;
+            dev["maxJitterMs"] = s.maxJitterUs / 1000.0;
+            dev["avgDurationMs"] = s.runs > 0 ? s.totalDurationUs / 1000.0 / s.runs : 0.0;
+            dev["maxDurationMs"] = s.maxDurationUs / 1000.0;
+
+            LinkStats link = links.value(s.deviceId);
+            dev["rttSamples"] = link.samples;
+            dev["rttP50Ms"] = link.p50Us / 1000.0;
+            dev["rttP90Ms"] = link.p90Us / 1000.0;
+            dev["rttP99Ms"] = link.p99Us / 1000.0;
+            dev["timeoutMs"] = link.samples > 0 ? link.timeoutMs : responseTimeout();
+            dev["consecutiveFailures"] = link.consecutiveFailures;
+            dev["backoffMs"] = link.backoffMs;
+
+            QPair<int, int> transactions = m_transactions.value(s.deviceId);
+            dev["transactionsBefore"] = transactions.first;
+            dev["transactionsAfter"] = transactions.second;
+            transactionsBefore += transactions.first;
+            transactionsAfter += transactions.second;
+            devices.append(dev);
+
+            totalRuns += s.runs;
+            totalOverruns += s.overruns;
+        }
+    }
+
+    QVariantMap stats;
+    stats["deviceCount"] = deviceCount;
+    stats["totalRuns"] = totalRuns;
+    stats["totalOverruns"] = totalOverruns;
+    stats["transactionsBefore"] = transactionsBefore;   // 每周期事务数（不合并）
+    stats["transactionsAfter"] = transactionsAfter;     // 每周期事务数（合并后）
+    stats["utilization"] = qRound(maxUtilization * 1000) / 10.0;   // 最繁忙总线的占用率
+    stats["buses"] = buses;
+    stats["devices"] = devices;
+
+    return Result::success(stats);
+}
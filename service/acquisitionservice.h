@@ -0,0 +1,155 @@
+/**
+ * @file acquisitionservice.h
+ * @brief 数据采集服务定义
+ *
+ * 本文件定义了数据采集服务，它为每个RS485总线启动一个BusWorker采集线程，
+ * 把启用设备分配到各自总线上按pollInterval周期采集，在界面线程缓存每个设备
+ * 最近一次的采集结果，并在数据更新时通知界面。写命令登记到CommandQueue后
+ * 转交设备所在总线的采集线程执行，状态变化时同步更新命令队列。设备上下线
+ * 和通信正常率的变化推送到EventBus。
+ */
+
+#ifndef ACQUISITIONSERVICE_H
+#define ACQUISITIONSERVICE_H
+
+#include "../common/result.h"
+#include "registersnapshot.h"
+
+#include <QObject>
+#include <QHash>
+#include <QPair>
+
+class BusWorker;
+struct DeviceConfig;
+struct WriteRequest;
+
+/**
+ * @class AcquisitionService
+ * @brief 数据采集服务类（单例，界面线程使用）
+ *
+ * 总线访问全部在采集线程中进行，界面线程只处理结果队列和统计查询。
+ */
+class AcquisitionService : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 获取单例
+     */
+    static AcquisitionService *instance();
+
+    /**
+     * @brief 将所有启用的设备加入调度并开始采集
+     */
+    void start();
+
+    /**
+     * @brief 停止并销毁所有采集线程（程序退出前调用）
+     */
+    void shutdown();
+
+    /**
+     * @brief 按当前串口配置重建所有采集线程，原调度中的设备重新加入
+     * @return Result 成功表示所有总线都打开了真实串口，失败时包含串口错误信息
+     */
+    Result restart();
+
+    /**
+     * @brief 按设备当前配置加入调度（已在调度中时更新间隔和采集任务）
+     * @param deviceId 设备ID
+     * @return Result 操作结果
+     */
+    Result addDevice(int deviceId);
+
+    /**
+     * @brief 将设备移出调度
+     * @param deviceId 设备ID
+     */
+    void removeDevice(int deviceId);
+
+    /**
+     * @brief 判断设备是否在调度中
+     */
+    bool isPolling(int deviceId) const;
+
+    /**
+     * @brief 获取总线的采集线程，不存在时创建并启动
+     * @param busPort 串口名称，为空表示默认总线
+     * @return BusWorker* 采集线程（restart()或shutdown()后失效）
+     */
+    BusWorker *busWorker(const QString &busPort = QString());
+
+    /**
+     * @brief 在设备所在总线的采集线程中读取一次（阻塞到读取完成或超时）
+     * @param cfg 设备配置
+     * @return Result 成功时data为RegisterSnapshotPtr
+     */
+    Result readOnce(const DeviceConfig &cfg);
+
+    /**
+     * @brief 登记写命令并交给设备所在总线的采集线程（不阻塞）
+     * @param cfg 设备配置
+     * @param request 写命令（commandId、deviceId和slave由本函数填写）
+     * @return Result 包含命令ID
+     */
+    Result submitWrite(const DeviceConfig &cfg, const WriteRequest &request);
+
+    /**
+     * @brief 获取设备最近一次的采集结果
+     * @param deviceId 设备ID
+     * @return Result 最近一次采集结果，尚未采集时返回错误
+     */
+    Result latestData(int deviceId) const;
+
+    /**
+     * @brief 一次获取多个设备最近一次的采集结果
+     * @param deviceIds 设备ID列表，为空表示所有调度中的设备；尚未采集的设备不在结果中
+     * @return SnapshotBatchPtr 按请求顺序排列的结果批
+     */
+    SnapshotBatchPtr latestBatch(const QVector<int> &deviceIds = QVector<int>()) const;
+
+    /**
+     * @brief 获取调度统计
+     * @return Result 包含每设备抖动/超期/耗时、往返时间分位数、自适应超时和退避状态、
+     *         合并前后每周期事务数、每设备优先级与配置/拉长后/实际间隔、各总线占用率、
+     *         各总线每个优先级的需求和拉长倍数（classes）以及各总线流水线每级耗时（pipeline）；
+     *         以ALLOC_COUNTER构建时各总线还有稳态分配统计（steadyAllocCycles/steadyAllocations）
+     */
+    Result pollingStats() const;
+
+signals:
+    /**
+     * @brief 一个总线完成一批采集（每次取空结果队列发出一次，而不是每个设备一次）
+     * @param batch 本批中各设备的最新结果，同一设备只出现一次
+     */
+    void dataBatchUpdated(const SnapshotBatchPtr &batch);
+
+    /**
+     * @brief 写命令状态变化（已更新到CommandQueue）
+     * @param commandId 命令ID
+     */
+    void commandUpdated(qint64 commandId);
+
+private slots:
+    void onResultsReady();
+    void onCommandStatusChanged(qint64 commandId, int status, int attempts, const QString &error);
+
+private:
+    explicit AcquisitionService(QObject *parent = nullptr);
+    ~AcquisitionService() override;
+
+    int responseTimeout() const;
+    void updateOnline(int deviceId, bool online);
+    void publishCommRate();
+
+    QHash<QString, BusWorker *> m_workers;      ///< 串口名称 → 采集线程
+    QHash<int, QString> m_deviceBus;            ///< 调度中的设备ID → 所在总线
+    QHash<int, Result> m_latest;                ///< 设备ID → 最近一次采集结果
+    QHash<int, QPair<int, int>> m_transactions; ///< 设备ID → 合并前/后每周期事务数
+    QHash<qint64, QString> m_openCommands;      ///< 未完成的命令ID → 所在总线
+    QHash<int, bool> m_online;                  ///< 调度中的设备ID → 最近一次采集是否成功
+    int m_onlineCount;                          ///< m_online中在线的设备数
+};
+
+#endif // ACQUISITIONSERVICE_H
@@ -3,11 +3,16 @@
  * @brief 告警服务实现
  *
  * 本文件实现了告警管理服务的所有功能，包括告警列表查询、
- * 确认、清除、规则配置等。当前为模拟数据，实际部署时需替换为真实数据存储。
+ * 确认、清除、规则配置等。告警列表当前为模拟数据；告警规则保存在数据库的config表中。
  */
 
 #include "alarmservice.h"
+#include "databaseservice.h"
+#include "eventbus.h"
+#include "pollingscheduler.h"
+
 #include <QDateTime>
+#include <QJsonDocument>
 
 // 静态模拟告警列表
 static QVariantList s_alarmList;
@@ -15,6 +20,14 @@ static int s_nextAlarmId = 1;
 static bool s_alarmInitialized = false;
 static AlarmRules s_alarmRules;
 
+/**
+ * @brief 模拟告警时间转换为纳秒时间戳
+ */
+static qint64 mockTimeNs(const QString &text)
+{
+    return QDateTime::fromString(text, "yyyy-MM-dd hh:mm:ss").toMSecsSinceEpoch() * 1000000;
+}
+
 /**
  * @brief 初始化模拟告警数据
  */
@@ -26,7 +39,7 @@ static void initAlarmMockData()
     // 添加模拟告警
     QVariantMap alarm1;
     alarm1["id"] = s_nextAlarmId++;
-    alarm1["time"] = "2024-01-15 09:30:15";
+    alarm1["timeNs"] = mockTimeNs("2024-01-15 09:30:15");
     alarm1["device"] = "温度传感器";
     alarm1["type"] = "超上限";
     alarm1["level"] = "警告";
@@ -37,7 +50,7 @@ static void initAlarmMockData()
 
     QVariantMap alarm2;
     alarm2["id"] = s_nextAlarmId++;
-    alarm2["time"] = "2024-01-15 08:45:22";
+    alarm2["timeNs"] = mockTimeNs("2024-01-15 08:45:22");
     alarm2["device"] = "流量计";
     alarm2["type"] = "通信失败";
     alarm2["level"] = "错误";
@@ -48,7 +61,7 @@ static void initAlarmMockData()
 
     QVariantMap alarm3;
     alarm3["id"] = s_nextAlarmId++;
-    alarm3["time"] = "2024-01-15 07:20:00";
+    alarm3["timeNs"] = mockTimeNs("2024-01-15 07:20:00");
     alarm3["device"] = "压力表";
     alarm3["type"] = "低于下限";
     alarm3["level"] = "警告";
@@ -56,6 +69,46 @@ static void initAlarmMockData()
     alarm3["acknowledged"] = true;
     alarm3["status"] = "已确认";
     s_alarmList.append(alarm3);
+
+    int active = 0;
+    for (const QVariant &v : s_alarmList) {
+        if (!v.toMap()["acknowledged"].toBool()) {
+            active++;
+        }
+    }
+    EventBus::instance()->publishAlarmDelta(active, s_alarmList.size());
+}
+
+/**
+ * @brief 告警规则转换为键值表（界面和数据库共用）
+ */
+static QVariantMap rulesToMap(const AlarmRules &r)
+{
+    QVariantMap rules;
+    rules["commTimeout"] = r.commTimeout;
+    rules["highLimit"] = r.highLimit;
+    rules["lowLimit"] = r.lowLimit;
+    rules["duration"] = r.duration;
+    rules["enableCommAlarm"] = r.enableCommAlarm;
+    rules["enableLimitAlarm"] = r.enableLimitAlarm;
+    return rules;
+}
+
+void AlarmService::initialize()
+{
+    initAlarmMockData();
+
+    // 恢复上次保存的规则，缺少的字段保留默认值
+    Result saved = DatabaseService::readConfig("alarm_rules");
+    if (saved.isSuccess()) {
+        QVariantMap rules = QJsonDocument::fromJson(saved.data.toString().toUtf8()).toVariant().toMap();
+        s_alarmRules.commTimeout = rules.value("commTimeout", s_alarmRules.commTimeout).toInt();
+        s_alarmRules.highLimit = rules.value("highLimit", s_alarmRules.highLimit).toDouble();
+        s_alarmRules.lowLimit = rules.value("lowLimit", s_alarmRules.lowLimit).toDouble();
+        s_alarmRules.duration = rules.value("duration", s_alarmRules.duration).toInt();
+        s_alarmRules.enableCommAlarm = rules.value("enableCommAlarm", s_alarmRules.enableCommAlarm).toBool();
+        s_alarmRules.enableLimitAlarm = rules.value("enableLimitAlarm", s_alarmRules.enableLimitAlarm).toBool();
+    }
 }
 
 Result AlarmService::getAlarmList()
@@ -71,10 +124,12 @@ Result AlarmService::ackAlarm(int alarmId)
     for (int i = 0; i < s_alarmList.size(); ++i) {
         QVariantMap alarm = s_alarmList[i].toMap();
         if (alarm["id"].toInt() == alarmId) {
+            bool wasActive = !alarm["acknowledged"].toBool();
             alarm["acknowledged"] = true;
             alarm["status"] = "已确认";
-            alarm["ackTime"] = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss");
+            alarm["ackTimeNs"] = PollingScheduler::wallClockNs();
             s_alarmList[i] = alarm;
+            EventBus::instance()->publishAlarmDelta(wasActive ? -1 : 0, 0);
             return Result::success();
         }
     }
@@ -86,8 +141,11 @@ Result AlarmService::clearAlarm(int alarmId)
     initAlarmMockData();
 
     for (int i = 0; i < s_alarmList.size(); ++i) {
-        if (s_alarmList[i].toMap()["id"].toInt() == alarmId) {
+        QVariantMap alarm = s_alarmList[i].toMap();
+        if (alarm["id"].toInt() == alarmId) {
+            bool wasActive = !alarm["acknowledged"].toBool();
             s_alarmList.removeAt(i);
+            EventBus::instance()->publishAlarmDelta(wasActive ? -1 : 0, -1);
             return Result::success();
         }
     }
@@ -96,19 +154,18 @@ Result AlarmService::clearAlarm(int alarmId)
 
 Result AlarmService::loadAlarmRules()
 {
-    QVariantMap rules;
-    rules["commTimeout"] = s_alarmRules.commTimeout;
-    rules["highLimit"] = s_alarmRules.highLimit;
-    rules["lowLimit"] = s_alarmRules.lowLimit;
-    rules["duration"] = s_alarmRules.duration;
-    rules["enableCommAlarm"] = s_alarmRules.enableCommAlarm;
-    rules["enableLimitAlarm"] = s_alarmRules.enableLimitAlarm;
-
-    return Result::success(rules);
+    return Result::success(rulesToMap(s_alarmRules));
 }
 
 Result AlarmService::saveAlarmRules(const AlarmRules &rules)
 {
     s_alarmRules = rules;
+    QJsonDocument json = QJsonDocument::fromVariant(rulesToMap(rules));
+    DatabaseService::writeConfig("alarm_rules", QString::fromUtf8(json.toJson(QJsonDocument::Compact)));
     return Result::success();
 }
+
+AlarmRules AlarmService::currentRules()
+{
+    return s_alarmRules;
+}
@@ -3,7 +3,7 @@
  * @brief 告警服务定义
  *
  * 本文件定义了告警管理相关的服务接口，包括告警列表查询、
- * 告警确认、告警清除、告警规则配置等功能。
+ * 告警确认、告警清除、告警规则配置等功能。告警数量的变化推送到EventBus。
  */
 
 #ifndef ALARMSERVICE_H
@@ -37,9 +37,14 @@ struct AlarmRules {
 class AlarmService
 {
 public:
+    /**
+     * @brief 加载告警数据、从数据库恢复告警规则，并向EventBus发布初始告警数量
+     */
+    static void initialize();
+
     /**
      * @brief 获取所有告警列表
-     * @return Result 包含告警列表数据
+     * @return Result 包含告警列表数据，时间字段timeNs、ackTimeNs为自1970年起的纳秒数
      */
     static Result getAlarmList();
 
@@ -64,11 +69,17 @@ public:
     static Result loadAlarmRules();
 
     /**
-     * @brief 保存告警规则配置
+     * @brief 保存告警规则配置（异步写入数据库config表的alarm_rules项）
      * @param rules 告警规则
      * @return Result 保存结果
      */
     static Result saveAlarmRules(const AlarmRules &rules);
+
+    /**
+     * @brief 获取当前生效的告警规则（供采集链路读取超时等参数）
+     * @return AlarmRules 当前告警规则
+     */
+    static AlarmRules currentRules();
 };
 
 #endif // ALARMSERVICE_H
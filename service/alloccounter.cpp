@@ -0,0 +1,84 @@
+/**
+ * @file alloccounter.cpp
+ * @brief 堆分配计数器实现
+ *
+ * 启用时在可执行文件中定义malloc等函数，覆盖libc中的同名符号，计数后转调
+ * glibc的__libc_*实现。计数器是可执行文件中的线程局部变量（静态TLS），访问时不会再分配内存。
+ */
+
+#include "alloccounter.h"
+
+#ifdef ALLOC_COUNTER
+
+#include <cerrno>
+#include <cstddef>
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+}
+
+static __thread quint64 t_allocations = 0;
+
+extern "C" void *malloc(size_t size) noexcept
+{
+    ++t_allocations;
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) noexcept
+{
+    ++t_allocations;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) noexcept
+{
+    ++t_allocations;
+    return __libc_realloc(ptr, size);
+}
+
+extern "C" void *memalign(size_t alignment, size_t size) noexcept
+{
+    ++t_allocations;
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" void *aligned_alloc(size_t alignment, size_t size) noexcept
+{
+    ++t_allocations;
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" int posix_memalign(void **ptr, size_t alignment, size_t size) noexcept
+{
+    ++t_allocations;
+    *ptr = __libc_memalign(alignment, size);
+    return *ptr ? 0 : ENOMEM;
+}
+
+bool AllocCounter::isEnabled()
+{
+    return true;
+}
+
+quint64 AllocCounter::threadCount()
+{
+    return t_allocations;
+}
+
+#else
+
+bool AllocCounter::isEnabled()
+{
+    return false;
+}
+
+quint64 AllocCounter::threadCount()
+{
+    return 0;
+}
+
+#endif
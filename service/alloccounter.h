@@ -0,0 +1,36 @@
+/**
+ * @file alloccounter.h
+ * @brief 堆分配计数器定义（调试用）
+ *
+ * 本文件定义了AllocCounter：以qmake CONFIG+=alloc_counter构建时（定义ALLOC_COUNTER），
+ * 程序接管glibc的malloc/calloc/realloc/memalign入口，按线程统计堆分配次数
+ * （operator new也经过malloc），用于检查采集线程预热后每轮采集是否还在分配内存。
+ * 未启用时不接管任何入口，计数恒为0。
+ */
+
+#ifndef ALLOCCOUNTER_H
+#define ALLOCCOUNTER_H
+
+#include <QtGlobal>
+
+/**
+ * @class AllocCounter
+ * @brief 按线程的堆分配计数器（静态接口，可在任意线程调用）
+ */
+class AllocCounter
+{
+public:
+    /**
+     * @brief 是否以ALLOC_COUNTER构建
+     */
+    static bool isEnabled();
+
+    /**
+     * @brief 当前线程累计的堆分配次数
+     *
+     * 两次调用之差即为其间本线程的分配次数，不受其他线程影响。
+     */
+    static quint64 threadCount();
+};
+
+#endif // ALLOCCOUNTER_H
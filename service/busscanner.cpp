@@ -0,0 +1,194 @@
+/**
+ * @file busscanner.cpp
+ * @brief 总线扫描服务实现
+ */
+
+#include "busscanner.h"
+#include "acquisitionservice.h"
+#include "busworker.h"
+#include "deviceservice.h"
+#include "modbusrtu.h"
+#include "pollingscheduler.h"
+
+#include <algorithm>
+#include <cstring>
+
+BusScanner *BusScanner::instance()
+{
+    static BusScanner s_instance;
+    return &s_instance;
+}
+
+BusScanner::BusScanner(QObject *parent)
+    : QObject(parent)
+    , m_knownCount(0)
+    , m_next(0)
+    , m_total(0)
+    , m_done(0)
+    , m_cached(0)
+    , m_startNs(0)
+    , m_busUs(0)
+    , m_running(false)
+{
+    invalidateAll();
+}
+
+void BusScanner::invalidate(int address)
+{
+    if (address >= MinAddress && address <= MaxAddress) {
+        m_cache[address].valid = false;
+    }
+}
+
+void BusScanner::invalidateAll()
+{
+    std::memset(m_cache, 0, sizeof(m_cache));
+}
+
+Result BusScanner::cachedResult() const
+{
+    QVariantList found;
+    for (int addr = MinAddress; addr <= MaxAddress; ++addr) {
+        if (m_cache[addr].valid && m_cache[addr].present) {
+            found << addr;
+        }
+    }
+    return Result::success(found);
+}
+
+Result BusScanner::start(int first, int last, bool force)
+{
+    if (m_running) {
+        return Result::error(1, "扫描正在进行");
+    }
+    if (first < MinAddress || last > MaxAddress || first > last) {
+        return Result::error(2, "扫描地址范围必须在1-247之间");
+    }
+
+    BusWorker *worker = AcquisitionService::instance()->busWorker();
+    if (worker != m_worker) {
+        m_worker = worker;
+        connect(worker, &BusWorker::probeFinished, this, &BusScanner::onProbeFinished,
+                Qt::UniqueConnection);
+        connect(worker, &QObject::destroyed, this, &BusScanner::onWorkerDestroyed,
+                Qt::UniqueConnection);
+    }
+
+    // 已配置设备的地址和上次在线的地址优先探测
+    bool known[MaxAddress + 1] = {};
+    Result devices = DeviceService::getDeviceList();
+    for (const QVariant &v : devices.data.toList()) {
+        int addr = v.toMap().value("modbusAddress").toInt();
+        if (addr >= MinAddress && addr <= MaxAddress) {
+            known[addr] = true;
+        }
+    }
+
+    qint64 now = PollingScheduler::monotonicNs();
+    QVector<int> unknown;
+    m_queue.clear();
+    m_found.clear();
+    m_cached = 0;
+    for (int addr = first; addr <= last; ++addr) {
+        const CacheEntry &entry = m_cache[addr];
+        if (known[addr] || (entry.valid && entry.present)) {
+            m_queue.append(addr);
+        } else if (!force && entry.valid && now - entry.probedNs < CacheTtlMs * 1000000LL) {
+            m_cached++;     // 缓存未过期的缺席地址不再探测
+        } else {
+            unknown.append(addr);
+        }
+    }
+    m_knownCount = m_queue.size();
+    m_queue += unknown;
+
+    m_total = last - first + 1;
+    m_done = m_cached;
+    m_next = 0;
+    m_busUs = 0;
+    m_startNs = now;
+    m_running = true;
+
+    emit progress(m_done, m_total, 0);
+    probeNext();
+    return Result::success();
+}
+
+void BusScanner::cancel()
+{
+    if (m_running) {
+        finish(3, "扫描已取消");
+    }
+}
+
+void BusScanner::probeNext()
+{
+    if (m_next >= m_queue.size()) {
+        finish(0, "扫描完成");
+        return;
+    }
+    if (!m_worker) {
+        finish(4, "通信服务已重启，扫描中止");
+        return;
+    }
+    int timeoutMs = m_next < m_knownCount ? int(KnownProbeTimeoutMs) : int(ProbeTimeoutMs);
+    m_worker->probe(m_queue[m_next], timeoutMs);
+}
+
+void BusScanner::onProbeFinished(int slave, int status, qint64 elapsedUs)
+{
+    // 取消后仍在途的探测：只更新缓存
+    bool present = status == ModbusRtu::Ok || status == ModbusRtu::ErrException;
+    if (slave >= MinAddress && slave <= MaxAddress) {
+        CacheEntry &entry = m_cache[slave];
+        entry.valid = true;
+        entry.present = present;
+        entry.probedNs = PollingScheduler::monotonicNs();
+    }
+
+    if (!m_running || m_next >= m_queue.size() || m_queue[m_next] != slave) {
+        return;
+    }
+
+    m_next++;
+    m_done++;
+    m_busUs += elapsedUs;
+    if (present) {
+        m_found.append(slave);
+        emit deviceFound(slave);
+    }
+    emit progress(m_done, m_total, m_found.size());
+    probeNext();
+}
+
+void BusScanner::onWorkerDestroyed()
+{
+    m_worker.clear();
+    invalidateAll();    // 串口参数可能已改变
+    if (m_running) {
+        finish(4, "通信服务已重启，扫描中止");
+    }
+}
+
+void BusScanner::finish(int code, const QString &message)
+{
+    m_running = false;
+
+    // 在线地址总会重新探测，缓存命中的都是缺席地址，结果只取本次探测
+    QList<int> found = m_found;
+    std::sort(found.begin(), found.end());
+
+    QVariantList list;
+    for (int addr : found) {
+        list << addr;
+    }
+
+    QVariantMap data;
+    data["found"] = list;
+    data["probed"] = m_next;
+    data["cached"] = m_cached;
+    data["elapsedMs"] = (PollingScheduler::monotonicNs() - m_startNs) / 1000000;
+    data["busMs"] = m_busUs / 1000;
+
+    emit finished(Result(code, message, data));
+}
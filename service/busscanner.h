@@ -0,0 +1,134 @@
+/**
+ * @file busscanner.h
+ * @brief 总线扫描服务定义
+ *
+ * 本文件定义了BusScanner：在默认RS485总线上依次探测从站地址1-247，
+ * 已知地址（已配置设备和上次扫描在线的地址）优先探测，其余地址使用
+ * 很短的探测超时。探测在采集线程中与周期采集交替进行，进度逐个上报，
+ * 可随时取消；结果按地址缓存，重新扫描时只探测缓存过期或已失效的地址。
+ */
+
+#ifndef BUSSCANNER_H
+#define BUSSCANNER_H
+
+#include "../common/result.h"
+
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+
+class BusWorker;
+
+/**
+ * @class BusScanner
+ * @brief 总线扫描服务类（单例，界面线程使用）
+ *
+ * 同一时刻只有一个探测在途，每个探测完成后再投递下一个，
+ * 因此扫描期间周期采集仍能按时进行。
+ */
+class BusScanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Limits {
+        MinAddress = 1,
+        MaxAddress = 247,
+        ProbeTimeoutMs = 40,        ///< 未知地址的探测超时
+        KnownProbeTimeoutMs = 200,  ///< 已知地址的探测超时（允许较慢的仪表）
+        CacheTtlMs = 600000         ///< 缓存有效期（10分钟）
+    };
+
+    /**
+     * @brief 获取单例
+     */
+    static BusScanner *instance();
+
+    /**
+     * @brief 开始扫描
+     * @param first 起始地址
+     * @param last 结束地址
+     * @param force true表示忽略缓存，全部重新探测
+     * @return Result 成功表示已开始，结果通过finished信号返回
+     */
+    Result start(int first = MinAddress, int last = MaxAddress, bool force = false);
+
+    /**
+     * @brief 取消正在进行的扫描（立即发出finished，已探测的结果保留在缓存中）
+     */
+    void cancel();
+
+    /**
+     * @brief 是否正在扫描
+     */
+    bool isRunning() const { return m_running; }
+
+    /**
+     * @brief 获取缓存中在线的从站地址
+     * @return Result 包含地址列表（升序）
+     */
+    Result cachedResult() const;
+
+    /**
+     * @brief 使单个地址的缓存失效（设备增删改时调用）
+     * @param address 从站地址
+     */
+    void invalidate(int address);
+
+    /**
+     * @brief 清空缓存
+     */
+    void invalidateAll();
+
+signals:
+    /**
+     * @brief 扫描进度
+     * @param done 已完成地址数（含缓存命中）
+     * @param total 地址总数
+     * @param found 已发现的在线从站数
+     */
+    void progress(int done, int total, int found);
+
+    /**
+     * @brief 发现一个在线从站
+     * @param address 从站地址
+     */
+    void deviceFound(int address);
+
+    /**
+     * @brief 扫描结束（完成、取消或中止）
+     * @param result 包含found（地址列表）、probed、cached、elapsedMs、busMs
+     */
+    void finished(const Result &result);
+
+private slots:
+    void onProbeFinished(int slave, int status, qint64 elapsedUs);
+    void onWorkerDestroyed();
+
+private:
+    explicit BusScanner(QObject *parent = nullptr);
+
+    struct CacheEntry {
+        bool valid;         ///< 是否有缓存
+        bool present;       ///< 从站是否在线
+        qint64 probedNs;    ///< 探测时间（单调时间）
+    };
+
+    void probeNext();
+    void finish(int code, const QString &message);
+
+    CacheEntry m_cache[MaxAddress + 1];     ///< 地址 → 缓存
+    QPointer<BusWorker> m_worker;           ///< 执行探测的采集线程
+    QVector<int> m_queue;                   ///< 待探测地址（已知地址在前）
+    int m_knownCount;                       ///< m_queue中已知地址的个数
+    int m_next;                             ///< 下一个待探测的下标
+    int m_total;                            ///< 本次扫描的地址总数
+    int m_done;                             ///< 已完成地址数
+    int m_cached;                           ///< 缓存命中数
+    QList<int> m_found;                     ///< 本次发现的在线地址
+    qint64 m_startNs;                       ///< 扫描开始时间
+    qint64 m_busUs;                         ///< 探测累计占用总线时间（微秒）
+    bool m_running;                         ///< 是否正在扫描
+};
+
+#endif // BUSSCANNER_H
@@ -0,0 +1,659 @@
+/**
+ * @file busworker.cpp
+ * @brief 单总线采集线程实现
+ *
+ * 本文件实现了采集线程主循环：执行界面线程投递的命令 → 取出到期设备采集
+ * （有待执行的写请求时与采集交替） → 结果入队并通知界面
+ * → 无事可做时睡眠到下一截止时间或被新命令唤醒。
+ */
+
+#include "busworker.h"
+#include "alloccounter.h"
+#include "commandqueue.h"
+#include "modbussimulator.h"
+#include "pollingtask.h"
+#include "serialtransport.h"
+#include "tcptransport.h"
+
+#include <QSharedPointer>
+#include <QSocketNotifier>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+BusWorker::BusWorker(const SerialConfig &serial, QObject *parent)
+    : QThread(parent)
+    , m_serial(serial)
+    , m_transport(nullptr)
+    , m_nextWriteJob(0)
+    , m_readBack(ModbusRtu::MaxReadBits)
+    , m_stopping(false)
+    , m_notifyPending(false)
+    , m_notifyFd(-1)
+    , m_notifier(nullptr)
+    , m_timeoutMs(3000)
+    , m_simulated(false)
+    , m_dropped(0)
+    , m_steadyAllocCycles(0)
+    , m_steadyAllocs(0)
+{
+    setObjectName(QString("bus:%1").arg(serial.port));
+
+    // 排队信号每次投递都要分配事件对象，改为写eventfd，由界面线程的通知器发出resultsReady
+    m_notifyFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_notifyFd >= 0) {
+        m_notifier = new QSocketNotifier(m_notifyFd, QSocketNotifier::Read, this);
+        // Qt 5.15起activated有重载，函数指针写法在各版本间不通用
+        connect(m_notifier, SIGNAL(activated(int)), this, SLOT(onNotify()));
+    }
+
+    FanOutStage *fanOut = new FanOutStage();
+    fanOut->addSink([this](const PipelineFrame &frame) {
+        RegisterSnapshotPtr snapshot(frame.snapshot);
+        m_lastPublished.insert(frame.deviceId, snapshot);
+        publish(frame.deviceId, Result::success(QVariant::fromValue(snapshot)));
+    });
+    m_pipeline.addStage(new ValidationStage());
+    m_pipeline.addStage(new ScalingStage());
+    m_pipeline.addStage(new DerivedStage());
+    m_pipeline.addStage(new RangeStage());
+    m_pipeline.addStage(new DeadbandStage());
+    m_pipeline.addStage(fanOut);
+}
+
+BusWorker::~BusWorker()
+{
+    stop();
+    delete m_notifier;
+    if (m_notifyFd >= 0) {
+        ::close(m_notifyFd);
+    }
+}
+
+void BusWorker::postCommand(const Command &cmd)
+{
+    QMutexLocker locker(&m_commandMutex);
+    m_commands.append(cmd);
+    m_wakeup.wakeAll();
+}
+
+void BusWorker::addDevice(const DeviceConfig &cfg)
+{
+    Command cmd;
+    cmd.type = Command::Add;
+    cmd.cfg = cfg;
+    cmd.deviceId = cfg.id;
+    postCommand(cmd);
+}
+
+void BusWorker::removeDevice(int deviceId)
+{
+    Command cmd;
+    cmd.type = Command::Remove;
+    cmd.deviceId = deviceId;
+    postCommand(cmd);
+}
+
+void BusWorker::setResponseTimeout(int timeoutMs)
+{
+    m_timeoutMs.store(timeoutMs);
+}
+
+bool BusWorker::runInWorker(const std::function<void()> &call, int waitMs)
+{
+    struct Pending {
+        QMutex mutex;
+        QWaitCondition done;
+        bool finished = false;
+    };
+    QSharedPointer<Pending> pending = QSharedPointer<Pending>::create();
+
+    Command cmd;
+    cmd.type = Command::Call;
+    cmd.deviceId = -1;
+    cmd.call = [call, pending]() {
+        call();
+        QMutexLocker locker(&pending->mutex);
+        pending->finished = true;
+        pending->done.wakeAll();
+    };
+    postCommand(cmd);
+
+    QMutexLocker locker(&pending->mutex);
+    if (!pending->finished) {
+        pending->done.wait(&pending->mutex, static_cast<unsigned long>(waitMs));
+    }
+    return pending->finished;
+}
+
+Result BusWorker::readOnce(const DeviceConfig &cfg, int waitMs)
+{
+    // 结果由采集线程写入，等待超时后不再读取，故用共享指针保存
+    QSharedPointer<Result> result = QSharedPointer<Result>::create();
+    bool finished = runInWorker([this, cfg, result]() {
+        PollingTask task(cfg);
+        QExplicitlySharedDataPointer<RegisterSnapshot> snapshot;
+        *result = task.execute(m_transport, responseTimeout(), &snapshot);
+        if (!result->isSuccess()) {
+            return;
+        }
+
+        // 一次性读取只做校验、换算、派生点计算和量程检查，不经过死区过滤，也不写实时值缓存
+        PipelineFrame frame;
+        frame.deviceId = cfg.id;
+        frame.nowNs = snapshot->monotonicNs;
+        frame.snapshot = snapshot;
+        ValidationStage validation;
+        ScalingStage scaling;
+        DerivedStage derived;
+        RangeStage range;
+        if (!validation.process(frame) || !scaling.process(frame) || !derived.process(frame)
+                || !range.process(frame)) {
+            *result = Result::error(ModbusRtu::ErrFrameLength, "采集数据校验失败");
+            return;
+        }
+        *result = Result::success(QVariant::fromValue(RegisterSnapshotPtr(snapshot)));
+    }, waitMs);
+
+    if (!finished) {
+        return Result::error(ModbusRtu::ErrTimeout, "总线忙，读取超时");
+    }
+    return *result;
+}
+
+Result BusWorker::waitOpened(int waitMs)
+{
+    if (!runInWorker([]() {}, waitMs)) {
+        return Result::error(ModbusRtu::ErrTimeout, "采集线程未响应");
+    }
+    return openResult();
+}
+
+void BusWorker::probe(int slave, int timeoutMs)
+{
+    Command cmd;
+    cmd.type = Command::Call;
+    cmd.deviceId = -1;
+    cmd.call = [this, slave, timeoutMs]() {
+        // 读地址0的1个保持寄存器；异常应答同样说明从站在线
+        ModbusFrame request;
+        ModbusFrame response;
+        quint8 address = static_cast<quint8>(slave);
+        ModbusRtu::Status status = ModbusRtu::encodeReadRequest(request, address, 3, 0, 1);
+        qint64 sentNs = PollingScheduler::monotonicNs();
+        if (status == ModbusRtu::Ok) {
+            status = m_transport->transact(request, response,
+                                           ModbusRtu::expectedReadResponseLength(3, 1), timeoutMs);
+        }
+        if (status == ModbusRtu::Ok) {
+            quint16 value;
+            status = ModbusRtu::decodeReadResponse(response, address, 3, 1, &value);
+        }
+        emit probeFinished(slave, status, (PollingScheduler::monotonicNs() - sentNs) / 1000);
+    };
+    postCommand(cmd);
+}
+
+void BusWorker::submitWrite(const WriteRequest &request)
+{
+    Command cmd;
+    cmd.type = Command::Call;
+    cmd.deviceId = request.deviceId;
+    cmd.call = [this, request]() {
+        m_pendingWrites.append(request);
+    };
+    postCommand(cmd);
+}
+
+void BusWorker::planWrites()
+{
+    m_writeJobs.clear();
+    m_nextWriteJob = 0;
+
+    // 按设备分组后合并，设备之间保持首条命令的提交顺序
+    QVector<int> devices;
+    QHash<int, QVector<WriteRequest>> byDevice;
+    QHash<int, int> slaves;
+    for (const WriteRequest &r : m_pendingWrites) {
+        if (!byDevice.contains(r.deviceId)) {
+            devices.append(r.deviceId);
+        }
+        byDevice[r.deviceId].append(r);
+        slaves.insert(r.deviceId, r.slave);     // 从站地址以最新命令为准
+    }
+    m_pendingWrites.clear();
+
+    for (int deviceId : devices) {
+        for (const WriteGroup &group : WritePlanner::plan(byDevice.value(deviceId))) {
+            WriteJob job;
+            job.deviceId = deviceId;
+            job.slave = slaves.value(deviceId);
+            job.group = group;
+            m_writeJobs.append(job);
+            for (qint64 id : group.commandIds) {
+                m_commandProgress[id].remaining++;
+            }
+        }
+    }
+}
+
+ModbusRtu::Status BusWorker::writeAndVerify(const WriteJob &job, int timeoutMs, quint8 *exceptionCode)
+{
+    const WriteGroup &group = job.group;
+    quint8 slave = static_cast<quint8>(job.slave);
+    quint16 start = static_cast<quint16>(group.start);
+    quint16 count = static_cast<quint16>(group.values.size());
+
+    ModbusFrame request;
+    ModbusFrame response;
+    ModbusRtu::Status status = ModbusRtu::encodeWriteRequest(request, slave, static_cast<quint8>(group.functionCode),
+                                                             start, count, group.values.constData());
+    if (status == ModbusRtu::Ok) {
+        status = m_transport->transact(request, response, ModbusRtu::WriteResponseLength, timeoutMs);
+    }
+    if (status == ModbusRtu::Ok) {
+        status = ModbusRtu::decodeWriteResponse(response, request, exceptionCode);
+    }
+    if (status != ModbusRtu::Ok) {
+        return status;
+    }
+
+    // 回读校验：线圈用FC01，寄存器用FC03
+    bool coils = group.functionCode == 5 || group.functionCode == 15;
+    quint8 readFc = coils ? 1 : 3;
+    status = ModbusRtu::encodeReadRequest(request, slave, readFc, start, count);
+    if (status == ModbusRtu::Ok) {
+        status = m_transport->transact(request, response,
+                                       ModbusRtu::expectedReadResponseLength(readFc, count), timeoutMs);
+    }
+    if (status == ModbusRtu::Ok) {
+        status = ModbusRtu::decodeReadResponse(response, slave, readFc, count, m_readBack.data(), exceptionCode);
+    }
+    if (status != ModbusRtu::Ok) {
+        return status;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        quint16 expected = coils ? (group.values[i] ? 1 : 0) : group.values[i];
+        if (m_readBack[i] != expected) {
+            return ModbusRtu::ErrVerifyMismatch;
+        }
+    }
+    return ModbusRtu::Ok;
+}
+
+void BusWorker::executeNextWrite()
+{
+    if (m_nextWriteJob >= m_writeJobs.size()) {
+        planWrites();
+        if (m_writeJobs.isEmpty()) {
+            return;
+        }
+    }
+    const WriteJob job = m_writeJobs[m_nextWriteJob++];
+    if (m_nextWriteJob >= m_writeJobs.size()) {
+        m_writeJobs.clear();
+        m_nextWriteJob = 0;
+    }
+
+    for (qint64 id : job.group.commandIds) {
+        CommandProgress &progress = m_commandProgress[id];
+        if (progress.attempts == 0) {
+            progress.attempts = 1;
+            emit commandStatusChanged(id, CommandQueue::Sent, 1, QString());
+        }
+    }
+
+    PollingTask *task = m_tasks.value(job.deviceId);
+    int ceilingMs = responseTimeout();
+    int timeoutMs = task ? task->health().timeoutMs(ceilingMs) : ceilingMs;
+
+    qint64 start = PollingScheduler::monotonicNs();
+    ModbusRtu::Status status = ModbusRtu::ErrTimeout;
+    quint8 exceptionCode = 0;
+    int attempts = 0;
+    while (attempts < MaxWriteAttempts) {
+        attempts++;
+        status = writeAndVerify(job, timeoutMs, &exceptionCode);
+        // 从站明确拒绝（异常应答）时重试也没有意义
+        if (status == ModbusRtu::Ok || status == ModbusRtu::ErrException
+                || status == ModbusRtu::ErrInvalidArgument) {
+            break;
+        }
+    }
+    {
+        QMutexLocker locker(&m_schedulerMutex);
+        m_scheduler.addBusyTime(PollingScheduler::monotonicNs() - start);
+    }
+
+    QString error;
+    if (status == ModbusRtu::ErrException) {
+        error = QString("%1（异常码%2）").arg(ModbusRtu::statusText(status)).arg(exceptionCode);
+    } else if (status != ModbusRtu::Ok) {
+        error = ModbusRtu::statusText(status);
+    }
+
+    for (qint64 id : job.group.commandIds) {
+        auto it = m_commandProgress.find(id);
+        if (it == m_commandProgress.end()) {
+            continue;
+        }
+        it->attempts = qMax(it->attempts, attempts);
+        if (!error.isEmpty() && it->error.isEmpty()) {
+            it->error = error;
+        }
+        if (--it->remaining > 0) {
+            continue;
+        }
+        emit commandStatusChanged(id, it->error.isEmpty() ? CommandQueue::Acked : CommandQueue::Failed,
+                                  it->attempts, it->error);
+        m_commandProgress.erase(it);
+    }
+}
+
+void BusWorker::stop()
+{
+    {
+        QMutexLocker locker(&m_commandMutex);
+        m_stopping = true;
+        m_wakeup.wakeAll();
+    }
+    wait();
+}
+
+bool BusWorker::takeResult(PollResult &result)
+{
+    if (m_results.tryPop(result)) {
+        return true;
+    }
+    // 先清通知标志再检查一次，避免与生产者竞争时丢失通知
+    m_notifyPending.store(false);
+    return m_results.tryPop(result);
+}
+
+QList<PollingStats> BusWorker::pollingStats() const
+{
+    QMutexLocker locker(&m_schedulerMutex);
+    return m_scheduler.allStats();
+}
+
+QList<PriorityClassStats> BusWorker::classStats() const
+{
+    QMutexLocker locker(&m_schedulerMutex);
+    return m_scheduler.classStats();
+}
+
+QList<LinkStats> BusWorker::linkStats() const
+{
+    QMutexLocker locker(&m_schedulerMutex);
+    return m_linkStats.values();
+}
+
+double BusWorker::utilization() const
+{
+    QMutexLocker locker(&m_schedulerMutex);
+    return m_scheduler.utilization(PollingScheduler::monotonicNs());
+}
+
+Result BusWorker::openResult() const
+{
+    QMutexLocker locker(&m_openMutex);
+    return m_openResult;
+}
+
+void BusWorker::publish(int deviceId, const Result &result)
+{
+    PollResult item;
+    item.deviceId = deviceId;
+    item.result = result;
+    if (!m_results.tryPush(item)) {
+        m_dropped.fetch_add(1);   // 界面线程来不及处理时丢弃，不阻塞总线
+    }
+    if (!m_notifyPending.exchange(true)) {
+        if (m_notifyFd >= 0) {
+            quint64 one = 1;
+            ssize_t written = ::write(m_notifyFd, &one, sizeof(one));
+            Q_UNUSED(written)
+        } else {
+            emit resultsReady();
+        }
+    }
+}
+
+void BusWorker::onNotify()
+{
+    quint64 count;
+    ssize_t bytes = ::read(m_notifyFd, &count, sizeof(count));
+    Q_UNUSED(bytes)
+    emit resultsReady();
+}
+
+void BusWorker::processCommands()
+{
+    QVector<Command> commands;
+    {
+        QMutexLocker locker(&m_commandMutex);
+        if (m_commands.isEmpty()) {
+            return;
+        }
+        commands.swap(m_commands);
+    }
+
+    for (const Command &cmd : commands) {
+        switch (cmd.type) {
+        case Command::Add: {
+            delete m_tasks.take(cmd.deviceId);
+            m_warmCycles.remove(cmd.deviceId);
+            PollingTask *task = new PollingTask(cmd.cfg);
+            task->bindRealtimeCache();
+            m_tasks.insert(cmd.deviceId, task);
+            QMutexLocker locker(&m_schedulerMutex);
+            m_scheduler.addDevice(cmd.deviceId, cmd.cfg.pollInterval, PollingScheduler::monotonicNs(),
+                                  cmd.cfg.priority);
+            m_linkStats.remove(cmd.deviceId);   // 任务重建后直方图从零开始
+            break;
+        }
+        case Command::Remove: {
+            delete m_tasks.take(cmd.deviceId);
+            m_warmCycles.remove(cmd.deviceId);
+            m_pipeline.reset(cmd.deviceId);
+            m_lastPublished.remove(cmd.deviceId);
+            QMutexLocker locker(&m_schedulerMutex);
+            m_scheduler.removeDevice(cmd.deviceId);
+            m_linkStats.remove(cmd.deviceId);
+            break;
+        }
+        case Command::Call:
+            cmd.call();
+            break;
+        }
+    }
+}
+
+void BusWorker::markStale(int deviceId)
+{
+    PollingTask *task = m_tasks.value(deviceId);
+    if (!task) {
+        return;
+    }
+    task->addCacheFlags(RegisterSnapshot::FlagStale);
+
+    // 下一次成功采集的数据必须重新上报，以清除过期标志
+    m_pipeline.reset(deviceId);
+    if (AllocCounter::isEnabled()) {
+        m_warmCycles.insert(deviceId, 0);   // 流水线状态重建，重新预热
+    }
+
+    // 最近一次是失败时界面已显示错误，不再用旧值覆盖
+    RegisterSnapshotPtr last = m_lastPublished.value(deviceId);
+    if (!last) {
+        return;
+    }
+    QExplicitlySharedDataPointer<RegisterSnapshot> stale(new RegisterSnapshot(*last));
+    stale->stale.fill(true);
+    stale->changed.resize(stale->size());
+    for (int i = 0; i < stale->size(); ++i) {
+        stale->changed[i] = i;
+    }
+    RegisterSnapshotPtr snapshot(stale);
+    m_lastPublished.insert(deviceId, snapshot);
+    publish(deviceId, Result::success(QVariant::fromValue(snapshot)));
+}
+
+void BusWorker::checkAllocations(int deviceId, bool success, quint64 allocations)
+{
+    // 失败周期要生成错误信息、重置流水线状态，不算稳态；恢复后重新预热
+    if (!success) {
+        m_warmCycles.insert(deviceId, 0);
+        return;
+    }
+    int &cycles = m_warmCycles[deviceId];
+    if (cycles < WarmupCycles) {
+        cycles++;
+        return;
+    }
+    // 稳态周期应为0，非0时在pollingStats中暴露出来
+    if (allocations > 0) {
+        m_steadyAllocCycles.fetch_add(1);
+        m_steadyAllocs.fetch_add(static_cast<qint64>(allocations));
+    }
+}
+
+void BusWorker::run()
+{
+    // 传输层在采集线程内创建和使用
+    SerialTransport serial;
+    TcpTransport tcp;
+    ModbusSimulator simulator;
+    simulator.setLineTiming(m_serial);
+    Result opened;
+    if (TcpTransport::isEndpoint(m_serial.port)) {
+        // TCP连接失败时不退回模拟从站，之后的事务会自动重连
+        opened = tcp.open(m_serial.port);
+        m_simulated.store(false);
+        m_transport = &tcp;
+    } else if (ModbusSimulator::isEndpoint(m_serial.port)) {
+        m_simulated.store(true);
+        m_transport = &simulator;
+    } else {
+        // 打开失败时也不退回模拟从站，否则编造的值会以正常质量进入缓存、数据库和MQTT；
+        // 之后的事务返回ErrIo，设备按通信中断上报，串口按间隔重新打开
+        opened = serial.open(m_serial);
+        m_simulated.store(false);
+        m_transport = &serial;
+    }
+    {
+        QMutexLocker locker(&m_openMutex);
+        m_openResult = opened;
+    }
+
+    bool readSinceWrite = true;
+    for (;;) {
+        // 每轮开始前检查：总线没有空闲或写命令源源不断时不会走到下面的等待分支
+        {
+            QMutexLocker locker(&m_commandMutex);
+            if (m_stopping) {
+                break;
+            }
+        }
+        processCommands();
+
+        // 写请求与到期采集交替：写命令最多等一次采集，连续的写命令也不会饿死采集
+        if (readSinceWrite && hasPendingWrites()) {
+            executeNextWrite();
+            readSinceWrite = false;
+            continue;
+        }
+
+        // 稳态周期的分配从取出到期设备算起，到流水线分发入队、调度和链路统计更新为止
+        quint64 allocsBefore = AllocCounter::threadCount();
+        qint64 now = PollingScheduler::monotonicNs();
+        int deviceId;
+        int staleId;
+        {
+            QMutexLocker locker(&m_schedulerMutex);
+            staleId = m_scheduler.takeStale(now);
+            deviceId = staleId < 0 ? m_scheduler.takeDue(now) : -1;
+        }
+
+        if (staleId >= 0) {
+            markStale(staleId);
+            continue;
+        }
+
+        if (deviceId < 0 && hasPendingWrites()) {
+            executeNextWrite();
+            continue;
+        }
+
+        if (deviceId >= 0) {
+            PollingTask *task = m_tasks.value(deviceId);
+            qint64 start = PollingScheduler::monotonicNs();
+            if (task && task->health().inBackoff(start)) {
+                QMutexLocker locker(&m_schedulerMutex);
+                m_scheduler.skip(deviceId, start);     // 退避期内不占用总线
+                continue;
+            }
+
+            int ceilingMs = responseTimeout();
+            QExplicitlySharedDataPointer<RegisterSnapshot> snapshot;
+            Result result = task ? task->execute(m_transport, task->health().timeoutMs(ceilingMs), &snapshot)
+                                 : Result::error(404, "设备不存在");
+            qint64 end = PollingScheduler::monotonicNs();
+            {
+                QMutexLocker locker(&m_schedulerMutex);
+                m_scheduler.complete(deviceId, start, end, result.isSuccess());
+                if (result.isSuccess()) {
+                    m_scheduler.markFresh(deviceId);
+                }
+                if (task) {
+                    m_linkStats.insert(deviceId, task->health().stats(deviceId, ceilingMs));
+                }
+            }
+            if (result.isSuccess()) {
+                // 有值超出死区时由分发级入队
+                PipelineFrame frame;
+                frame.deviceId = deviceId;
+                frame.nowNs = snapshot->monotonicNs;
+                frame.snapshot = snapshot;
+                m_pipeline.process(frame);
+            } else {
+                // 恢复后的第一轮即使数值未变也要上报，覆盖界面上的错误状态
+                m_pipeline.reset(deviceId);
+                m_lastPublished.remove(deviceId);
+                publish(deviceId, result);
+            }
+            if (AllocCounter::isEnabled()) {
+                checkAllocations(deviceId, result.isSuccess(), AllocCounter::threadCount() - allocsBefore);
+            }
+            readSinceWrite = true;
+            continue;
+        }
+
+        qint64 deadline;
+        {
+            QMutexLocker locker(&m_schedulerMutex);
+            deadline = m_scheduler.nextDeadlineNs();
+        }
+
+        QMutexLocker locker(&m_commandMutex);
+        if (m_stopping) {
+            break;
+        }
+        if (!m_commands.isEmpty()) {
+            continue;
+        }
+        if (deadline < 0) {
+            m_wakeup.wait(&m_commandMutex);
+        } else {
+            qint64 remainNs = deadline - PollingScheduler::monotonicNs();
+            if (remainNs > 0) {
+                m_wakeup.wait(&m_commandMutex, static_cast<unsigned long>((remainNs + 999999) / 1000000));
+            }
+        }
+    }
+
+    qDeleteAll(m_tasks);
+    m_tasks.clear();
+    m_transport = nullptr;
+}
@@ -0,0 +1,295 @@
+/**
+ * @file busworker.h
+ * @brief 单总线采集线程定义
+ *
+ * 本文件定义了BusWorker：每个RS485总线（串口）或TCP端点一个采集线程，
+ * 线程独占该总线的传输层、轮询调度器和各设备的采集任务。采集结果通过无锁SPSC队列
+ * 交给界面线程，慢设备或超时设备只会占用自己总线的时间，不会阻塞界面。
+ * 结果入队后经eventfd唤醒界面线程，投递通知不分配内存；预热后的采集周期不分配内存。
+ * 写命令排队后与周期采集交替执行，每次写入后回读校验。
+ */
+
+#ifndef BUSWORKER_H
+#define BUSWORKER_H
+
+#include "../common/result.h"
+#include "../common/spscqueue.h"
+#include "datapipeline.h"
+#include "deviceservice.h"
+#include "systemservice.h"
+#include "linkhealth.h"
+#include "modbusrtu.h"
+#include "pollingscheduler.h"
+#include "writeplanner.h"
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include <QVector>
+#include <atomic>
+#include <functional>
+
+class ModbusTransport;
+class PollingTask;
+class QSocketNotifier;
+
+/**
+ * @struct PollResult
+ * @brief 一次设备采集的结果
+ */
+struct PollResult {
+    int deviceId;       ///< 设备ID
+    Result result;      ///< 采集结果（成功时data为RegisterSnapshotPtr）
+
+    PollResult() : deviceId(-1) {}
+};
+
+/**
+ * @class BusWorker
+ * @brief 单总线采集线程类
+ *
+ * 除注明外，公有接口均可在界面线程调用；对调度器和任务的修改以命令形式
+ * 投递给采集线程执行。
+ */
+class BusWorker : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum Limits {
+        MaxWriteAttempts = 3,   ///< 写入（含回读校验）的最多尝试次数
+        WarmupCycles = 16       ///< 设备连续成功采集这么多轮后视为稳态，开始检查堆分配
+    };
+
+    /**
+     * @brief 构造采集线程
+     * @param serial 该总线的串口配置
+     * @param parent 父对象
+     */
+    explicit BusWorker(const SerialConfig &serial, QObject *parent = nullptr);
+    ~BusWorker() override;
+
+    /**
+     * @brief 总线名称（串口设备文件或TCP端点）
+     */
+    QString busName() const { return m_serial.port; }
+
+    /**
+     * @brief 加入或更新设备（按配置重建采集任务）
+     * @param cfg 设备配置
+     */
+    void addDevice(const DeviceConfig &cfg);
+
+    /**
+     * @brief 移除设备
+     * @param deviceId 设备ID
+     */
+    void removeDevice(int deviceId);
+
+    /**
+     * @brief 设置全局响应超时（各设备的自适应超时不超过此值）
+     * @param timeoutMs 超时（毫秒）
+     */
+    void setResponseTimeout(int timeoutMs);
+
+    /**
+     * @brief 在采集线程中执行一次性读取并等待结果（会阻塞调用线程）
+     * @param cfg 设备配置
+     * @param waitMs 最长等待时间（毫秒）
+     * @return Result 读取结果
+     */
+    Result readOnce(const DeviceConfig &cfg, int waitMs);
+
+    /**
+     * @brief 等待采集线程完成串口打开（会阻塞调用线程）
+     * @param waitMs 最长等待时间（毫秒）
+     * @return Result 串口打开结果
+     */
+    Result waitOpened(int waitMs);
+
+    /**
+     * @brief 在采集线程中探测一个从站地址（异步，完成后发出probeFinished）
+     *
+     * 探测与周期采集排在同一命令队列中，在两次采集之间执行。
+     * @param slave 从站地址
+     * @param timeoutMs 探测超时（毫秒）
+     */
+    void probe(int slave, int timeoutMs);
+
+    /**
+     * @brief 提交一条写命令（异步，状态变化时发出commandStatusChanged）
+     *
+     * 写命令不打断正在进行的采集：有到期采集时，写请求与采集交替执行。
+     * 执行前把各设备排队中的写命令合并（见WritePlanner），每个写请求写入后
+     * 用FC01/FC03回读比对，不一致或通信失败时重试，最多MaxWriteAttempts次。
+     * @param request 写命令（commandId由CommandQueue分配）
+     */
+    void submitWrite(const WriteRequest &request);
+
+    /**
+     * @brief 停止线程并等待退出
+     */
+    void stop();
+
+    /**
+     * @brief 取出一个采集结果（仅界面线程调用）
+     * @param result 输出结果
+     * @return false表示队列为空
+     */
+    bool takeResult(PollResult &result);
+
+    /**
+     * @brief 获取调度统计快照
+     */
+    QList<PollingStats> pollingStats() const;
+
+    /**
+     * @brief 获取各设备链路统计快照（往返时间分位数、当前超时和退避状态）
+     */
+    QList<LinkStats> linkStats() const;
+
+    /**
+     * @brief 获取各优先级的调度统计（需求、拉长倍数、配置与实际间隔）
+     */
+    QList<PriorityClassStats> classStats() const;
+
+    /**
+     * @brief 该总线的数据处理流水线（可在任意线程增删级）
+     *
+     * 默认依次为校验、单位换算、死区过滤和分发；分发级把有变化的快照放入结果队列。
+     */
+    DataPipeline &pipeline() { return m_pipeline; }
+
+    /**
+     * @brief 获取流水线统计快照（各级耗时、进入和通过死区的值个数）
+     */
+    PipelineStats pipelineStats() const { return m_pipeline.stats(); }
+
+    /**
+     * @brief 总线占用率（0.0-1.0）
+     */
+    double utilization() const;
+
+    /**
+     * @brief 是否使用模拟从站（总线名称为sim://时）
+     */
+    bool isSimulated() const { return m_simulated.load(); }
+
+    /**
+     * @brief 串口打开结果
+     */
+    Result openResult() const;
+
+    /**
+     * @brief 因队列满而丢弃的结果数
+     */
+    qint64 droppedResults() const { return m_dropped.load(); }
+
+    /**
+     * @brief 稳态下仍有堆分配的采集周期数（仅以ALLOC_COUNTER构建时统计，应为0）
+     */
+    qint64 steadyAllocCycles() const { return m_steadyAllocCycles.load(); }
+
+    /**
+     * @brief 稳态采集周期中的堆分配总次数（仅以ALLOC_COUNTER构建时统计）
+     */
+    qint64 steadyAllocations() const { return m_steadyAllocs.load(); }
+
+signals:
+    /**
+     * @brief 队列由空变为非空（在界面线程发出，多次采集只通知一次）
+     *
+     * 采集成功但所有值都在死区内的周期不入队。
+     */
+    void resultsReady();
+
+    /**
+     * @brief 一次地址探测完成
+     * @param slave 从站地址
+     * @param status ModbusRtu::Status，Ok或ErrException表示从站在线
+     * @param elapsedUs 探测占用总线的时间（微秒）
+     */
+    void probeFinished(int slave, int status, qint64 elapsedUs);
+
+    /**
+     * @brief 写命令状态变化
+     * @param commandId 命令ID
+     * @param status CommandQueue::Status（Sent、Acked或Failed）
+     * @param attempts 已尝试次数
+     * @param error 失败原因（成功时为空）
+     */
+    void commandStatusChanged(qint64 commandId, int status, int attempts, const QString &error);
+
+protected:
+    void run() override;
+
+private slots:
+    void onNotify();
+
+private:
+    struct Command {
+        enum Type { Add, Remove, Call } type;
+        DeviceConfig cfg;
+        int deviceId;
+        std::function<void()> call;
+    };
+
+    struct WriteJob {
+        int deviceId;
+        int slave;
+        WriteGroup group;
+    };
+
+    struct CommandProgress {
+        int remaining = 0;      ///< 尚未完成的写请求数
+        int attempts = 0;       ///< 各写请求中的最多尝试次数
+        QString error;          ///< 第一个失败的原因
+    };
+
+    void postCommand(const Command &cmd);
+    bool runInWorker(const std::function<void()> &call, int waitMs);
+    void processCommands();
+    void publish(int deviceId, const Result &result);
+    void markStale(int deviceId);
+    void checkAllocations(int deviceId, bool success, quint64 allocations);
+    int responseTimeout() const { return m_timeoutMs.load(); }
+    bool hasPendingWrites() const { return m_nextWriteJob < m_writeJobs.size() || !m_pendingWrites.isEmpty(); }
+    void planWrites();
+    void executeNextWrite();
+    ModbusRtu::Status writeAndVerify(const WriteJob &job, int timeoutMs, quint8 *exceptionCode);
+
+    SerialConfig m_serial;                      ///< 串口配置
+    ModbusTransport *m_transport;               ///< 传输层（仅采集线程使用）
+    QHash<int, PollingTask *> m_tasks;          ///< 设备ID → 采集任务（仅采集线程使用）
+    QVector<WriteRequest> m_pendingWrites;      ///< 尚未规划的写命令（仅采集线程使用）
+    QVector<WriteJob> m_writeJobs;              ///< 已规划的写请求（仅采集线程使用）
+    int m_nextWriteJob;                         ///< 下一个要执行的写请求下标
+    QHash<qint64, CommandProgress> m_commandProgress;   ///< 命令ID → 执行进度（仅采集线程使用）
+    QVector<quint16> m_readBack;                ///< 回读校验缓冲区
+    DataPipeline m_pipeline;                    ///< 数据处理流水线（process仅采集线程调用）
+    QHash<int, RegisterSnapshotPtr> m_lastPublished;    ///< 设备ID → 最近入队的快照，最近一次失败时无（仅采集线程使用）
+    QHash<int, int> m_warmCycles;               ///< 设备ID → 连续成功采集轮数，达到WarmupCycles后检查分配（仅采集线程使用）
+    PollingScheduler m_scheduler;               ///< 调度器（受m_schedulerMutex保护）
+    QHash<int, LinkStats> m_linkStats;          ///< 设备ID → 链路统计快照（受m_schedulerMutex保护）
+    mutable QMutex m_schedulerMutex;            ///< 保护调度器和统计快照，供界面线程读取
+
+    QMutex m_commandMutex;                      ///< 保护命令队列
+    QWaitCondition m_wakeup;                    ///< 新命令或停止时唤醒采集线程
+    QVector<Command> m_commands;                ///< 待执行命令
+    bool m_stopping;                            ///< 是否请求停止（受m_commandMutex保护）
+
+    SpscQueue<PollResult, 256> m_results;       ///< 采集结果队列
+    std::atomic<bool> m_notifyPending;          ///< 是否已有未处理的resultsReady通知
+    int m_notifyFd;                             ///< 唤醒界面线程的eventfd，创建失败时为-1（退回排队信号）
+    QSocketNotifier *m_notifier;                ///< 在界面线程监听m_notifyFd
+    std::atomic<int> m_timeoutMs;               ///< 响应超时（毫秒）
+    std::atomic<bool> m_simulated;              ///< 是否使用模拟从站
+    std::atomic<qint64> m_dropped;              ///< 丢弃的结果数
+    std::atomic<qint64> m_steadyAllocCycles;    ///< 稳态下仍有堆分配的采集周期数
+    std::atomic<qint64> m_steadyAllocs;         ///< 稳态采集周期中的堆分配次数
+    mutable QMutex m_openMutex;                 ///< 保护m_openResult
+    Result m_openResult;                        ///< 串口打开结果
+};
+
+#endif // BUSWORKER_H
@@ -0,0 +1,96 @@
+/**
+ * @file commandqueue.cpp
+ * @brief 下行命令队列实现
+ */
+
+#include "commandqueue.h"
+#include "pollingscheduler.h"
+
+#include <QJsonDocument>
+
+// 命令记录，按ID升序
+static QList<QVariantMap> s_commands;
+static qint64 s_nextCommandId = 1;
+
+
+static int indexOf(qint64 id)
+{
+    for (int i = s_commands.size() - 1; i >= 0; --i) {
+        if (s_commands[i]["id"].toLongLong() == id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+QString CommandQueue::statusName(Status status)
+{
+    switch (status) {
+    case Pending: return "pending";
+    case Sent:    return "sent";
+    case Acked:   return "acked";
+    case Failed:  return "failed";
+    }
+    return "pending";
+}
+
+qint64 CommandQueue::enqueue(const QString &commandType, int deviceId, const QVariantMap &payload)
+{
+    QVariantMap cmd;
+    qint64 id = s_nextCommandId++;
+    cmd["id"] = id;
+    cmd["command_type"] = commandType;
+    cmd["device_id"] = deviceId;
+    cmd["payload"] = QString::fromUtf8(QJsonDocument::fromVariant(payload).toJson(QJsonDocument::Compact));
+    cmd["status"] = statusName(Pending);
+    cmd["attempts"] = 0;
+    cmd["last_error"] = QString();
+    cmd["created_at"] = PollingScheduler::wallClockNs();
+    cmd["updated_at"] = cmd["created_at"];
+    s_commands.append(cmd);
+
+    // 超出上限时丢弃最早的已完成命令，未完成的命令始终保留
+    for (int i = 0; s_commands.size() > MaxHistory && i < s_commands.size(); ) {
+        QString status = s_commands[i]["status"].toString();
+        if (status == statusName(Acked) || status == statusName(Failed)) {
+            s_commands.removeAt(i);
+        } else {
+            ++i;
+        }
+    }
+    return id;
+}
+
+bool CommandQueue::updateStatus(qint64 id, Status status, int attempts, const QString &error)
+{
+    int index = indexOf(id);
+    if (index < 0) {
+        return false;
+    }
+    QVariantMap &cmd = s_commands[index];
+    cmd["status"] = statusName(status);
+    cmd["attempts"] = attempts;
+    cmd["last_error"] = error;
+    cmd["updated_at"] = PollingScheduler::wallClockNs();
+    return true;
+}
+
+Result CommandQueue::getCommand(qint64 id)
+{
+    int index = indexOf(id);
+    if (index < 0) {
+        return Result::error(404, "命令不存在");
+    }
+    return Result::success(s_commands[index]);
+}
+
+Result CommandQueue::getCommands(int deviceId)
+{
+    QVariantList list;
+    for (int i = s_commands.size() - 1; i >= 0; --i) {
+        if (deviceId < 0 || s_commands[i]["device_id"].toInt() == deviceId) {
+            list.append(s_commands[i]);
+        }
+    }
+    return Result::success(list);
+}
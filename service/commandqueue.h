@@ -0,0 +1,78 @@
+/**
+ * @file commandqueue.h
+ * @brief 下行命令队列定义
+ *
+ * 本文件定义了下行命令队列，记录结构与数据库设计文档中的command_queue表一致：
+ * id、command_type（write_config/control）、device_id、payload（JSON）、
+ * status（pending/sent/acked/failed）、created_at、updated_at（自1970年起的纳秒数），
+ * 另加attempts（已尝试次数）和last_error（最后一次失败原因）。
+ * 当前保存在内存中，实际部署时需替换为数据库存储。
+ */
+
+#ifndef COMMANDQUEUE_H
+#define COMMANDQUEUE_H
+
+#include "../common/result.h"
+
+/**
+ * @class CommandQueue
+ * @brief 下行命令队列类（界面线程使用）
+ */
+class CommandQueue
+{
+public:
+    /**
+     * @brief 命令状态
+     */
+    enum Status {
+        Pending,    ///< 已入队，等待总线空闲
+        Sent,       ///< 已发送，等待回读校验
+        Acked,      ///< 写入并回读校验成功
+        Failed      ///< 重试后仍失败
+    };
+
+    enum Limits {
+        MaxHistory = 500    ///< 最多保留的命令条数，超出时丢弃最早的已完成命令
+    };
+
+    /**
+     * @brief 新增一条命令
+     * @param commandType 命令类型（write_config写寄存器、control写线圈）
+     * @param deviceId 设备ID
+     * @param payload 命令内容，保存为JSON
+     * @return 命令ID
+     */
+    static qint64 enqueue(const QString &commandType, int deviceId, const QVariantMap &payload);
+
+    /**
+     * @brief 更新命令状态
+     * @param id 命令ID
+     * @param status 新状态
+     * @param attempts 已尝试次数
+     * @param error 失败原因（成功时为空）
+     * @return false表示命令不存在
+     */
+    static bool updateStatus(qint64 id, Status status, int attempts, const QString &error = QString());
+
+    /**
+     * @brief 获取单条命令
+     * @param id 命令ID
+     * @return Result 包含命令记录
+     */
+    static Result getCommand(qint64 id);
+
+    /**
+     * @brief 获取命令列表（新命令在前）
+     * @param deviceId 设备ID，-1表示所有设备
+     * @return Result 包含命令记录列表
+     */
+    static Result getCommands(int deviceId = -1);
+
+    /**
+     * @brief 状态的表内取值
+     * @return pending/sent/acked/failed
+     */
+    static QString statusName(Status status);
+};
+
+#endif // COMMANDQUEUE_H
@@ -0,0 +1,591 @@
+/**
+ * @file databaseservice.cpp
+ * @brief 数据库持久化服务实现
+ *
+ * 写线程持有自己的连接（QSqlDatabase不能跨线程使用），读连接属于调用open()的线程。
+ * 写线程按“等到有任务 → 等满提交间隔 → 一次取空队列 → 一个事务”的节奏工作，
+ * 队列积压时一个事务会包含多个周期的任务，写入速率随之提高。
+ * 每个维护周期写线程再做一小步维护：删除最早的至多RetentionBatchRows行中已超出保留期的，
+ * 并用incremental_vacuum归还至多VacuumPagesPerTick页空闲页。每步的I/O有上限，
+ * 不会像整库VACUUM那样长时间占住数据库，采集结果最多晚一步维护的时间提交。
+ */
+
+#include "databaseservice.h"
+#include "pollingscheduler.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+#include <atomic>
+
+namespace {
+
+const char *WriterConnection = "db_writer";
+const char *ReaderConnection = "db_reader";
+
+const char *InsertRealtimeSql =
+        "INSERT INTO realtime_data(device_id, key, value, quality, timestamp) VALUES(?, ?, ?, ?, ?)";
+const char *WriteConfigSql = "INSERT OR REPLACE INTO config(key, value, updated_at) VALUES(?, ?, ?)";
+
+// 只检查按id最早的一批行：行按采集顺序插入，最早的一批未过期时后面的也不会过期，
+// 扫描范围不随表大小增长（timestamp没有单独的索引）
+const char *DeleteExpiredSql =
+        "DELETE FROM realtime_data WHERE id IN (SELECT id FROM"
+        " (SELECT id, timestamp FROM realtime_data ORDER BY id LIMIT ?) WHERE timestamp < ?)";
+
+std::atomic<int> s_retentionDays(DatabaseService::DefaultRetentionDays);   ///< 保留天数，0表示不删除
+
+/**
+ * @brief 建表语句（数据库设计文档第2节；时间列存自1970年起的纳秒数）
+ */
+const char *SchemaSql[] = {
+    "CREATE TABLE IF NOT EXISTS config ("
+    " key TEXT PRIMARY KEY, value TEXT, updated_at INTEGER)",
+    "CREATE TABLE IF NOT EXISTS realtime_data ("
+    " id INTEGER PRIMARY KEY AUTOINCREMENT, device_id INTEGER, key TEXT, value REAL,"
+    " quality TEXT, timestamp INTEGER)",
+    "CREATE INDEX IF NOT EXISTS idx_realtime_device_time ON realtime_data(device_id, timestamp DESC)",
+    "CREATE TABLE IF NOT EXISTS alarm ("
+    " id INTEGER PRIMARY KEY AUTOINCREMENT, device_id INTEGER, key TEXT, level TEXT, type TEXT,"
+    " status TEXT, message TEXT, triggered_at INTEGER, resolved_at INTEGER, confirmed_at INTEGER,"
+    " silenced_until INTEGER)",
+    "CREATE INDEX IF NOT EXISTS idx_alarm_status ON alarm(status)",
+    "CREATE INDEX IF NOT EXISTS idx_alarm_device_time ON alarm(device_id, triggered_at DESC)",
+    "CREATE TABLE IF NOT EXISTS command_queue ("
+    " id INTEGER PRIMARY KEY AUTOINCREMENT, command_type TEXT, device_id INTEGER, payload TEXT,"
+    " status TEXT, created_at INTEGER, updated_at INTEGER)",
+    "CREATE TABLE IF NOT EXISTS mqtt_cache ("
+    " id INTEGER PRIMARY KEY AUTOINCREMENT, topic TEXT, payload TEXT, qos INTEGER, retained INTEGER,"
+    " created_at INTEGER, status TEXT, last_error TEXT)",
+    "CREATE INDEX IF NOT EXISTS idx_mqtt_cache_status ON mqtt_cache(status, created_at)"
+};
+
+/**
+ * @brief 写任务：一批采集结果，或一条带参数的语句
+ */
+struct Job {
+    SnapshotBatchPtr batch;     ///< 采集结果批，为空表示语句任务
+    QString sql;                ///< 语句
+    QVariantList values;        ///< 绑定值
+    int attempts;               ///< 已失败的写入次数
+
+    Job() : attempts(0) {}
+};
+
+const char *qualityText(RegisterSnapshot::Quality quality)
+{
+    switch (quality) {
+    case RegisterSnapshot::Good: return "good";
+    case RegisterSnapshot::Bad:  return "bad";
+    default:                     return "uncertain";
+    }
+}
+
+/**
+ * @class Writer
+ * @brief 写线程
+ */
+class Writer : public QThread
+{
+public:
+    explicit Writer(const QString &path)
+        : m_path(path), m_started(false), m_stopping(false), m_dropped(0), m_failed(0), m_transactions(0),
+          m_rows(0), m_transactionNs(0), m_commitNs(0), m_maxCommitNs(0), m_lastCommitNs(0),
+          m_incrementalVacuum(false), m_nextMaintenanceNs(0), m_expiredRows(0), m_vacuumedPages(0),
+          m_maxMaintenanceNs(0) {}
+
+    /**
+     * @brief 启动线程并等待连接和表结构就绪
+     */
+    Result startAndWait()
+    {
+        start(QThread::LowPriority);
+        QMutexLocker locker(&m_mutex);
+        while (!m_started) {
+            m_wakeup.wait(&m_mutex);
+        }
+        return m_openResult;
+    }
+
+    bool enqueue(const Job &job)
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_stopping || m_jobs.size() >= DatabaseService::MaxQueuedJobs) {
+            m_dropped++;
+            return false;
+        }
+        m_jobs.append(job);
+        if (m_jobs.size() == 1) {
+            m_wakeup.wakeAll();
+        }
+        return true;
+    }
+
+    void stop()
+    {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_stopping = true;
+            m_wakeup.wakeAll();
+        }
+        wait();
+    }
+
+    QVariantMap stats() const
+    {
+        QMutexLocker locker(&m_mutex);
+        QVariantMap data;
+        data["path"] = m_path;
+        data["transactions"] = m_transactions;
+        data["rows"] = m_rows;
+        data["insertsPerSecond"] = m_transactionNs > 0 ? qRound64(m_rows * 1e9 / m_transactionNs) : 0;
+        data["avgCommitMs"] = m_transactions > 0 ? m_commitNs / 1e6 / m_transactions : 0.0;
+        data["maxCommitMs"] = m_maxCommitNs / 1e6;
+        data["lastCommitMs"] = m_lastCommitNs / 1e6;
+        data["queuedJobs"] = m_jobs.size();
+        data["droppedJobs"] = m_dropped;
+        data["failedJobs"] = m_failed;
+        data["lastError"] = m_lastError;
+        data["retentionDays"] = s_retentionDays.load(std::memory_order_relaxed);
+        data["expiredRows"] = m_expiredRows;
+        data["incrementalVacuum"] = m_incrementalVacuum;
+        data["vacuumedPages"] = m_vacuumedPages;
+        data["maxMaintenanceMs"] = m_maxMaintenanceNs / 1e6;
+        return data;
+    }
+
+protected:
+    void run() override
+    {
+        {
+            QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", WriterConnection);
+            db.setDatabaseName(m_path);
+            Result result = db.open() ? initialize(db) : Result::error(1, db.lastError().text());
+            {
+                QMutexLocker locker(&m_mutex);
+                m_openResult = result;
+                m_started = true;
+                m_wakeup.wakeAll();
+            }
+            if (result.isSuccess()) {
+                loop(db);
+            }
+            m_statements.clear();
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(WriterConnection);
+    }
+
+private:
+    Result initialize(QSqlDatabase &db)
+    {
+        // WAL：读者不阻塞写者；NORMAL：WAL下只在检查点同步，断电最多丢最近一次提交；
+        // INCREMENTAL：只对尚未建表的新库生效，已有的库改模式需要整库VACUUM，保持原样，
+        // 删除后的空闲页留在文件中供以后的写入复用
+        QSqlQuery pragma(db);
+        if (!pragma.exec("PRAGMA auto_vacuum=INCREMENTAL") || !pragma.exec("PRAGMA journal_mode=WAL")
+                || !pragma.exec("PRAGMA synchronous=NORMAL")) {
+            return Result::error(2, pragma.lastError().text());
+        }
+
+        QSqlQuery query(db);
+        int version = 0;
+        if (query.exec("SELECT value FROM config WHERE key = 'db_version'") && query.next()) {
+            version = query.value(0).toInt();
+        }
+        if (version > DatabaseService::SchemaVersion) {
+            return Result::error(3, QString("数据库版本%1高于程序支持的版本%2")
+                                 .arg(version).arg(int(DatabaseService::SchemaVersion)));
+        }
+        if (version == DatabaseService::SchemaVersion) {
+            return checkAutoVacuum(db);
+        }
+
+        db.transaction();
+        for (const char *sql : SchemaSql) {
+            if (!query.exec(sql)) {
+                QString error = query.lastError().text();
+                db.rollback();
+                return Result::error(4, error);
+            }
+        }
+        query.prepare(WriteConfigSql);
+        query.addBindValue("db_version");
+        query.addBindValue(QString::number(DatabaseService::SchemaVersion));
+        query.addBindValue(PollingScheduler::wallClockNs());
+        if (!query.exec() || !db.commit()) {
+            QString error = query.lastError().text();
+            db.rollback();
+            return Result::error(4, error);
+        }
+        return checkAutoVacuum(db);
+    }
+
+    Result checkAutoVacuum(QSqlDatabase &db)
+    {
+        QSqlQuery query(db);
+        if (query.exec("PRAGMA auto_vacuum") && query.next()) {
+            m_incrementalVacuum = query.value(0).toInt() == 2;
+        }
+        return Result::success();
+    }
+
+    void loop(QSqlDatabase &db)
+    {
+        QVector<Job> jobs;
+        qint64 lastCommitNs = 0;
+        for (;;) {
+            bool stopping;
+            {
+                QMutexLocker locker(&m_mutex);
+                if (m_jobs.isEmpty() && !m_stopping) {
+                    // 空闲时也按维护周期醒来
+                    m_wakeup.wait(&m_mutex, DatabaseService::MaintenanceIntervalMs);
+                }
+                if (!m_jobs.isEmpty()) {
+                    // 攒满一个提交间隔，让同一周期内各设备的结果进入同一个事务
+                    qint64 dueNs = lastCommitNs + DatabaseService::CommitIntervalMs * Q_INT64_C(1000000);
+                    for (;;) {
+                        qint64 remainNs = dueNs - PollingScheduler::monotonicNs();
+                        if (m_stopping || remainNs <= 0) {
+                            break;
+                        }
+                        m_wakeup.wait(&m_mutex, static_cast<unsigned long>((remainNs + 999999) / 1000000));
+                    }
+                    jobs.swap(m_jobs);
+                }
+                stopping = m_stopping;
+            }
+
+            if (!jobs.isEmpty()) {
+                lastCommitNs = PollingScheduler::monotonicNs();
+                write(db, jobs);
+                jobs.clear();
+            }
+            if (stopping) {
+                break;      // 停止后不再接受任务，队列已写空
+            }
+            maintain(db);
+        }
+
+        // 停止前最后一次写入失败时，放回的任务不再重试
+        QMutexLocker locker(&m_mutex);
+        m_failed += m_jobs.size();
+        m_jobs.clear();
+    }
+
+    /**
+     * @brief 把未能写入的任务按原顺序放回队列前部
+     *
+     * 已写满MaxWriteAttempts次的任务放弃，计入m_failed；队列放不下的部分计入m_dropped。
+     */
+    void requeue(const QVector<Job> &jobs, const QString &error)
+    {
+        QVector<Job> retry;
+        retry.reserve(jobs.size());
+        for (const Job &job : jobs) {
+            if (job.attempts + 1 < DatabaseService::MaxWriteAttempts) {
+                retry.append(job);
+                retry.last().attempts++;
+            }
+        }
+
+        QMutexLocker locker(&m_mutex);
+        m_failed += jobs.size() - retry.size();
+        int keep = qMin(retry.size(), qMax(0, int(DatabaseService::MaxQueuedJobs) - m_jobs.size()));
+        m_dropped += retry.size() - keep;
+        retry.resize(keep);
+        retry += m_jobs;
+        m_jobs.swap(retry);
+        m_lastError = error;
+    }
+
+    /**
+     * @brief 做一步有界的维护（每MaintenanceIntervalMs至多一次）：删除过期行，归还空闲页
+     *
+     * 过期行每批检查最早的RetentionBatchRows行，批数由积压量决定，以MaintenanceBudgetMs为限。
+     */
+    void maintain(QSqlDatabase &db)
+    {
+        qint64 startNs = PollingScheduler::monotonicNs();
+        if (startNs < m_nextMaintenanceNs) {
+            return;
+        }
+        m_nextMaintenanceNs = startNs + DatabaseService::MaintenanceIntervalMs * Q_INT64_C(1000000);
+
+        QString error;
+        qint64 expired = 0;
+        qint64 vacuumed = 0;
+        int days = s_retentionDays.load(std::memory_order_relaxed);
+        if (days > 0) {
+            // 按积压量删除：一批删满说明最早的行仍都过期，在时间预算内继续删下一批
+            QSqlQuery &query = statement(db, DeleteExpiredSql);
+            qint64 cutoffNs = PollingScheduler::wallClockNs() - days * Q_INT64_C(86400000000000);
+            qint64 deadlineNs = startNs + DatabaseService::MaintenanceBudgetMs * Q_INT64_C(1000000);
+            int deleted = DatabaseService::RetentionBatchRows;
+            while (deleted == DatabaseService::RetentionBatchRows && PollingScheduler::monotonicNs() < deadlineNs) {
+                query.addBindValue(int(DatabaseService::RetentionBatchRows));
+                query.addBindValue(cutoffNs);
+                if (!query.exec()) {
+                    error = query.lastError().text();
+                    break;
+                }
+                deleted = query.numRowsAffected();
+                expired += deleted;
+            }
+        }
+
+        // incremental_vacuum(N)要逐行取完结果才会归还N页，驱动不保证这样做，
+        // 所以每次只归还一页，放在一个事务中
+        if (m_incrementalVacuum) {
+            QSqlQuery query(db);
+            int pages = 0;
+            if (query.exec("PRAGMA freelist_count") && query.next()) {
+                pages = qMin(query.value(0).toInt(), int(DatabaseService::VacuumPagesPerTick));
+            }
+            if (pages > 0 && !db.transaction()) {
+                error = db.lastError().text();
+                pages = 0;      // 不在事务外逐页提交，下个周期再做
+            }
+            if (pages > 0) {
+                while (vacuumed < pages && query.exec("PRAGMA incremental_vacuum(1)")) {
+                    vacuumed++;
+                }
+                if (vacuumed < pages) {
+                    error = query.lastError().text();
+                }
+                if (!db.commit()) {
+                    error = db.lastError().text();
+                    db.rollback();
+                    vacuumed = 0;
+                }
+            }
+        }
+        qint64 elapsedNs = PollingScheduler::monotonicNs() - startNs;
+
+        QMutexLocker locker(&m_mutex);
+        m_expiredRows += expired;
+        m_vacuumedPages += vacuumed;
+        m_maxMaintenanceNs = qMax(m_maxMaintenanceNs, elapsedNs);
+        if (!error.isEmpty()) {
+            m_lastError = error;
+        }
+    }
+
+    QSqlQuery &statement(QSqlDatabase &db, const QString &sql)
+    {
+        auto it = m_statements.find(sql);
+        if (it == m_statements.end()) {
+            QSqlQuery query(db);
+            query.prepare(sql);
+            it = m_statements.insert(sql, query);
+        }
+        return *it;
+    }
+
+    void write(QSqlDatabase &db, const QVector<Job> &jobs)
+    {
+        qint64 startNs = PollingScheduler::monotonicNs();
+        QString error;
+        qint64 rows = 0;
+
+        if (!db.transaction()) {
+            // BEGIN失败（如检查点期间SQLITE_BUSY）时不逐条自动提交，放回队列下个周期再试
+            requeue(jobs, db.lastError().text());
+            return;
+        }
+        for (const Job &job : jobs) {
+            if (!job.batch) {
+                QSqlQuery &query = statement(db, job.sql);
+                for (const QVariant &v : job.values) {
+                    query.addBindValue(v);
+                }
+                if (query.exec()) {
+                    rows++;
+                } else {
+                    error = query.lastError().text();
+                }
+                continue;
+            }
+
+            QSqlQuery &insert = statement(db, InsertRealtimeSql);
+            const SnapshotBatch &batch = *job.batch;
+            for (int d = 0; d < batch.size(); ++d) {
+                const RegisterSnapshotPtr &s = batch.snapshots[d];
+                if (!s) {
+                    continue;
+                }
+                for (int i : s->changed) {
+                    insert.addBindValue(s->deviceId);
+                    insert.addBindValue(s->address(i));
+                    insert.addBindValue(s->values[i]);
+                    insert.addBindValue(qualityText(s->quality(i)));
+                    insert.addBindValue(s->timestampsNs[i]);
+                    if (insert.exec()) {
+                        rows++;
+                    } else {
+                        error = insert.lastError().text();
+                    }
+                }
+            }
+        }
+
+        qint64 commitStartNs = PollingScheduler::monotonicNs();
+        if (!db.commit()) {
+            // 与BEGIN失败一样放回队列重试，不丢弃整批
+            QString commitError = db.lastError().text();
+            db.rollback();
+            requeue(jobs, commitError);
+            return;
+        }
+        qint64 endNs = PollingScheduler::monotonicNs();
+
+        QMutexLocker locker(&m_mutex);
+        m_transactions++;
+        m_rows += rows;
+        m_transactionNs += endNs - startNs;
+        m_lastCommitNs = endNs - commitStartNs;
+        m_commitNs += m_lastCommitNs;
+        m_maxCommitNs = qMax(m_maxCommitNs, m_lastCommitNs);
+        if (!error.isEmpty()) {
+            m_lastError = error;
+        }
+    }
+
+    QString m_path;                         ///< 数据库文件路径
+    mutable QMutex m_mutex;                 ///< 保护队列、状态和统计
+    QWaitCondition m_wakeup;                ///< 有新任务、停止或启动完成时唤醒
+    QVector<Job> m_jobs;                    ///< 待写任务
+    bool m_started;                         ///< 连接和表结构是否已处理完
+    bool m_stopping;                        ///< 是否正在停止
+    Result m_openResult;                    ///< 打开结果
+    QHash<QString, QSqlQuery> m_statements; ///< SQL文本 → 预编译语句（仅写线程使用）
+    qint64 m_dropped;                       ///< 队列满时丢弃的任务数
+    qint64 m_failed;                        ///< 重试MaxWriteAttempts次仍未写入而放弃的任务数
+    qint64 m_transactions;                  ///< 事务数
+    qint64 m_rows;                          ///< 写入行数
+    qint64 m_transactionNs;                 ///< 事务累计耗时
+    qint64 m_commitNs;                      ///< 提交累计耗时
+    qint64 m_maxCommitNs;                   ///< 最大提交耗时
+    qint64 m_lastCommitNs;                  ///< 最近一次提交耗时
+    QString m_lastError;                    ///< 最近的错误
+    bool m_incrementalVacuum;               ///< 数据库是否为增量回收模式（仅写线程写）
+    qint64 m_nextMaintenanceNs;             ///< 下次维护的单调时间（仅写线程使用）
+    qint64 m_expiredRows;                   ///< 因超出保留期删除的行数
+    qint64 m_vacuumedPages;                 ///< 归还给文件系统的页数
+    qint64 m_maxMaintenanceNs;              ///< 单步维护的最大耗时
+};
+
+Writer *s_writer = nullptr;
+
+} // namespace
+
+void DatabaseService::setRetentionDays(int days)
+{
+    s_retentionDays.store(qMax(0, days), std::memory_order_relaxed);
+}
+
+QString DatabaseService::defaultPath()
+{
+    return "/data/gateway.db";
+}
+
+Result DatabaseService::open(const QString &path)
+{
+    close();
+
+    Writer *writer = new Writer(path);
+    Result result = writer->startAndWait();
+    if (!result.isSuccess()) {
+        writer->stop();
+        delete writer;
+        return result;
+    }
+
+    QSqlDatabase reader = QSqlDatabase::addDatabase("QSQLITE", ReaderConnection);
+    reader.setDatabaseName(path);
+    if (!reader.open()) {
+        result = Result::error(1, reader.lastError().text());
+        writer->stop();
+        delete writer;
+        return result;
+    }
+    QSqlQuery(reader).exec("PRAGMA busy_timeout=1000");
+
+    s_writer = writer;
+    return Result::success();
+}
+
+void DatabaseService::close()
+{
+    if (!s_writer) {
+        return;
+    }
+    s_writer->stop();
+    delete s_writer;
+    s_writer = nullptr;
+
+    QSqlDatabase::database(ReaderConnection, false).close();
+    QSqlDatabase::removeDatabase(ReaderConnection);
+}
+
+bool DatabaseService::isOpen()
+{
+    return s_writer != nullptr;
+}
+
+bool DatabaseService::submitBatch(const SnapshotBatchPtr &batch)
+{
+    if (!s_writer || !batch) {
+        return false;
+    }
+    Job job;
+    job.batch = batch;
+    return s_writer->enqueue(job);
+}
+
+bool DatabaseService::submit(const QString &sql, const QVariantList &values)
+{
+    if (!s_writer) {
+        return false;
+    }
+    Job job;
+    job.sql = sql;
+    job.values = values;
+    return s_writer->enqueue(job);
+}
+
+bool DatabaseService::writeConfig(const QString &key, const QString &value)
+{
+    return submit(WriteConfigSql, QVariantList() << key << value << PollingScheduler::wallClockNs());
+}
+
+Result DatabaseService::readConfig(const QString &key)
+{
+    if (!s_writer) {
+        return Result::error(1, "数据库未打开");
+    }
+    QSqlQuery query(QSqlDatabase::database(ReaderConnection, false));
+    query.prepare("SELECT value FROM config WHERE key = ?");
+    query.addBindValue(key);
+    if (!query.exec()) {
+        return Result::error(2, query.lastError().text());
+    }
+    if (!query.next()) {
+        return Result::error(3, QString("配置项%1不存在").arg(key));
+    }
+    return Result::success(query.value(0).toString());
+}
+
+Result DatabaseService::stats()
+{
+    if (!s_writer) {
+        return Result::error(1, "数据库未打开");
+    }
+    return Result::success(s_writer->stats());
+}
@@ -0,0 +1,109 @@
+/**
+ * @file databaseservice.h
+ * @brief 数据库持久化服务定义
+ *
+ * 本文件定义了SQLite持久层。所有写操作都交给唯一的写线程：调用者只把任务放入
+ * 有界队列后立即返回，写线程每CommitIntervalMs（一个采集周期）把队列中积累的任务
+ * 合成一个事务提交，100台设备一轮的变化值只提交一次。数据库使用WAL模式，
+ * 读者（界面线程）不会被写事务阻塞；写线程按SQL文本缓存预编译语句。
+ * 写线程同时负责数据保留：每个维护周期按积压量分批删除过期行（以时间预算为限）、归还一小批空闲页，
+ * 不做会长时间阻塞的整库VACUUM。
+ * 表结构见数据库设计文档，版本号存放在config表的db_version中。
+ */
+
+#ifndef DATABASESERVICE_H
+#define DATABASESERVICE_H
+
+#include "../common/result.h"
+#include "registersnapshot.h"
+
+#include <QString>
+#include <QVariantList>
+
+/**
+ * @class DatabaseService
+ * @brief 数据库持久化服务类
+ *
+ * submit系列函数可在任意线程调用；open()、close()和读函数应在界面线程调用。
+ * 未打开或打开失败时提交的任务直接丢弃，服务退化为纯内存运行。
+ */
+class DatabaseService
+{
+public:
+    enum Limits {
+        SchemaVersion = 1,          ///< 当前表结构版本
+        CommitIntervalMs = 1000,    ///< 两次提交的最小间隔（一个采集周期）
+        MaxQueuedJobs = 256,        ///< 队列上限，写线程跟不上时丢弃新任务并计数
+        MaxWriteAttempts = 3,       ///< 一个任务最多写入的次数，BEGIN或COMMIT失败后放回队列重试
+        DefaultRetentionDays = 90,  ///< realtime_data默认保留天数
+        MaintenanceIntervalMs = 1000,   ///< 两步维护的最小间隔
+        MaintenanceBudgetMs = 200,  ///< 每步维护删除过期行的时间预算，积压时在预算内连续删除多批
+        RetentionBatchRows = 2000,  ///< 每批删除检查的最早行数，删满一批才继续下一批
+        VacuumPagesPerTick = 256    ///< 每步维护最多归还的空闲页数（默认页大小下1MB）
+    };
+
+    /**
+     * @brief 默认的数据库文件路径（数据分区上）
+     */
+    static QString defaultPath();
+
+    /**
+     * @brief 设置realtime_data的保留天数（可在任意线程调用，打开前后均可）
+     * @param days 保留天数，0表示不删除
+     */
+    static void setRetentionDays(int days);
+
+    /**
+     * @brief 打开数据库，必要时建表或迁移，并启动写线程
+     * @param path 数据库文件路径
+     * @return Result 失败时包含SQLite错误信息
+     */
+    static Result open(const QString &path);
+
+    /**
+     * @brief 提交队列中剩余的任务并停止写线程
+     */
+    static void close();
+
+    /**
+     * @brief 是否已打开
+     */
+    static bool isOpen();
+
+    /**
+     * @brief 提交一批采集结果，各快照中变化的值写入realtime_data（同一设备可有多个快照，按批中顺序写入）
+     * @param batch 采集结果批（只读共享，不复制）
+     * @return false表示未打开或队列已满
+     */
+    static bool submitBatch(const SnapshotBatchPtr &batch);
+
+    /**
+     * @brief 提交一条写语句
+     * @param sql 带?占位符的SQL，相同文本只预编译一次
+     * @param values 按顺序绑定的值
+     * @return false表示未打开或队列已满
+     */
+    static bool submit(const QString &sql, const QVariantList &values);
+
+    /**
+     * @brief 写入config表的一项（异步）
+     */
+    static bool writeConfig(const QString &key, const QString &value);
+
+    /**
+     * @brief 读取config表的一项
+     * @return Result 成功时data为值文本，不存在时返回错误
+     */
+    static Result readConfig(const QString &key);
+
+    /**
+     * @brief 获取写入统计
+     * @return Result 包含事务数、写入行数、写入速率（insertsPerSecond，按事务耗时计算）、
+     *         平均/最大/最近一次提交耗时（毫秒）、队列长度、队列满时丢弃的任务数（droppedJobs）、
+     *         重试MaxWriteAttempts次仍未写入的任务数（failedJobs）、最近的错误，
+     *         以及保留天数、已删除的过期行数、是否增量回收、已归还的页数和单步维护的最大耗时（毫秒）
+     */
+    static Result stats();
+};
+
+#endif // DATABASESERVICE_H
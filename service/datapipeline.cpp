@@ -0,0 +1,266 @@
+/**
+ * @file datapipeline.cpp
+ * @brief 采集数据处理流水线实现
+ */
+
+#include "datapipeline.h"
+#include "pollingscheduler.h"
+#include "realtimecache.h"
+#include "timeseriesstore.h"
+
+#include <cmath>
+
+DataPipeline::DataPipeline()
+    : m_valuesIn(0)
+    , m_valuesChanged(0)
+{
+}
+
+DataPipeline::~DataPipeline()
+{
+    for (const Entry &entry : m_entries) {
+        delete entry.stage;
+    }
+}
+
+void DataPipeline::addStage(PipelineStage *stage)
+{
+    QMutexLocker locker(&m_mutex);
+    Entry entry;
+    entry.stage = stage;
+    entry.stats.name = stage->name();
+    m_entries.append(entry);
+}
+
+bool DataPipeline::insertStageBefore(const QString &before, PipelineStage *stage)
+{
+    QMutexLocker locker(&m_mutex);
+    Entry entry;
+    entry.stage = stage;
+    entry.stats.name = stage->name();
+    for (int i = 0; i < m_entries.size(); ++i) {
+        if (m_entries[i].stats.name == before) {
+            m_entries.insert(i, entry);
+            return true;
+        }
+    }
+    m_entries.append(entry);
+    return false;
+}
+
+bool DataPipeline::removeStage(const QString &name)
+{
+    QMutexLocker locker(&m_mutex);
+    for (int i = 0; i < m_entries.size(); ++i) {
+        if (m_entries[i].stats.name == name) {
+            delete m_entries[i].stage;
+            m_entries.remove(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DataPipeline::process(PipelineFrame &frame)
+{
+    // 锁只与stats()竞争，各级都是微秒级操作
+    QMutexLocker locker(&m_mutex);
+    m_valuesIn += frame.snapshot->size();
+
+    for (Entry &entry : m_entries) {
+        qint64 start = PollingScheduler::monotonicNs();
+        bool passed = entry.stage->process(frame);
+        qint64 elapsed = PollingScheduler::monotonicNs() - start;
+
+        PipelineStageStats &s = entry.stats;
+        s.frames++;
+        s.totalNs += elapsed;
+        if (elapsed > s.maxNs) {
+            s.maxNs = elapsed;
+        }
+        if (!passed) {
+            s.dropped++;
+            return false;
+        }
+    }
+    m_valuesChanged += frame.snapshot->changed.size();
+    return true;
+}
+
+void DataPipeline::reset(int deviceId)
+{
+    QMutexLocker locker(&m_mutex);
+    for (const Entry &entry : m_entries) {
+        entry.stage->reset(deviceId);
+    }
+}
+
+PipelineStats DataPipeline::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    PipelineStats stats;
+    for (const Entry &entry : m_entries) {
+        stats.stages.append(entry.stats);
+    }
+    stats.valuesIn = m_valuesIn;
+    stats.valuesChanged = m_valuesChanged;
+    return stats;
+}
+
+bool ValidationStage::process(PipelineFrame &frame)
+{
+    RegisterSnapshot &s = *frame.snapshot;
+    int n = s.size();
+    if (!s.layout || s.layout->addresses.size() != n || s.bad.size() != n || s.timestampsNs.size() != n) {
+        return false;
+    }
+    for (int i = 0; i < n; ++i) {
+        if (!std::isfinite(s.values[i])) {
+            s.values[i] = 0.0;
+            s.bad.set(i);
+        }
+    }
+    return true;
+}
+
+bool ScalingStage::process(PipelineFrame &frame)
+{
+    RegisterSnapshot &s = *frame.snapshot;
+    const double *scales = s.layout->scales.constData();
+    const double *offsets = s.layout->offsets.constData();
+    double *values = s.values.data();
+    int n = s.size();
+    for (int i = 0; i < n; ++i) {
+        values[i] = values[i] * scales[i] + offsets[i];
+    }
+    return true;
+}
+
+bool DerivedStage::process(PipelineFrame &frame)
+{
+    RegisterSnapshot &s = *frame.snapshot;
+    const QVector<Formula> &formulas = s.layout->formulas;
+    if (formulas.isEmpty()) {
+        return true;
+    }
+
+    // 输入都没有标志时（绝大多数周期）不逐个检查输入
+    bool inputsFlagged = s.anyFlags();
+    double *values = s.values.data();
+    int base = s.layout->physicalCount;
+    for (int k = 0; k < formulas.size(); ++k) {
+        const Formula &formula = formulas[k];
+        int i = base + k;
+        values[i] = formula.evaluate(values);
+        if (!std::isfinite(values[i])) {
+            values[i] = 0.0;
+            s.bad.set(i);
+            inputsFlagged = true;   // 后面的派生点可能引用它
+        }
+        if (inputsFlagged) {
+            for (int input : formula.inputs()) {
+                if (s.bad.test(input)) {
+                    s.bad.set(i);
+                }
+                if (s.commLost.test(input)) {
+                    s.commLost.set(i);
+                }
+                if (s.stale.test(input)) {
+                    s.stale.set(i);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool RangeStage::process(PipelineFrame &frame)
+{
+    RegisterSnapshot &s = *frame.snapshot;
+    const double *lows = s.layout->rangeLows.constData();
+    const double *highs = s.layout->rangeHighs.constData();
+    const double *values = s.values.constData();
+    int n = s.size();
+    for (int i = 0; i < n; ++i) {
+        if (values[i] < lows[i] || values[i] > highs[i]) {
+            s.outOfRange.set(i);
+        }
+    }
+    return true;
+}
+
+DeadbandStage::DeadbandStage(qint64 maxSilenceMs)
+    : m_maxSilenceNs(maxSilenceMs * 1000000)
+{
+}
+
+bool DeadbandStage::process(PipelineFrame &frame)
+{
+    RegisterSnapshot &s = *frame.snapshot;
+    int n = s.size();
+    DeviceState &state = m_devices[frame.deviceId];
+    s.changed.clear();
+
+    // 首轮或采集任务重建（布局变化）后全部上报
+    if (state.layout != s.layout) {
+        state.layout = s.layout;
+        state.reported = s.values;
+        state.flags.resize(n);
+        state.flagged = 0;
+        state.reportedNs.fill(frame.nowNs, n);
+        s.changed.reserve(n);
+        for (int i = 0; i < n; ++i) {
+            state.flags[i] = s.flags(i);
+            state.flagged += state.flags[i] != 0;
+            s.changed.append(i);
+        }
+        return true;
+    }
+
+    // 上次和本轮都没有任何标志时（绝大多数周期）按字判断即可，不逐点组合标志
+    bool checkFlags = state.flagged > 0 || s.anyFlags();
+    const double *deadbands = s.layout->deadbands.constData();
+    for (int i = 0; i < n; ++i) {
+        double delta = std::fabs(s.values[i] - state.reported[i]);
+        bool changed = deadbands[i] > 0.0 ? delta > deadbands[i] : delta != 0.0;
+        quint8 flags = checkFlags ? s.flags(i) : 0;
+        if (changed || flags != state.flags[i]
+                || (m_maxSilenceNs > 0 && frame.nowNs - state.reportedNs[i] >= m_maxSilenceNs)) {
+            state.flagged += (flags != 0) - (state.flags[i] != 0);
+            state.reported[i] = s.values[i];
+            state.flags[i] = flags;
+            state.reportedNs[i] = frame.nowNs;
+            s.changed.append(i);
+        }
+    }
+    return true;
+}
+
+void DeadbandStage::reset(int deviceId)
+{
+    m_devices.remove(deviceId);
+}
+
+bool FanOutStage::process(PipelineFrame &frame)
+{
+    const RegisterSnapshot &s = *frame.snapshot;
+    const QVector<int> &cacheSlots = s.layout->cacheSlots;
+    bool anyFlags = s.anyFlags();
+    for (int i = 0; i < cacheSlots.size(); ++i) {
+        quint8 flags = anyFlags ? s.flags(i) : 0;
+        RealtimeCache::store(cacheSlots[i], s.values[i], s.timestampsNs[i], flags);
+        TimeSeriesStore::append(cacheSlots[i], s.values[i], s.timestampsNs[i], flags);
+    }
+
+    if (!s.changed.isEmpty()) {
+        for (const Sink &sink : m_sinks) {
+            sink(frame);
+        }
+    }
+    return true;
+}
+
+void FanOutStage::addSink(const Sink &sink)
+{
+    m_sinks.append(sink);
+}
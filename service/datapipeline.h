@@ -0,0 +1,248 @@
+/**
+ * @file datapipeline.h
+ * @brief 采集数据处理流水线定义
+ *
+ * 本文件定义了详细设计中的DataPipeline：采集任务解码出的原始值依次经过
+ * 校验 → 单位换算 → 派生点计算 → 量程检查 → 死区/变化上报过滤 → 分发。只有超出死区的值会被标记为变化，
+ * 没有任何变化的周期在分发级只刷新实时值缓存，不唤醒界面、告警和MQTT。
+ * 各级都实现PipelineStage接口，可增删替换，流水线记录每一级的耗时。
+ */
+
+#ifndef DATAPIPELINE_H
+#define DATAPIPELINE_H
+
+#include "registersnapshot.h"
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+/**
+ * @struct PipelineFrame
+ * @brief 流经流水线的一个设备的一轮采集
+ */
+struct PipelineFrame {
+    int deviceId;                                               ///< 设备ID
+    qint64 nowNs;                                               ///< 本轮采集时间（单调时钟纳秒）
+    QExplicitlySharedDataPointer<RegisterSnapshot> snapshot;    ///< 处理中的快照
+
+    PipelineFrame() : deviceId(-1), nowNs(0) {}
+};
+
+/**
+ * @class PipelineStage
+ * @brief 流水线级接口
+ *
+ * 实现类在采集线程中调用，同一实例不会被并发调用。
+ */
+class PipelineStage
+{
+public:
+    virtual ~PipelineStage() {}
+
+    /**
+     * @brief 级名称（用于统计和替换）
+     */
+    virtual QString name() const = 0;
+
+    /**
+     * @brief 处理一轮数据
+     * @param frame 数据帧，可修改其中的快照
+     * @return false表示丢弃该帧，后续各级不再处理
+     */
+    virtual bool process(PipelineFrame &frame) = 0;
+
+    /**
+     * @brief 丢弃设备的内部状态（设备通信失败或移出调度时调用）
+     * @param deviceId 设备ID
+     */
+    virtual void reset(int deviceId) { Q_UNUSED(deviceId) }
+};
+
+/**
+ * @struct PipelineStageStats
+ * @brief 单级统计
+ */
+struct PipelineStageStats {
+    QString name;       ///< 级名称
+    qint64 frames;      ///< 处理的帧数
+    qint64 dropped;     ///< 丢弃的帧数
+    qint64 totalNs;     ///< 累计耗时（纳秒）
+    qint64 maxNs;       ///< 最大单帧耗时（纳秒）
+
+    PipelineStageStats() : frames(0), dropped(0), totalNs(0), maxNs(0) {}
+};
+
+/**
+ * @struct PipelineStats
+ * @brief 流水线统计
+ */
+struct PipelineStats {
+    QList<PipelineStageStats> stages;   ///< 各级统计，按执行顺序
+    qint64 valuesIn;                    ///< 进入流水线的值个数
+    qint64 valuesChanged;               ///< 通过死区过滤的值个数
+
+    PipelineStats() : valuesIn(0), valuesChanged(0) {}
+};
+
+/**
+ * @class DataPipeline
+ * @brief 采集数据处理流水线
+ *
+ * process()由拥有它的采集线程调用；增删级和stats()可在任意线程调用。
+ */
+class DataPipeline
+{
+public:
+    DataPipeline();
+    ~DataPipeline();
+
+    /**
+     * @brief 在末尾追加一级（取得所有权）
+     */
+    void addStage(PipelineStage *stage);
+
+    /**
+     * @brief 在指定名称的级之前插入一级（取得所有权）
+     * @return false表示找不到该级，新级被追加到末尾
+     */
+    bool insertStageBefore(const QString &before, PipelineStage *stage);
+
+    /**
+     * @brief 移除并删除指定名称的级
+     * @return false表示找不到该级
+     */
+    bool removeStage(const QString &name);
+
+    /**
+     * @brief 依次执行各级
+     * @return false表示被某一级丢弃
+     */
+    bool process(PipelineFrame &frame);
+
+    /**
+     * @brief 通知各级丢弃设备的内部状态，下一轮成功采集的数据全部上报
+     * @param deviceId 设备ID
+     */
+    void reset(int deviceId);
+
+    /**
+     * @brief 获取统计快照
+     */
+    PipelineStats stats() const;
+
+private:
+    struct Entry {
+        PipelineStage *stage;
+        PipelineStageStats stats;
+    };
+
+    mutable QMutex m_mutex;         ///< 保护各级列表和统计
+    QVector<Entry> m_entries;       ///< 各级，按执行顺序
+    qint64 m_valuesIn;              ///< 进入流水线的值个数
+    qint64 m_valuesChanged;         ///< 通过死区过滤的值个数
+};
+
+/**
+ * @class ValidationStage
+ * @brief 校验级：快照与布局不一致时丢弃，非有限值（NaN、Inf）标记为无效
+ */
+class ValidationStage : public PipelineStage
+{
+public:
+    QString name() const override { return "validation"; }
+    bool process(PipelineFrame &frame) override;
+};
+
+/**
+ * @class ScalingStage
+ * @brief 单位换算级：工程值 = 原始值 × scale + offset
+ */
+class ScalingStage : public PipelineStage
+{
+public:
+    QString name() const override { return "scaling"; }
+    bool process(PipelineFrame &frame) override;
+};
+
+/**
+ * @class DerivedStage
+ * @brief 派生点计算级：按布局中编译好的公式计算派生点的值
+ *
+ * 结果非有限值时标记为无效；输入值无效、通信中断或过期时派生值带相同标志。
+ */
+class DerivedStage : public PipelineStage
+{
+public:
+    QString name() const override { return "derived"; }
+    bool process(PipelineFrame &frame) override;
+};
+
+/**
+ * @class RangeStage
+ * @brief 量程检查级：超出采集点量程的值标记为超量程（值保留）
+ */
+class RangeStage : public PipelineStage
+{
+public:
+    QString name() const override { return "range"; }
+    bool process(PipelineFrame &frame) override;
+};
+
+/**
+ * @class DeadbandStage
+ * @brief 死区/变化上报级
+ *
+ * 与上次上报的值相比，变化超过死区（死区为0时任何变化）或标志改变的值记入changed；
+ * 超过maxSilenceMs未上报的值也会被上报一次，让下游知道数据仍然有效。
+ */
+class DeadbandStage : public PipelineStage
+{
+public:
+    /**
+     * @param maxSilenceMs 最长不上报时间（毫秒），0表示不强制上报
+     */
+    explicit DeadbandStage(qint64 maxSilenceMs = 60000);
+
+    QString name() const override { return "deadband"; }
+    bool process(PipelineFrame &frame) override;
+    void reset(int deviceId) override;
+
+private:
+    struct DeviceState {
+        QSharedPointer<const RegisterLayout> layout;    ///< 布局变化时状态作废
+        QVector<double> reported;                       ///< 上次上报的值
+        QVector<quint8> flags;                          ///< 上次上报的标志
+        int flagged;                                    ///< flags中非0的个数，为0且本轮无标志时跳过逐点比较
+        QVector<qint64> reportedNs;                     ///< 上次上报时间（单调时钟纳秒）
+    };
+
+    qint64 m_maxSilenceNs;                  ///< 最长不上报时间（纳秒）
+    QHash<int, DeviceState> m_devices;      ///< 设备ID → 上报状态
+};
+
+/**
+ * @class FanOutStage
+ * @brief 分发级：所有值写入实时值缓存和历史存储，有变化时依次调用各下游
+ */
+class FanOutStage : public PipelineStage
+{
+public:
+    typedef std::function<void(const PipelineFrame &)> Sink;
+
+    QString name() const override { return "fanout"; }
+    bool process(PipelineFrame &frame) override;
+
+    /**
+     * @brief 添加下游（在采集线程中调用，不应阻塞）
+     */
+    void addSink(const Sink &sink);
+
+private:
+    QVector<Sink> m_sinks;      ///< 下游
+};
+
+#endif // DATAPIPELINE_H
@@ -7,12 +7,139 @@
  */
 
 #include "deviceservice.h"
+#include "busscanner.h"
+#include "eventbus.h"
+#include "modbusservice.h"
+#include "readplanner.h"
+#include "tcptransport.h"
+
+#include <QHash>
+
+#include <cmath>
 
 // 静态模拟设备列表
 static QVariantList s_deviceList;
 static int s_nextDeviceId = 1;
 static bool s_initialized = false;
 
+/**
+ * @brief 采集点列表转换为QVariantList存储
+ */
+static QVariantList pointsToVariant(const QVector<RegisterPoint> &points)
+{
+    QVariantList list;
+    for (const RegisterPoint &p : points) {
+        QVariantMap point;
+        point["functionCode"] = p.functionCode;
+        point["address"] = p.address;
+        point["count"] = p.count;
+        point["dataType"] = RegisterDecoder::typeName(p.dataType);
+        point["byteOrder"] = RegisterDecoder::orderName(p.byteOrder);
+        point["scale"] = p.scale;
+        point["offset"] = p.offset;
+        point["deadband"] = p.deadband;
+        if (std::isfinite(p.rangeLow)) {
+            point["rangeLow"] = p.rangeLow;
+        }
+        if (std::isfinite(p.rangeHigh)) {
+            point["rangeHigh"] = p.rangeHigh;
+        }
+        point["name"] = p.name;
+        point["unit"] = p.unit;
+        list.append(point);
+    }
+    return list;
+}
+
+/**
+ * @brief 从QVariantList恢复采集点列表
+ */
+static QVector<RegisterPoint> pointsFromVariant(const QVariant &value)
+{
+    QVector<RegisterPoint> points;
+    for (const QVariant &v : value.toList()) {
+        QVariantMap point = v.toMap();
+        RegisterPoint p(point["functionCode"].toInt(), point["address"].toInt(),
+                        point.value("count", 1).toInt());
+        RegisterDecoder::parseType(point.value("dataType").toString(), &p.dataType);
+        RegisterDecoder::parseOrder(point.value("byteOrder").toString(), &p.byteOrder);
+        p.scale = point.value("scale", 1.0).toDouble();
+        p.offset = point.value("offset", 0.0).toDouble();
+        p.deadband = point.value("deadband", 0.0).toDouble();
+        if (point.contains("rangeLow")) {
+            p.rangeLow = point["rangeLow"].toDouble();
+        }
+        if (point.contains("rangeHigh")) {
+            p.rangeHigh = point["rangeHigh"].toDouble();
+        }
+        p.name = point.value("name").toString();
+        p.unit = point.value("unit").toString();
+        points.append(p);
+    }
+    return points;
+}
+
+/**
+ * @brief 派生点列表转换为QVariantList存储
+ */
+static QVariantList derivedToVariant(const QVector<DerivedPoint> &points)
+{
+    QVariantList list;
+    for (const DerivedPoint &d : points) {
+        QVariantMap point;
+        point["address"] = d.address;
+        point["expression"] = d.expression;
+        point["deadband"] = d.deadband;
+        if (std::isfinite(d.rangeLow)) {
+            point["rangeLow"] = d.rangeLow;
+        }
+        if (std::isfinite(d.rangeHigh)) {
+            point["rangeHigh"] = d.rangeHigh;
+        }
+        point["name"] = d.name;
+        point["unit"] = d.unit;
+        list.append(point);
+    }
+    return list;
+}
+
+/**
+ * @brief 从QVariantList恢复派生点列表
+ */
+static QVector<DerivedPoint> derivedFromVariant(const QVariant &value)
+{
+    QVector<DerivedPoint> points;
+    for (const QVariant &v : value.toList()) {
+        QVariantMap point = v.toMap();
+        DerivedPoint d(point["address"].toInt(), point["expression"].toString(),
+                       point.value("name").toString(), point.value("unit").toString());
+        d.deadband = point.value("deadband", 0.0).toDouble();
+        if (point.contains("rangeLow")) {
+            d.rangeLow = point["rangeLow"].toDouble();
+        }
+        if (point.contains("rangeHigh")) {
+            d.rangeHigh = point["rangeHigh"].toDouble();
+        }
+        points.append(d);
+    }
+    return points;
+}
+
+/**
+ * @brief 构造带类型的采集点
+ */
+static RegisterPoint typedPoint(int fc, int addr, RegisterDecoder::DataType type, RegisterDecoder::ByteOrder order,
+                                double scale, const QString &name, const QString &unit)
+{
+    RegisterPoint p(fc, addr, RegisterDecoder::registerWidth(type));
+    p.dataType = type;
+    p.byteOrder = order;
+    p.scale = scale;
+    p.name = name;
+    p.unit = unit;
+    return p;
+}
+
 /**
  * @brief 初始化模拟数据
  */
@@ -33,6 +160,7 @@ static void initMockData()
     dev1["startAddress"] = 0;
     dev1["registerCount"] = 10;
     dev1["pollInterval"] = 1000;
+    dev1["priority"] = 0;
     s_deviceList.append(dev1);
 
     QVariantMap dev2;
@@ -46,6 +174,8 @@ static void initMockData()
     dev2["startAddress"] = 0;
     dev2["registerCount"] = 5;
     dev2["pollInterval"] = 2000;
+    dev2["points"] = pointsToVariant(QVector<RegisterPoint>()
+                                     << RegisterPoint(3, 0) << RegisterPoint(3, 3) << RegisterPoint(3, 7));
     s_deviceList.append(dev2);
 
     QVariantMap dev3;
@@ -59,7 +189,18 @@ static void initMockData()
     dev3["startAddress"] = 100;
     dev3["registerCount"] = 8;
     dev3["pollInterval"] = 1500;
+    dev3["points"] = pointsToVariant(QVector<RegisterPoint>()
+        << typedPoint(4, 100, RegisterDecoder::Float32, RegisterDecoder::CDAB, 1.0, "瞬时流量", "m³/h")
+        << typedPoint(4, 102, RegisterDecoder::UInt32, RegisterDecoder::CDAB, 0.1, "累计流量", "m³")
+        << typedPoint(4, 104, RegisterDecoder::Int16, RegisterDecoder::ABCD, 0.1, "介质温度", "℃"));
+    dev3["derivedPoints"] = derivedToVariant(QVector<DerivedPoint>()
+        << DerivedPoint(1000, "r100 / 3.6", "瞬时流量", "L/s"));
     s_deviceList.append(dev3);
+
+    for (const QVariant &v : s_deviceList) {
+        QVariantMap dev = v.toMap();
+        EventBus::instance()->publishDeviceAdded(dev["id"].toInt(), dev["online"].toBool());
+    }
 }
 
 Result DeviceService::getDeviceList()
@@ -83,9 +224,19 @@ Result DeviceService::addDevice(const DeviceConfig &cfg)
     dev["startAddress"] = cfg.startAddress;
     dev["registerCount"] = cfg.registerCount;
     dev["pollInterval"] = cfg.pollInterval;
+    dev["priority"] = cfg.priority;
     dev["remark"] = cfg.remark;
+    dev["points"] = pointsToVariant(cfg.points);
+    dev["derivedPoints"] = derivedToVariant(cfg.derivedPoints);
+    dev["gapThreshold"] = cfg.gapThreshold;
+    dev["busPort"] = cfg.busPort;
 
     s_deviceList.append(dev);
+    EventBus::instance()->publishDeviceAdded(dev["id"].toInt(), false);
+    BusScanner::instance()->invalidate(cfg.modbusAddress);
+    if (cfg.enabled) {
+        ModbusService::startPolling(dev["id"].toInt());
+    }
     return Result::success(dev["id"]);
 }
 
@@ -96,6 +247,8 @@ Result DeviceService::updateDevice(int id, const DeviceConfig &cfg)
     for (int i = 0; i < s_deviceList.size(); ++i) {
         QVariantMap dev = s_deviceList[i].toMap();
         if (dev["id"].toInt() == id) {
+            BusScanner::instance()->invalidate(dev["modbusAddress"].toInt());
+            BusScanner::instance()->invalidate(cfg.modbusAddress);
             dev["modbusAddress"] = cfg.modbusAddress;
             dev["name"] = cfg.name;
             dev["type"] = cfg.type;
@@ -103,8 +256,23 @@ Result DeviceService::updateDevice(int id, const DeviceConfig &cfg)
             dev["startAddress"] = cfg.startAddress;
             dev["registerCount"] = cfg.registerCount;
             dev["pollInterval"] = cfg.pollInterval;
+            dev["priority"] = cfg.priority;
             dev["remark"] = cfg.remark;
+            // 配置页不编辑采集点，未提供时保留原有采集点
+            if (!cfg.points.isEmpty()) {
+                dev["points"] = pointsToVariant(cfg.points);
+                dev["gapThreshold"] = cfg.gapThreshold;
+            }
+            if (!cfg.derivedPoints.isEmpty()) {
+                dev["derivedPoints"] = derivedToVariant(cfg.derivedPoints);
+            }
+            if (!cfg.busPort.isEmpty()) {
+                dev["busPort"] = cfg.busPort;
+            }
             s_deviceList[i] = dev;
+            if (ModbusService::isPolling(id)) {
+                ModbusService::startPolling(id);    // 按新的轮询间隔重新调度
+            }
             return Result::success();
         }
     }
@@ -117,19 +285,38 @@ Result DeviceService::removeDevice(int id)
 
     for (int i = 0; i < s_deviceList.size(); ++i) {
         if (s_deviceList[i].toMap()["id"].toInt() == id) {
+            BusScanner::instance()->invalidate(s_deviceList[i].toMap()["modbusAddress"].toInt());
             s_deviceList.removeAt(i);
+            EventBus::instance()->publishDeviceRemoved(id);
+            ModbusService::stopPolling(id);
             return Result::success();
         }
     }
     return Result::error(404, "设备不存在");
 }
 
+void DeviceService::setDeviceOnline(int id, bool online)
+{
+    initMockData();
+
+    for (int i = 0; i < s_deviceList.size(); ++i) {
+        QVariantMap dev = s_deviceList[i].toMap();
+        if (dev["id"].toInt() == id) {
+            if (dev["online"].toBool() != online) {
+                dev["online"] = online;
+                dev["status"] = online ? "在线" : "离线";
+                s_deviceList[i] = dev;
+            }
+            break;
+        }
+    }
+    EventBus::instance()->publishDeviceOnline(id, online);
+}
+
 Result DeviceService::scanModbusDevices()
 {
-    // 模拟扫描 - 返回发现的设备地址列表
-    QVariantList found;
-    found << 1 << 2 << 5 << 10;
-    return Result::success(found);
+    // 扫描由BusScanner在采集线程中异步执行，这里返回最近一次的结果
+    return BusScanner::instance()->cachedResult();
 }
 
 Result DeviceService::loadDeviceConfig(int id)
@@ -145,6 +332,34 @@ Result DeviceService::loadDeviceConfig(int id)
     return Result::error(404, "设备不存在");
 }
 
+bool DeviceService::getDeviceConfig(int id, DeviceConfig &cfg)
+{
+    initMockData();
+
+    for (const QVariant &v : s_deviceList) {
+        QVariantMap dev = v.toMap();
+        if (dev["id"].toInt() == id) {
+            cfg.id = id;
+            cfg.modbusAddress = dev["modbusAddress"].toInt();
+            cfg.functionCode = dev["functionCode"].toInt();
+            cfg.startAddress = dev["startAddress"].toInt();
+            cfg.registerCount = dev["registerCount"].toInt();
+            cfg.pollInterval = dev["pollInterval"].toInt();
+            cfg.priority = dev.value("priority", 1).toInt();
+            cfg.name = dev["name"].toString();
+            cfg.type = dev["type"].toString();
+            cfg.remark = dev["remark"].toString();
+            cfg.enabled = dev.value("enabled", true).toBool();
+            cfg.points = pointsFromVariant(dev["points"]);
+            cfg.derivedPoints = derivedFromVariant(dev["derivedPoints"]);
+            cfg.gapThreshold = dev.value("gapThreshold", 8).toInt();
+            cfg.busPort = dev.value("busPort").toString();
+            return true;
+        }
+    }
+    return false;
+}
+
 Result DeviceService::saveDeviceConfig(int id, const DeviceConfig &cfg)
 {
     if (id < 0) {
@@ -170,5 +385,88 @@ Result DeviceService::validateConfig(const DeviceConfig &cfg)
     if (cfg.pollInterval < 100 || cfg.pollInterval > 60000) {
         return Result::error(5, "轮询间隔必须在100-60000毫秒之间");
     }
+    if (cfg.priority < 0 || cfg.priority > 2) {
+        return Result::error(17, "优先级必须是0（关键）、1（常规）或2（诊断）");
+    }
+    for (const RegisterPoint &p : cfg.points) {
+        if (p.functionCode < 1 || p.functionCode > 4) {
+            return Result::error(6, QString("采集点%1的功能码无效").arg(p.address));
+        }
+        if (p.count < 1 || p.count > 125 || p.address < 0 || p.address + p.count > 65536) {
+            return Result::error(7, QString("采集点%1的地址或数量无效").arg(p.address));
+        }
+        if (p.functionCode <= 2 && p.dataType != RegisterDecoder::UInt16) {
+            return Result::error(10, QString("采集点%1为位读取，数据类型只能是uint16").arg(p.address));
+        }
+        if (p.count % RegisterDecoder::registerWidth(p.dataType) != 0) {
+            return Result::error(11, QString("采集点%1的数量不是%2所占寄存器数的整数倍")
+                                 .arg(p.address).arg(RegisterDecoder::typeName(p.dataType)));
+        }
+        if (p.scale == 0.0) {
+            return Result::error(12, QString("采集点%1的系数不能为0").arg(p.address));
+        }
+        if (p.deadband < 0.0) {
+            return Result::error(13, QString("采集点%1的死区不能为负数").arg(p.address));
+        }
+        if (!(p.rangeLow <= p.rangeHigh)) {
+            return Result::error(14, QString("采集点%1的量程下限大于上限").arg(p.address));
+        }
+    }
+    for (const DerivedPoint &d : cfg.derivedPoints) {
+        if (d.deadband < 0.0) {
+            return Result::error(13, QString("派生点%1的死区不能为负数").arg(d.address));
+        }
+        if (!(d.rangeLow <= d.rangeHigh)) {
+            return Result::error(14, QString("派生点%1的量程下限大于上限").arg(d.address));
+        }
+    }
+    if (!cfg.derivedPoints.isEmpty()) {
+        QVector<int> addresses;
+        for (const RegisterPoint &p : ReadPlanner::devicePoints(cfg)) {
+            int width = RegisterDecoder::registerWidth(p.dataType);
+            for (int k = 0; k < p.valueCount(); ++k) {
+                addresses.append(p.address + k * width);
+            }
+        }
+        QVector<Formula> formulas;
+        Result compiled = compileDerivedPoints(cfg, addresses, &formulas);
+        if (!compiled.isSuccess()) {
+            return compiled;
+        }
+    }
+    if (cfg.gapThreshold < 0 || cfg.gapThreshold > 124) {
+        return Result::error(8, "合并空洞阈值必须在0-124之间");
+    }
+    if (TcpTransport::isEndpoint(cfg.busPort)
+            && !TcpTransport::parseEndpoint(cfg.busPort, nullptr, nullptr, nullptr)) {
+        return Result::error(9, "TCP地址格式应为 tcp://主机:端口 或 rtutcp://主机:端口");
+    }
+    return Result::success();
+}
+
+Result DeviceService::compileDerivedPoints(const DeviceConfig &cfg, const QVector<int> &addresses,
+                                           QVector<Formula> *formulas)
+{
+    // 同一地址出现多次（不同功能码）时引用第一个
+    QHash<int, int> indexOf;
+    for (int i = addresses.size() - 1; i >= 0; --i) {
+        indexOf.insert(addresses[i], i);
+    }
+    Formula::Resolver resolve = [&indexOf](int address) { return indexOf.value(address, -1); };
+
+    formulas->clear();
+    for (int k = 0; k < cfg.derivedPoints.size(); ++k) {
+        const DerivedPoint &d = cfg.derivedPoints[k];
+        if (indexOf.contains(d.address)) {
+            return Result::error(15, QString("派生点%1的地址与其他点重复").arg(d.address));
+        }
+        Formula formula;
+        Result result = Formula::compile(d.expression, resolve, &formula);
+        if (!result.isSuccess()) {
+            return Result::error(16, QString("派生点%1的公式有误，%2").arg(d.address).arg(result.message));
+        }
+        formulas->append(formula);
+        indexOf.insert(d.address, addresses.size() + k);    // 之后的派生点可以引用它
+    }
     return Result::success();
 }
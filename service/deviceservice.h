@@ -10,6 +10,72 @@
 #define DEVICESERVICE_H
 
 #include "../common/result.h"
+#include "formula.h"
+#include "registerdecoder.h"
+
+#include <QVector>
+#include <limits>
+
+/**
+ * @struct RegisterPoint
+ * @brief 设备上需要采集的一个数据点
+ */
+struct RegisterPoint {
+    int functionCode;       ///< 功能码（01-04）
+    int address;            ///< 起始寄存器/位地址
+    int count;              ///< 占用的寄存器/位数量（为数据类型寄存器数的整数倍）
+    RegisterDecoder::DataType dataType;     ///< 数据类型（位读取只能为UInt16）
+    RegisterDecoder::ByteOrder byteOrder;   ///< 字节序
+    double scale;           ///< 系数，工程值 = 原始值 × scale + offset
+    double offset;          ///< 偏移
+    double deadband;        ///< 死区（工程值），变化不超过死区时不上报，0表示任何变化都上报
+    double rangeLow;        ///< 量程下限（工程值），超出时标记超量程，-inf表示不检查
+    double rangeHigh;       ///< 量程上限（工程值），+inf表示不检查
+    QString name;           ///< 名称（为空时显示"寄存器 地址"）
+    QString unit;           ///< 单位
+
+    RegisterPoint()
+        : functionCode(3), address(0), count(1), dataType(RegisterDecoder::UInt16),
+          byteOrder(RegisterDecoder::ABCD), scale(1.0), offset(0.0), deadband(0.0),
+          rangeLow(-std::numeric_limits<double>::infinity()),
+          rangeHigh(std::numeric_limits<double>::infinity()) {}
+    RegisterPoint(int fc, int addr, int n = 1)
+        : functionCode(fc), address(addr), count(n), dataType(RegisterDecoder::UInt16),
+          byteOrder(RegisterDecoder::ABCD), scale(1.0), offset(0.0), deadband(0.0),
+          rangeLow(-std::numeric_limits<double>::infinity()),
+          rangeHigh(std::numeric_limits<double>::infinity()) {}
+
+    /**
+     * @brief 点内值的个数
+     */
+    int valueCount() const { return count / RegisterDecoder::registerWidth(dataType); }
+};
+
+/**
+ * @struct DerivedPoint
+ * @brief 由公式计算的派生点（如功率 = 电压 × 电流）
+ *
+ * 派生点占用一个虚拟地址，在监控页、实时值、历史和告警中与寄存器点一样按地址引用。
+ * 公式语法见Formula，只能引用本设备的寄存器点和排在它之前的派生点。
+ */
+struct DerivedPoint {
+    int address;            ///< 虚拟地址，不能与本设备的寄存器点或其他派生点重复
+    QString expression;     ///< 公式，如 "r100 * r102 / 1000"
+    double deadband;        ///< 死区（工程值），0表示任何变化都上报
+    double rangeLow;        ///< 量程下限，-inf表示不检查
+    double rangeHigh;       ///< 量程上限，+inf表示不检查
+    QString name;           ///< 名称（为空时显示"派生 地址"）
+    QString unit;           ///< 单位
+
+    DerivedPoint()
+        : address(0), deadband(0.0),
+          rangeLow(-std::numeric_limits<double>::infinity()),
+          rangeHigh(std::numeric_limits<double>::infinity()) {}
+    DerivedPoint(int addr, const QString &expr, const QString &n = QString(), const QString &u = QString())
+        : address(addr), expression(expr), deadband(0.0),
+          rangeLow(-std::numeric_limits<double>::infinity()),
+          rangeHigh(std::numeric_limits<double>::infinity()), name(n), unit(u) {}
+};
 
 /**
  * @struct DeviceConfig
@@ -22,14 +88,20 @@ struct DeviceConfig {
     int startAddress;       ///< 起始寄存器地址
     int registerCount;      ///< 寄存器数量
     int pollInterval;       ///< 轮询间隔（毫秒）
+    int priority;           ///< 调度优先级（PollingScheduler::Priority：0关键、1常规、2诊断）
     QString name;           ///< 设备名称
     QString type;           ///< 设备类型
     QString remark;         ///< 备注信息
     bool enabled;           ///< 是否启用
+    QVector<RegisterPoint> points;  ///< 离散采集点（为空时采集startAddress起的registerCount个寄存器）
+    QVector<DerivedPoint> derivedPoints;    ///< 派生点，每轮采集后按顺序计算
+    int gapThreshold;       ///< 合并读取时允许填充的最大空洞（寄存器数），0表示只合并相邻点
+    QString busPort;        ///< 所在总线：串口设备文件，或 tcp://主机:端口（Modbus TCP）、
+                            ///< rtutcp://主机:端口（RTU over TCP）、sim://（模拟从站）；为空表示默认串口总线
 
     DeviceConfig()
         : id(-1), modbusAddress(1), functionCode(3), startAddress(0),
-          registerCount(10), pollInterval(1000), enabled(true) {}
+          registerCount(10), pollInterval(1000), priority(1), enabled(true), gapThreshold(8) {}
 };
 
 /**
@@ -70,7 +142,16 @@ public:
     static Result removeDevice(int id);
 
     /**
-     * @brief 扫描RS485总线上的Modbus设备
+     * @brief 更新设备在线状态（采集结果在线/离线切换时调用，并推送到EventBus）
+     * @param id 设备ID
+     * @param online true表示在线
+     */
+    static void setDeviceOnline(int id, bool online);
+
+    /**
+     * @brief 获取最近一次RS485总线扫描发现的Modbus设备
+     *
+     * 扫描本身由BusScanner异步执行（进度、取消通过其信号和接口）。
      * @return Result 包含发现的设备地址列表
      */
     static Result scanModbusDevices();
@@ -82,6 +163,14 @@ public:
      */
     static Result loadDeviceConfig(int id);
 
+    /**
+     * @brief 获取指定设备的配置结构体（供采集链路使用）
+     * @param id 设备ID
+     * @param cfg 输出的设备配置
+     * @return true表示找到该设备
+     */
+    static bool getDeviceConfig(int id, DeviceConfig &cfg);
+
     /**
      * @brief 保存设备配置（新增或更新）
      * @param id 设备ID（-1表示新增）
@@ -96,6 +185,16 @@ public:
      * @return Result 校验结果，失败时包含错误信息
      */
     static Result validateConfig(const DeviceConfig &cfg);
+
+    /**
+     * @brief 编译设备的派生点公式
+     * @param cfg 设备配置
+     * @param addresses 寄存器点各值的地址（按快照下标），派生点的值依次排在其后
+     * @param formulas 输出与cfg.derivedPoints一一对应的编译结果
+     * @return Result 失败时指出第一个地址重复或公式有误的派生点
+     */
+    static Result compileDerivedPoints(const DeviceConfig &cfg, const QVector<int> &addresses,
+                                       QVector<Formula> *formulas);
 };
 
 #endif // DEVICESERVICE_H
@@ -0,0 +1,81 @@
+/**
+ * @file eventbus.cpp
+ * @brief 状态事件总线实现
+ */
+
+#include "eventbus.h"
+
+EventBus *EventBus::instance()
+{
+    static EventBus s_instance;
+    return &s_instance;
+}
+
+EventBus::EventBus(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void EventBus::publishDeviceAdded(int deviceId, bool online)
+{
+    if (m_deviceOnline.contains(deviceId)) {
+        publishDeviceOnline(deviceId, online);
+        return;
+    }
+
+    m_deviceOnline.insert(deviceId, online);
+    m_counters.deviceTotal++;
+    if (online) {
+        m_counters.deviceOnline++;
+    }
+    emit deviceCountChanged(m_counters.deviceOnline, m_counters.deviceTotal);
+}
+
+void EventBus::publishDeviceRemoved(int deviceId)
+{
+    auto it = m_deviceOnline.find(deviceId);
+    if (it == m_deviceOnline.end()) {
+        return;
+    }
+
+    if (*it) {
+        m_counters.deviceOnline--;
+    }
+    m_counters.deviceTotal--;
+    m_deviceOnline.erase(it);
+    emit deviceCountChanged(m_counters.deviceOnline, m_counters.deviceTotal);
+}
+
+void EventBus::publishDeviceOnline(int deviceId, bool online)
+{
+    auto it = m_deviceOnline.find(deviceId);
+    if (it == m_deviceOnline.end() || *it == online) {
+        return;
+    }
+
+    *it = online;
+    m_counters.deviceOnline += online ? 1 : -1;
+    emit deviceOnlineChanged(deviceId, online);
+    emit deviceCountChanged(m_counters.deviceOnline, m_counters.deviceTotal);
+}
+
+void EventBus::publishAlarmDelta(int activeDelta, int totalDelta)
+{
+    if (activeDelta == 0 && totalDelta == 0) {
+        return;
+    }
+
+    m_counters.alarmActive += activeDelta;
+    m_counters.alarmTotal += totalDelta;
+    emit alarmCountChanged(m_counters.alarmActive, m_counters.alarmTotal);
+}
+
+void EventBus::publishCommRate(int percent)
+{
+    if (m_counters.commRate == percent) {
+        return;
+    }
+
+    m_counters.commRate = percent;
+    emit commRateChanged(percent);
+}
@@ -0,0 +1,113 @@
+/**
+ * @file eventbus.h
+ * @brief 状态事件总线定义
+ *
+ * 本文件定义了EventBus：各服务在状态变化时推送增量（设备上下线、设备增删、
+ * 告警数量变化、通信正常率变化），总线维护汇总计数并以带类型的信号转发。
+ * 页面在可见期间连接这些信号，不再定时查询服务、遍历整个列表来计数。
+ */
+
+#ifndef EVENTBUS_H
+#define EVENTBUS_H
+
+#include <QObject>
+#include <QHash>
+
+/**
+ * @struct StatusCounters
+ * @brief 汇总计数（由各服务推送的增量累加得到）
+ */
+struct StatusCounters {
+    int deviceTotal;        ///< 设备总数
+    int deviceOnline;       ///< 在线设备数
+    int alarmTotal;         ///< 告警总数
+    int alarmActive;        ///< 未确认的告警数
+    int commRate;           ///< 通信正常率（百分比），-1表示尚无采集设备
+
+    StatusCounters()
+        : deviceTotal(0), deviceOnline(0), alarmTotal(0), alarmActive(0), commRate(-1) {}
+};
+
+/**
+ * @class EventBus
+ * @brief 状态事件总线（单例，界面线程使用）
+ *
+ * publish*()只在状态真正变化时发出信号，计数按增量维护，每次发布都是O(1)。
+ */
+class EventBus : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 获取单例
+     */
+    static EventBus *instance();
+
+    /**
+     * @brief 获取当前汇总计数（订阅者开始订阅时用来初始化显示）
+     */
+    StatusCounters counters() const { return m_counters; }
+
+    /**
+     * @brief 设备加入设备列表
+     * @param deviceId 设备ID
+     * @param online 初始在线状态
+     */
+    void publishDeviceAdded(int deviceId, bool online);
+
+    /**
+     * @brief 设备从设备列表删除
+     * @param deviceId 设备ID
+     */
+    void publishDeviceRemoved(int deviceId);
+
+    /**
+     * @brief 设备在线状态（状态未变时忽略）
+     * @param deviceId 设备ID
+     * @param online true表示在线
+     */
+    void publishDeviceOnline(int deviceId, bool online);
+
+    /**
+     * @brief 告警数量变化
+     * @param activeDelta 未确认告警数的增量
+     * @param totalDelta 告警总数的增量
+     */
+    void publishAlarmDelta(int activeDelta, int totalDelta);
+
+    /**
+     * @brief 通信正常率（与上次相同时忽略）
+     * @param percent 百分比，-1表示尚无采集设备
+     */
+    void publishCommRate(int percent);
+
+signals:
+    /**
+     * @brief 单个设备上线或离线
+     */
+    void deviceOnlineChanged(int deviceId, bool online);
+
+    /**
+     * @brief 在线设备数或设备总数变化
+     */
+    void deviceCountChanged(int online, int total);
+
+    /**
+     * @brief 告警数量变化
+     */
+    void alarmCountChanged(int active, int total);
+
+    /**
+     * @brief 通信正常率变化
+     */
+    void commRateChanged(int percent);
+
+private:
+    explicit EventBus(QObject *parent = nullptr);
+
+    QHash<int, bool> m_deviceOnline;    ///< 设备ID → 在线状态
+    StatusCounters m_counters;          ///< 汇总计数
+};
+
+#endif // EVENTBUS_H
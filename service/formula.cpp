@@ -0,0 +1,323 @@
+/**
+ * @file formula.cpp
+ * @brief 派生点公式实现
+ *
+ * 本文件实现了公式的递归下降编译和字节码求值。编译时同步计算栈深度，
+ * 求值时使用固定大小的局部数组作为栈。
+ */
+
+#include "formula.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/**
+ * @struct Formula::Compiler
+ * @brief 递归下降编译器
+ *
+ * expr  := term (('+' | '-') term)*
+ * term  := unary (('*' | '/') unary)*
+ * unary := '-' unary | primary
+ * primary := number | 'r' address | function '(' expr (',' expr)* ')' | '(' expr ')'
+ */
+struct Formula::Compiler {
+    const QString &text;
+    const Resolver &resolve;
+    Formula &out;
+    int pos;
+    int depth;
+    int maxDepth;
+    QString error;
+
+    Compiler(const QString &t, const Resolver &r, Formula &f)
+        : text(t), resolve(r), out(f), pos(0), depth(0), maxDepth(0) {}
+
+    bool fail(const QString &message)
+    {
+        if (error.isEmpty()) {
+            error = QString("第%1个字符处：%2").arg(pos + 1).arg(message);
+        }
+        return false;
+    }
+
+    void skipSpaces()
+    {
+        while (pos < text.size() && text[pos].isSpace()) {
+            pos++;
+        }
+    }
+
+    bool accept(QChar c)
+    {
+        skipSpaces();
+        if (pos < text.size() && text[pos] == c) {
+            pos++;
+            return true;
+        }
+        return false;
+    }
+
+    void emitOp(OpCode code, int index = 0, int argc = 0)
+    {
+        Op op;
+        op.code = code;
+        op.argc = static_cast<quint8>(argc);
+        op.index = index;
+        out.m_ops.append(op);
+
+        // 压栈+1，二元运算-1，n元函数-(n-1)，一元运算不变
+        if (code == PushConst || code == PushValue) {
+            depth++;
+        } else if (code == Add || code == Sub || code == Mul || code == Div) {
+            depth--;
+        } else if (code == Min || code == Max || code == Sum || code == Avg) {
+            depth -= argc - 1;
+        }
+        maxDepth = qMax(maxDepth, depth);
+    }
+
+    bool parseExpr()
+    {
+        if (!parseTerm()) {
+            return false;
+        }
+        for (;;) {
+            if (accept('+')) {
+                if (!parseTerm()) return false;
+                emitOp(Add);
+            } else if (accept('-')) {
+                if (!parseTerm()) return false;
+                emitOp(Sub);
+            } else {
+                return true;
+            }
+        }
+    }
+
+    bool parseTerm()
+    {
+        if (!parseUnary()) {
+            return false;
+        }
+        for (;;) {
+            if (accept('*')) {
+                if (!parseUnary()) return false;
+                emitOp(Mul);
+            } else if (accept('/')) {
+                if (!parseUnary()) return false;
+                emitOp(Div);
+            } else {
+                return true;
+            }
+        }
+    }
+
+    bool parseUnary()
+    {
+        if (accept('-')) {
+            if (!parseUnary()) return false;
+            emitOp(Neg);
+            return true;
+        }
+        return parsePrimary();
+    }
+
+    bool parsePrimary()
+    {
+        skipSpaces();
+        if (pos >= text.size()) {
+            return fail("缺少操作数");
+        }
+        if (accept('(')) {
+            if (!parseExpr()) return false;
+            return accept(')') || fail("缺少右括号");
+        }
+
+        QChar c = text[pos];
+        if (c.isDigit() || c == '.') {
+            return parseNumber();
+        }
+        if (!c.isLetter()) {
+            return fail(QString("不能识别字符'%1'").arg(c));
+        }
+
+        int start = pos;
+        while (pos < text.size() && text[pos].isLetterOrNumber()) {
+            pos++;
+        }
+        QString word = text.mid(start, pos - start);
+
+        // r<地址>：引用本设备的值
+        if (word.size() > 1 && word[0] == 'r') {
+            bool ok;
+            int address = word.mid(1).toInt(&ok);
+            if (ok) {
+                int index = resolve(address);
+                if (index < 0) {
+                    pos = start;
+                    return fail(QString("引用的地址%1不存在").arg(address));
+                }
+                if (!out.m_inputs.contains(index)) {
+                    out.m_inputs.append(index);
+                }
+                emitOp(PushValue, index);
+                return true;
+            }
+        }
+
+        OpCode code;
+        int minArgs = 1;
+        int maxArgs = MaxArguments;
+        if (word == "abs") {
+            code = Abs;
+            maxArgs = 1;
+        } else if (word == "sqrt") {
+            code = Sqrt;
+            maxArgs = 1;
+        } else if (word == "min") {
+            code = Min;
+        } else if (word == "max") {
+            code = Max;
+        } else if (word == "sum") {
+            code = Sum;
+        } else if (word == "avg") {
+            code = Avg;
+        } else {
+            pos = start;
+            return fail(QString("未知的名称'%1'").arg(word));
+        }
+
+        if (!accept('(')) {
+            return fail(QString("函数%1后缺少左括号").arg(word));
+        }
+        int argc = 0;
+        do {
+            if (!parseExpr()) return false;
+            argc++;
+        } while (accept(','));
+        if (!accept(')')) {
+            return fail("缺少右括号");
+        }
+        if (argc < minArgs || argc > maxArgs) {
+            return fail(QString("函数%1的参数个数不对").arg(word));
+        }
+        emitOp(code, 0, argc);
+        return true;
+    }
+
+    bool parseNumber()
+    {
+        int start = pos;
+        while (pos < text.size() && (text[pos].isDigit() || text[pos] == '.')) {
+            pos++;
+        }
+        if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+            int mark = pos++;
+            if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+                pos++;
+            }
+            if (pos >= text.size() || !text[pos].isDigit()) {
+                pos = mark;     // 不是指数，e留给后面报错
+            }
+            while (pos < text.size() && text[pos].isDigit()) {
+                pos++;
+            }
+        }
+        bool ok;
+        double value = text.mid(start, pos - start).toDouble(&ok);
+        if (!ok) {
+            pos = start;
+            return fail("数字格式错误");
+        }
+        out.m_constants.append(value);
+        emitOp(PushConst, out.m_constants.size() - 1);
+        return true;
+    }
+};
+
+Result Formula::compile(const QString &text, const Resolver &resolve, Formula *formula)
+{
+    Formula f;
+    Compiler compiler(text, resolve, f);
+    bool ok = compiler.parseExpr();
+    compiler.skipSpaces();
+    if (ok && compiler.pos < text.size()) {
+        ok = compiler.fail("有多余的内容");
+    }
+    if (!ok) {
+        return Result::error(1, compiler.error);
+    }
+    if (compiler.maxDepth > MaxStackDepth) {
+        return Result::error(2, QString("公式嵌套过深（超过%1层）").arg(int(MaxStackDepth)));
+    }
+    std::sort(f.m_inputs.begin(), f.m_inputs.end());
+    *formula = f;
+    return Result::success();
+}
+
+double Formula::evaluate(const double *values) const
+{
+    double stack[MaxStackDepth];
+    int top = -1;
+    const double *constants = m_constants.constData();
+
+    for (const Op &op : m_ops) {
+        switch (op.code) {
+        case PushConst:
+            stack[++top] = constants[op.index];
+            break;
+        case PushValue:
+            stack[++top] = values[op.index];
+            break;
+        case Add:
+            top--;
+            stack[top] += stack[top + 1];
+            break;
+        case Sub:
+            top--;
+            stack[top] -= stack[top + 1];
+            break;
+        case Mul:
+            top--;
+            stack[top] *= stack[top + 1];
+            break;
+        case Div:
+            top--;
+            stack[top] /= stack[top + 1];
+            break;
+        case Neg:
+            stack[top] = -stack[top];
+            break;
+        case Abs:
+            stack[top] = std::fabs(stack[top]);
+            break;
+        case Sqrt:
+            stack[top] = std::sqrt(stack[top]);
+            break;
+        case Min:
+        case Max:
+        case Sum:
+        case Avg: {
+            int first = top - op.argc + 1;
+            double r = stack[first];
+            for (int i = first + 1; i <= top; ++i) {
+                if (op.code == Min) {
+                    r = qMin(r, stack[i]);
+                } else if (op.code == Max) {
+                    r = qMax(r, stack[i]);
+                } else {
+                    r += stack[i];
+                }
+            }
+            if (op.code == Avg) {
+                r /= op.argc;
+            }
+            top = first;
+            stack[top] = r;
+            break;
+        }
+        }
+    }
+    return top == 0 ? stack[0] : std::numeric_limits<double>::quiet_NaN();
+}
@@ -0,0 +1,86 @@
+/**
+ * @file formula.h
+ * @brief 派生点公式定义
+ *
+ * 本文件定义了Formula：派生点（如功率 = 电压 × 电流、多个传感器的平均值）的公式
+ * 在采集任务构造时编译一次为后缀字节码，变量直接替换为快照中的值下标，
+ * 之后每轮采集只在固定大小的栈上执行字节码，不再解析字符串，也不分配内存。
+ *
+ * 公式语法：
+ * - 变量：r<地址>，引用本设备该地址的值（换算后的工程值），如 r100
+ * - 常量：十进制数，可带小数和指数，如 3.6、1e3
+ * - 运算：+ - * /、一元负号、括号
+ * - 函数：abs(x)、sqrt(x)、min(...)、max(...)、sum(...)、avg(...)
+ */
+
+#ifndef FORMULA_H
+#define FORMULA_H
+
+#include "../common/result.h"
+
+#include <QString>
+#include <QVector>
+#include <functional>
+
+/**
+ * @class Formula
+ * @brief 编译后的公式（值语义，只读时可在多个线程共享）
+ */
+class Formula
+{
+public:
+    enum Limits {
+        MaxStackDepth = 32,     ///< 求值栈深度上限，超过时编译失败
+        MaxArguments = 255      ///< 函数参数个数上限
+    };
+
+    /**
+     * @brief 变量解析：地址 → 值下标，-1表示没有该地址
+     */
+    typedef std::function<int(int address)> Resolver;
+
+    /**
+     * @brief 编译公式
+     * @param text 公式文本
+     * @param resolve 变量解析函数
+     * @param formula 成功时输出编译结果
+     * @return Result 失败时message指出出错位置
+     */
+    static Result compile(const QString &text, const Resolver &resolve, Formula *formula);
+
+    /**
+     * @brief 按值数组求值
+     * @param values 快照值数组，下标与编译时解析的一致
+     * @return 结果，未编译或运算结果非法时为NaN或Inf（由调用者标记为无效）
+     */
+    double evaluate(const double *values) const;
+
+    /**
+     * @brief 公式引用的值下标（去重、升序），用于传递输入值的标志
+     */
+    const QVector<int> &inputs() const { return m_inputs; }
+
+    /**
+     * @brief 是否已成功编译
+     */
+    bool isValid() const { return !m_ops.isEmpty(); }
+
+private:
+    enum OpCode : quint8 {
+        PushConst, PushValue, Add, Sub, Mul, Div, Neg, Abs, Sqrt, Min, Max, Sum, Avg
+    };
+
+    struct Op {
+        OpCode code;    ///< 操作码
+        quint8 argc;    ///< 函数参数个数（Min/Max/Sum/Avg）
+        int index;      ///< PushConst为常量下标，PushValue为值下标
+    };
+
+    struct Compiler;
+
+    QVector<Op> m_ops;              ///< 后缀字节码
+    QVector<double> m_constants;    ///< 常量表
+    QVector<int> m_inputs;          ///< 引用的值下标
+};
+
+#endif // FORMULA_H
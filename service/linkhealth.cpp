@@ -0,0 +1,63 @@
+/**
+ * @file linkhealth.cpp
+ * @brief 设备链路健康度实现
+ */
+
+#include "linkhealth.h"
+
+LinkHealth::LinkHealth()
+    : m_failures(0)
+    , m_backoffMs(0)
+    , m_backoffUntilNs(0)
+{
+}
+
+void LinkHealth::recordRtt(qint64 rttUs)
+{
+    m_rtt.record(rttUs);
+}
+
+void LinkHealth::recordSuccess()
+{
+    m_failures = 0;
+    m_backoffMs = 0;
+    m_backoffUntilNs = 0;
+}
+
+void LinkHealth::recordFailure(qint64 nowNs, int intervalMs)
+{
+    m_failures++;
+    if (m_failures < BackoffAfterFailures) {
+        return;
+    }
+
+    // 退避时长从一个轮询间隔开始，每多失败一次翻倍
+    int shift = qMin(m_failures - BackoffAfterFailures, 16);
+    qint64 backoffMs = static_cast<qint64>(qMax(intervalMs, 1)) << shift;
+    m_backoffMs = static_cast<int>(qMin<qint64>(backoffMs, MaxBackoffMs));
+    m_backoffUntilNs = nowNs + static_cast<qint64>(m_backoffMs) * 1000000LL;
+}
+
+int LinkHealth::timeoutMs(int ceilingMs) const
+{
+    if (m_failures > 0 || m_rtt.count() < MinSamples) {
+        return ceilingMs;
+    }
+
+    qint64 adaptiveMs = (m_rtt.percentileUs(0.99) * TimeoutFactor + 999) / 1000;
+    return static_cast<int>(qBound<qint64>(qMin<qint64>(MinTimeoutMs, ceilingMs), adaptiveMs, ceilingMs));
+}
+
+LinkStats LinkHealth::stats(int deviceId, int ceilingMs) const
+{
+    LinkStats s;
+    s.deviceId = deviceId;
+    s.samples = m_rtt.count();
+    s.p50Us = m_rtt.percentileUs(0.50);
+    s.p90Us = m_rtt.percentileUs(0.90);
+    s.p99Us = m_rtt.percentileUs(0.99);
+    s.timeoutMs = timeoutMs(ceilingMs);
+    s.consecutiveFailures = m_failures;
+    s.backoffMs = m_backoffMs;
+    return s;
+}
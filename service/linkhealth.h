@@ -0,0 +1,100 @@
+/**
+ * @file linkhealth.h
+ * @brief 设备链路健康度定义
+ *
+ * 本文件定义了LinkHealth：根据设备的往返时间直方图自适应计算响应超时
+ * （p99 × 系数，并限制在下限和全局通信超时之间），并对连续通信失败的设备
+ * 按指数退避暂停轮询，避免一台离线仪表每个周期都占用整个超时时间的总线。
+ */
+
+#ifndef LINKHEALTH_H
+#define LINKHEALTH_H
+
+#include "rtthistogram.h"
+
+/**
+ * @struct LinkStats
+ * @brief 单个设备的链路统计快照
+ */
+struct LinkStats {
+    int deviceId;               ///< 设备ID
+    quint32 samples;            ///< 直方图样本数
+    qint64 p50Us;               ///< 往返时间中位数（微秒）
+    qint64 p90Us;               ///< 往返时间p90（微秒）
+    qint64 p99Us;               ///< 往返时间p99（微秒）
+    int timeoutMs;              ///< 当前生效的响应超时（毫秒）
+    int consecutiveFailures;    ///< 连续失败次数
+    int backoffMs;              ///< 当前退避时长（毫秒），0表示未退避
+
+    LinkStats()
+        : deviceId(-1), samples(0), p50Us(0), p90Us(0), p99Us(0), timeoutMs(0),
+          consecutiveFailures(0), backoffMs(0) {}
+};
+
+/**
+ * @class LinkHealth
+ * @brief 设备链路健康度类
+ *
+ * 非线程安全，与所属PollingTask由同一采集线程使用。
+ */
+class LinkHealth
+{
+public:
+    enum Limits {
+        MinSamples = 20,            ///< 样本不足时使用全局通信超时
+        TimeoutFactor = 3,          ///< 超时 = p99 × 系数
+        MinTimeoutMs = 50,          ///< 自适应超时下限
+        BackoffAfterFailures = 3,   ///< 连续失败达到此次数后开始退避
+        MaxBackoffMs = 60000        ///< 退避时长上限
+    };
+
+    LinkHealth();
+
+    /**
+     * @brief 记录一次收到应答的往返时间（含异常应答）
+     * @param rttUs 往返时间（微秒）
+     */
+    void recordRtt(qint64 rttUs);
+
+    /**
+     * @brief 记录一次采集成功，清除失败计数和退避
+     */
+    void recordSuccess();
+
+    /**
+     * @brief 记录一次通信失败（超时、CRC错误等），必要时进入退避
+     * @param nowNs 当前单调时间
+     * @param intervalMs 设备轮询间隔，作为退避的基数
+     */
+    void recordFailure(qint64 nowNs, int intervalMs);
+
+    /**
+     * @brief 是否处于退避期
+     * @param nowNs 当前单调时间
+     */
+    bool inBackoff(qint64 nowNs) const { return nowNs < m_backoffUntilNs; }
+
+    /**
+     * @brief 计算本次采集使用的响应超时
+     *
+     * 样本不足或上次失败时使用全局超时，以免过紧的超时把慢设备误判为离线。
+     * @param ceilingMs 全局通信超时（上限）
+     * @return 响应超时（毫秒）
+     */
+    int timeoutMs(int ceilingMs) const;
+
+    /**
+     * @brief 获取统计快照
+     * @param deviceId 设备ID
+     * @param ceilingMs 全局通信超时
+     */
+    LinkStats stats(int deviceId, int ceilingMs) const;
+
+private:
+    RttHistogram m_rtt;         ///< 往返时间直方图
+    int m_failures;             ///< 连续失败次数
+    int m_backoffMs;            ///< 当前退避时长（毫秒）
+    qint64 m_backoffUntilNs;    ///< 退避结束时间（单调时间）
+};
+
+#endif // LINKHEALTH_H
@@ -0,0 +1,261 @@
+/**
+ * @file modbusrtu.cpp
+ * @brief Modbus RTU帧编解码实现
+ *
+ * 本文件实现了Modbus RTU的CRC16计算与读请求/响应编解码。
+ * CRC表在编译期生成，编解码全部在调用者提供的缓冲区内完成。
+ */
+
+#include "modbusrtu.h"
+
+#include <array>
+
+/**
+ * @brief 编译期生成CRC16查找表（反射多项式0xA001）
+ */
+static constexpr std::array<quint16, 256> makeCrcTable()
+{
+    std::array<quint16, 256> table = {};
+    for (int i = 0; i < 256; ++i) {
+        quint16 crc = static_cast<quint16>(i);
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x0001) ? static_cast<quint16>((crc >> 1) ^ 0xA001)
+                                 : static_cast<quint16>(crc >> 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+static constexpr std::array<quint16, 256> s_crcTable = makeCrcTable();
+
+quint16 ModbusRtu::crc16(const quint8 *data, int len)
+{
+    quint16 crc = 0xFFFF;
+    for (int i = 0; i < len; ++i) {
+        crc = static_cast<quint16>((crc >> 8) ^ s_crcTable[(crc ^ data[i]) & 0xFF]);
+    }
+    return crc;
+}
+
+void ModbusRtu::appendCrc(ModbusFrame &frame)
+{
+    quint16 crc = crc16(frame.data, frame.length);
+    frame.data[frame.length++] = static_cast<quint8>(crc & 0xFF);
+    frame.data[frame.length++] = static_cast<quint8>(crc >> 8);
+}
+
+bool ModbusRtu::checkCrc(const ModbusFrame &frame)
+{
+    if (frame.length < 4) return false;
+
+    quint16 crc = crc16(frame.data, frame.length - 2);
+    return frame.data[frame.length - 2] == static_cast<quint8>(crc & 0xFF)
+        && frame.data[frame.length - 1] == static_cast<quint8>(crc >> 8);
+}
+
+bool ModbusRtu::isReadFunction(int functionCode)
+{
+    return functionCode >= 1 && functionCode <= 4;
+}
+
+bool ModbusRtu::isWriteFunction(int functionCode)
+{
+    return functionCode == 5 || functionCode == 6 || functionCode == 15 || functionCode == 16;
+}
+
+ModbusRtu::Status ModbusRtu::encodeReadRequest(ModbusFrame &frame, quint8 slave, quint8 functionCode,
+                                               quint16 start, quint16 count)
+{
+    if (!isReadFunction(functionCode) || count == 0) {
+        return ErrInvalidArgument;
+    }
+    int limit = (functionCode <= 2) ? MaxReadBits : MaxReadRegisters;
+    if (count > limit || static_cast<int>(start) + count > 0x10000) {
+        return ErrInvalidArgument;
+    }
+
+    frame.data[0] = slave;
+    frame.data[1] = functionCode;
+    frame.data[2] = static_cast<quint8>(start >> 8);
+    frame.data[3] = static_cast<quint8>(start & 0xFF);
+    frame.data[4] = static_cast<quint8>(count >> 8);
+    frame.data[5] = static_cast<quint8>(count & 0xFF);
+    frame.length = 6;
+    appendCrc(frame);
+    return Ok;
+}
+
+int ModbusRtu::expectedReadResponseLength(quint8 functionCode, quint16 count)
+{
+    switch (functionCode) {
+    case 1:
+    case 2:
+        return 5 + (count + 7) / 8;
+    case 3:
+    case 4:
+        return 5 + count * 2;
+    default:
+        return 0;
+    }
+}
+
+ModbusRtu::Status ModbusRtu::decodeReadResponse(const ModbusFrame &frame, quint8 slave, quint8 functionCode,
+                                                quint16 count, quint16 *values, quint8 *exceptionCode)
+{
+    if (frame.length < ExceptionFrameLength) {
+        return frame.length == 0 ? ErrTimeout : ErrFrameLength;
+    }
+    if (!checkCrc(frame)) {
+        return ErrCrc;
+    }
+    if (frame.data[0] != slave) {
+        return ErrSlaveMismatch;
+    }
+
+    // 异常响应：功能码最高位置1
+    if (frame.data[1] == (functionCode | 0x80)) {
+        if (exceptionCode) {
+            *exceptionCode = frame.data[2];
+        }
+        return ErrException;
+    }
+    if (frame.data[1] != functionCode) {
+        return ErrFunctionMismatch;
+    }
+
+    int expected = expectedReadResponseLength(functionCode, count);
+    if (frame.length != expected || frame.data[2] != expected - 5) {
+        return ErrFrameLength;
+    }
+
+    const quint8 *payload = frame.data + 3;
+    if (functionCode <= 2) {
+        for (int i = 0; i < count; ++i) {
+            values[i] = (payload[i >> 3] >> (i & 7)) & 0x01;
+        }
+    } else {
+        for (int i = 0; i < count; ++i) {
+            values[i] = static_cast<quint16>((payload[2 * i] << 8) | payload[2 * i + 1]);
+        }
+    }
+    return Ok;
+}
+
+ModbusRtu::Status ModbusRtu::encodeWriteRequest(ModbusFrame &frame, quint8 slave, quint8 functionCode,
+                                                quint16 start, quint16 count, const quint16 *values)
+{
+    if (!isWriteFunction(functionCode) || count == 0 || !values
+            || static_cast<int>(start) + count > 0x10000) {
+        return ErrInvalidArgument;
+    }
+
+    frame.data[0] = slave;
+    frame.data[1] = functionCode;
+    frame.data[2] = static_cast<quint8>(start >> 8);
+    frame.data[3] = static_cast<quint8>(start & 0xFF);
+
+    switch (functionCode) {
+    case 5:
+    case 6: {
+        if (count != 1) {
+            return ErrInvalidArgument;
+        }
+        quint16 value = functionCode == 5 ? (values[0] ? 0xFF00 : 0x0000) : values[0];
+        frame.data[4] = static_cast<quint8>(value >> 8);
+        frame.data[5] = static_cast<quint8>(value & 0xFF);
+        frame.length = 6;
+        break;
+    }
+    case 15: {
+        if (count > MaxWriteBits) {
+            return ErrInvalidArgument;
+        }
+        int byteCount = (count + 7) / 8;
+        frame.data[4] = static_cast<quint8>(count >> 8);
+        frame.data[5] = static_cast<quint8>(count & 0xFF);
+        frame.data[6] = static_cast<quint8>(byteCount);
+        quint8 *payload = frame.data + 7;
+        for (int i = 0; i < byteCount; ++i) {
+            payload[i] = 0;
+        }
+        for (int i = 0; i < count; ++i) {
+            if (values[i]) {
+                payload[i >> 3] |= static_cast<quint8>(1 << (i & 7));
+            }
+        }
+        frame.length = 7 + byteCount;
+        break;
+    }
+    default: {  // 16
+        if (count > MaxWriteRegisters) {
+            return ErrInvalidArgument;
+        }
+        frame.data[4] = static_cast<quint8>(count >> 8);
+        frame.data[5] = static_cast<quint8>(count & 0xFF);
+        frame.data[6] = static_cast<quint8>(count * 2);
+        quint8 *payload = frame.data + 7;
+        for (int i = 0; i < count; ++i) {
+            payload[2 * i] = static_cast<quint8>(values[i] >> 8);
+            payload[2 * i + 1] = static_cast<quint8>(values[i] & 0xFF);
+        }
+        frame.length = 7 + count * 2;
+        break;
+    }
+    }
+    appendCrc(frame);
+    return Ok;
+}
+
+ModbusRtu::Status ModbusRtu::decodeWriteResponse(const ModbusFrame &frame, const ModbusFrame &request,
+                                                 quint8 *exceptionCode)
+{
+    if (frame.length < ExceptionFrameLength) {
+        return frame.length == 0 ? ErrTimeout : ErrFrameLength;
+    }
+    if (!checkCrc(frame)) {
+        return ErrCrc;
+    }
+    if (frame.data[0] != request.data[0]) {
+        return ErrSlaveMismatch;
+    }
+
+    quint8 functionCode = request.data[1];
+    if (frame.data[1] == (functionCode | 0x80)) {
+        if (exceptionCode) {
+            *exceptionCode = frame.data[2];
+        }
+        return ErrException;
+    }
+    if (frame.data[1] != functionCode) {
+        return ErrFunctionMismatch;
+    }
+
+    // FC05/06回显地址和值，FC15/16回显地址和数量，都在第2-5字节
+    if (frame.length != WriteResponseLength) {
+        return ErrFrameLength;
+    }
+    for (int i = 2; i < 6; ++i) {
+        if (frame.data[i] != request.data[i]) {
+            return ErrFrameLength;
+        }
+    }
+    return Ok;
+}
+
+QString ModbusRtu::statusText(Status status)
+{
+    switch (status) {
+    case Ok:                  return "成功";
+    case ErrTimeout:          return "响应超时";
+    case ErrCrc:              return "CRC校验失败";
+    case ErrFrameLength:      return "响应帧长度错误";
+    case ErrSlaveMismatch:    return "从站地址不匹配";
+    case ErrFunctionMismatch: return "功能码不匹配";
+    case ErrException:        return "从站异常响应";
+    case ErrInvalidArgument:  return "请求参数非法";
+    case ErrIo:               return "串口收发错误";
+    case ErrVerifyMismatch:   return "回读校验不一致";
+    }
+    return "未知错误";
+}
@@ -0,0 +1,167 @@
+/**
+ * @file modbusrtu.h
+ * @brief Modbus RTU帧编解码定义
+ *
+ * 本文件定义了Modbus RTU协议的帧缓冲区和编解码接口，包括查表法CRC16、
+ * 读请求编码和读响应解码。所有编解码都在调用者预分配的缓冲区中完成，
+ * 单次事务不产生任何堆分配。
+ */
+
+#ifndef MODBUSRTU_H
+#define MODBUSRTU_H
+
+#include <QtGlobal>
+#include <QString>
+
+/**
+ * @struct ModbusFrame
+ * @brief Modbus RTU帧缓冲区（ADU最大256字节）
+ *
+ * 固定大小的栈/成员缓冲区，可在轮询循环中反复复用。
+ */
+struct ModbusFrame {
+    enum { Capacity = 256 };
+
+    quint8 data[Capacity];  ///< 帧字节（含地址、功能码、数据、CRC）
+    int length;             ///< 有效字节数
+
+    ModbusFrame() : length(0) {}
+};
+
+/**
+ * @class ModbusRtu
+ * @brief Modbus RTU编解码器
+ *
+ * 纯函数式的静态接口，不持有任何状态，可在任意线程中调用。
+ */
+class ModbusRtu
+{
+public:
+    /**
+     * @brief 协议限制
+     */
+    enum Limits {
+        MaxReadRegisters = 125,     ///< FC03/FC04单次最多读取的寄存器数
+        MaxReadBits = 2000,         ///< FC01/FC02单次最多读取的位数
+        MaxWriteRegisters = 123,    ///< FC16单次最多写入的寄存器数
+        MaxWriteBits = 1968,        ///< FC15单次最多写入的位数
+        ExceptionFrameLength = 5,   ///< 异常响应帧长度
+        WriteResponseLength = 8     ///< 写响应（回显）帧长度
+    };
+
+    /**
+     * @brief 事务状态码（0表示成功，可直接作为Result的code使用）
+     */
+    enum Status {
+        Ok = 0,                 ///< 成功
+        ErrTimeout = 100,       ///< 响应超时
+        ErrCrc,                 ///< CRC校验失败
+        ErrFrameLength,         ///< 帧长度与预期不符
+        ErrSlaveMismatch,       ///< 响应从站地址不匹配
+        ErrFunctionMismatch,    ///< 响应功能码不匹配
+        ErrException,           ///< 从站返回异常响应
+        ErrInvalidArgument,     ///< 请求参数非法
+        ErrIo,                  ///< 底层收发错误
+        ErrVerifyMismatch       ///< 写入后回读的值与写入值不一致
+    };
+
+    /**
+     * @brief 计算Modbus CRC16（查表法，多项式0xA001）
+     * @param data 数据起始地址
+     * @param len 数据长度
+     * @return CRC16值（低字节先发送）
+     */
+    static quint16 crc16(const quint8 *data, int len);
+
+    /**
+     * @brief 编码读请求（FC01/02/03/04）
+     * @param frame 输出帧缓冲区
+     * @param slave 从站地址
+     * @param functionCode 功能码
+     * @param start 起始地址
+     * @param count 读取数量（寄存器数或位数）
+     * @return Status 编码结果，成功时frame.length为8
+     */
+    static Status encodeReadRequest(ModbusFrame &frame, quint8 slave, quint8 functionCode,
+                                    quint16 start, quint16 count);
+
+    /**
+     * @brief 计算读请求对应的正常响应帧长度
+     * @param functionCode 功能码
+     * @param count 读取数量
+     * @return 响应帧字节数，功能码不支持时返回0
+     */
+    static int expectedReadResponseLength(quint8 functionCode, quint16 count);
+
+    /**
+     * @brief 解码读响应
+     * @param frame 接收到的响应帧
+     * @param slave 期望的从站地址
+     * @param functionCode 期望的功能码
+     * @param count 请求的数量
+     * @param values 输出缓冲区，至少count个元素；位读取时每个元素为0或1
+     * @param exceptionCode 可选，异常响应时输出异常码
+     * @return Status 解码结果
+     */
+    static Status decodeReadResponse(const ModbusFrame &frame, quint8 slave, quint8 functionCode,
+                                     quint16 count, quint16 *values, quint8 *exceptionCode = nullptr);
+
+    /**
+     * @brief 编码写请求（FC05/06/15/16）
+     * @param frame 输出帧缓冲区
+     * @param slave 从站地址
+     * @param functionCode 功能码
+     * @param start 起始地址
+     * @param count 写入数量（FC05/06必须为1）
+     * @param values 写入值，count个元素；写线圈时非0表示ON
+     * @return Status 编码结果
+     */
+    static Status encodeWriteRequest(ModbusFrame &frame, quint8 slave, quint8 functionCode,
+                                     quint16 start, quint16 count, const quint16 *values);
+
+    /**
+     * @brief 解码写响应（从站回显地址和值/数量）
+     * @param frame 接收到的响应帧
+     * @param request 对应的请求帧
+     * @param exceptionCode 可选，异常响应时输出异常码
+     * @return Status 解码结果，回显与请求不一致时返回ErrFrameLength
+     */
+    static Status decodeWriteResponse(const ModbusFrame &frame, const ModbusFrame &request,
+                                      quint8 *exceptionCode = nullptr);
+
+    /**
+     * @brief 为帧追加CRC16
+     * @param frame 帧缓冲区，length为不含CRC的长度
+     */
+    static void appendCrc(ModbusFrame &frame);
+
+    /**
+     * @brief 校验帧尾CRC16
+     * @param frame 帧缓冲区
+     * @return true表示校验通过
+     */
+    static bool checkCrc(const ModbusFrame &frame);
+
+    /**
+     * @brief 判断功能码是否为读功能码
+     * @param functionCode 功能码
+     * @return true表示为FC01-FC04
+     */
+    static bool isReadFunction(int functionCode);
+
+    /**
+     * @brief 判断功能码是否为写功能码
+     * @param functionCode 功能码
+     * @return true表示为FC05、FC06、FC15或FC16
+     */
+    static bool isWriteFunction(int functionCode);
+
+    /**
+     * @brief 获取状态码的文字描述
+     * @param status 状态码
+     * @return 给人看的说明文字
+     */
+    static QString statusText(Status status);
+};
+
+#endif // MODBUSRTU_H
@@ -3,109 +3,288 @@
  * @brief Modbus通信服务实现
  *
  * 本文件实现了Modbus通信服务的所有功能，包括轮询控制、
- * 寄存器读取等。当前为模拟数据，实际部署时需替换为真实Modbus通信。
+ * 寄存器读写等。读操作由DeviceConfig驱动，在设备所在总线的采集线程中
+ * 组帧收发；没有真实总线时由模拟从站应答。
  */
 
 #include "modbusservice.h"
-#include <QRandomGenerator>
-#include <QDateTime>
-#include <QSet>
+#include "acquisitionservice.h"
+#include "commandqueue.h"
+#include "deviceservice.h"
+#include "modbusrtu.h"
+#include "pollingscheduler.h"
+#include "pollingtask.h"
+#include "realtimecache.h"
+#include "timeseriesstore.h"
+#include "writeplanner.h"
 
-// 正在轮询的设备ID集合
-static QSet<int> s_pollingDevices;
+/**
+ * @brief 按指定功能码读取设备配置的连续寄存器区间
+ * @param cfg 设备配置
+ * @param functionCode 功能码
+ * @return Result 成功时data为RegisterSnapshotPtr
+ */
+static Result readRegisters(const DeviceConfig &cfg, int functionCode)
+{
+    DeviceConfig range = cfg;
+    range.functionCode = functionCode;
+    range.points.clear();
+    return AcquisitionService::instance()->readOnce(range);
+}
+
+/**
+ * @brief 校验并提交一条写命令
+ * @param deviceId 设备ID
+ * @param coils true写线圈，false写保持寄存器
+ * @param addr 起始地址
+ * @param values 写入值
+ * @return Result 包含命令ID
+ */
+static Result submitWrite(int deviceId, bool coils, int addr, const QVector<quint16> &values)
+{
+    DeviceConfig cfg;
+    if (!DeviceService::getDeviceConfig(deviceId, cfg)) {
+        return Result::error(404, "设备不存在");
+    }
+    if (values.isEmpty() || values.size() > WritePlanner::maxGroupSize(coils)) {
+        return Result::error(ModbusRtu::ErrInvalidArgument,
+                             QString("单次写入数量必须在1-%1之间").arg(WritePlanner::maxGroupSize(coils)));
+    }
+    if (addr < 0 || addr + values.size() > 0x10000) {
+        return Result::error(ModbusRtu::ErrInvalidArgument, "写入地址超出范围");
+    }
+
+    WriteRequest request;
+    request.coils = coils;
+    request.address = addr;
+    request.values = values;
+    return AcquisitionService::instance()->submitWrite(cfg, request);
+}
+
+Result ModbusService::writeRegister(int deviceId, int addr, quint16 value)
+{
+    return submitWrite(deviceId, false, addr, QVector<quint16>() << value);
+}
+
+Result ModbusService::writeRegisters(int deviceId, int addr, const QVector<quint16> &values)
+{
+    return submitWrite(deviceId, false, addr, values);
+}
+
+Result ModbusService::writeCoil(int deviceId, int addr, bool on)
+{
+    return submitWrite(deviceId, true, addr, QVector<quint16>() << (on ? 1 : 0));
+}
+
+Result ModbusService::writeCoils(int deviceId, int addr, const QVector<bool> &values)
+{
+    QVector<quint16> bits;
+    bits.reserve(values.size());
+    for (bool on : values) {
+        bits.append(on ? 1 : 0);
+    }
+    return submitWrite(deviceId, true, addr, bits);
+}
+
+Result ModbusService::getCommandQueue(int deviceId)
+{
+    return CommandQueue::getCommands(deviceId);
+}
 
 Result ModbusService::startPolling(int deviceId)
 {
-    s_pollingDevices.insert(deviceId);
-    return Result::success();
+    return AcquisitionService::instance()->addDevice(deviceId);
 }
 
 Result ModbusService::stopPolling(int deviceId)
 {
-    s_pollingDevices.remove(deviceId);
+    AcquisitionService::instance()->removeDevice(deviceId);
     return Result::success();
 }
 
 bool ModbusService::isPolling(int deviceId)
 {
-    return s_pollingDevices.contains(deviceId);
+    return AcquisitionService::instance()->isPolling(deviceId);
+}
+
+Result ModbusService::getLatestData(int deviceId)
+{
+    return AcquisitionService::instance()->latestData(deviceId);
+}
+
+Result ModbusService::getLatestDataBatch(const QVector<int> &deviceIds)
+{
+    SnapshotBatchPtr batch = AcquisitionService::instance()->latestBatch(deviceIds);
+    return Result::success(QVariant::fromValue(batch));
+}
+
+Result ModbusService::getPollingStats()
+{
+    return AcquisitionService::instance()->pollingStats();
+}
+
+Result ModbusService::resetTransport()
+{
+    return AcquisitionService::instance()->restart();
 }
 
 Result ModbusService::readHoldingRegisters(int deviceId)
 {
-    Q_UNUSED(deviceId)
+    DeviceConfig cfg;
+    if (!DeviceService::getDeviceConfig(deviceId, cfg)) {
+        return Result::error(404, "设备不存在");
+    }
+    return readRegisters(cfg, 3);
+}
 
-    // 模拟寄存器数据
-    QVariantList registers;
-    for (int i = 0; i < 10; ++i) {
-        QVariantMap reg;
-        reg["address"] = i;
-        reg["name"] = QString("寄存器 %1").arg(i);
-        reg["value"] = QRandomGenerator::global()->bounded(0, 10000);
-        reg["unit"] = (i % 2 == 0) ? "℃" : "bar";
-        reg["updateTime"] = QDateTime::currentDateTime().toString("hh:mm:ss");
-        registers.append(reg);
+Result ModbusService::readInputRegisters(int deviceId)
+{
+    DeviceConfig cfg;
+    if (!DeviceService::getDeviceConfig(deviceId, cfg)) {
+        return Result::error(404, "设备不存在");
     }
+    return readRegisters(cfg, 4);
+}
 
-    return Result::success(registers);
+Result ModbusService::pollDevice(int deviceId)
+{
+    DeviceConfig cfg;
+    if (!DeviceService::getDeviceConfig(deviceId, cfg)) {
+        return Result::error(404, "设备不存在");
+    }
+    if (cfg.points.isEmpty() && !ModbusRtu::isReadFunction(cfg.functionCode)) {
+        return Result::error(ModbusRtu::ErrInvalidArgument, "该功能码不支持周期读取");
+    }
+    return AcquisitionService::instance()->readOnce(cfg);
 }
 
-Result ModbusService::readInputRegisters(int deviceId)
+Result ModbusService::getReadPlan(int deviceId)
 {
-    Q_UNUSED(deviceId)
+    DeviceConfig cfg;
+    if (!DeviceService::getDeviceConfig(deviceId, cfg)) {
+        return Result::error(404, "设备不存在");
+    }
 
-    // 模拟输入寄存器数据
-    QVariantList registers;
-    for (int i = 0; i < 5; ++i) {
-        QVariantMap reg;
-        reg["address"] = 100 + i;
-        reg["name"] = QString("输入 %1").arg(i);
-        reg["value"] = QRandomGenerator::global()->bounded(0, 5000);
-        reg["unit"] = "mA";
-        reg["updateTime"] = QDateTime::currentDateTime().toString("hh:mm:ss");
-        registers.append(reg);
+    PollingTask task(cfg);
+    QVariantList blocks;
+    for (const ReadBlock &block : task.blocks()) {
+        QVariantMap b;
+        b["functionCode"] = block.functionCode;
+        b["start"] = block.start;
+        b["count"] = block.count;
+        blocks.append(b);
     }
 
-    return Result::success(registers);
+    QVariantMap plan;
+    plan["transactionsBefore"] = task.pointCount();
+    plan["transactionsAfter"] = task.transactionCount();
+    plan["blocks"] = blocks;
+    return Result::success(plan);
 }
 
 Result ModbusService::getRealtimeValue(int deviceId, int addr)
 {
-    Q_UNUSED(deviceId)
-    Q_UNUSED(addr)
+    // 只读实时值缓存，不访问总线
+    RealtimeCache::Value value;
+    if (!RealtimeCache::read(deviceId, addr, &value)) {
+        return Result::error(1, "暂无该点的实时数据");
+    }
+
+    QString unit;
+    DeviceConfig cfg;
+    if (DeviceService::getDeviceConfig(deviceId, cfg)) {
+        for (const RegisterPoint &p : cfg.points) {
+            if (addr >= p.address && addr < p.address + p.count) {
+                unit = p.unit;
+                break;
+            }
+        }
+        for (const DerivedPoint &d : cfg.derivedPoints) {
+            if (addr == d.address) {
+                unit = d.unit;
+                break;
+            }
+        }
+    }
 
-    // 模拟实时值
     QVariantMap data;
-    data["value"] = QRandomGenerator::global()->bounded(0, 10000) / 100.0;
-    data["unit"] = "℃";
-    data["updateTime"] = QDateTime::currentDateTime().toString("hh:mm:ss");
-    data["quality"] = "良好";
+    data["value"] = value.value;
+    data["unit"] = unit;
+    data["timestampNs"] = value.timestampNs;
+    data["flags"] = value.flags;
+    data["stale"] = (value.flags & RegisterSnapshot::FlagStale) != 0;
+    data["qualityCode"] = static_cast<int>(RegisterSnapshot::qualityOf(value.flags));
+    if (value.flags & RegisterSnapshot::FlagCommLost) {
+        data["quality"] = "通信中断";
+    } else if (value.flags & RegisterSnapshot::FlagBad) {
+        data["quality"] = "无效";
+    } else if (value.flags & RegisterSnapshot::FlagStale) {
+        data["quality"] = "过期";
+    } else if (value.flags & RegisterSnapshot::FlagOutOfRange) {
+        data["quality"] = "超量程";
+    } else {
+        data["quality"] = "良好";
+    }
 
     return Result::success(data);
 }
 
-Result ModbusService::getHistoryData(int deviceId, int addr)
+Result ModbusService::getHistoryData(int deviceId, int addr, int windowSeconds)
 {
-    Q_UNUSED(deviceId)
-    Q_UNUSED(addr)
+    const int HistoryPoints = 120;      // 趋势数据最多的点数
 
-    // 模拟历史数据
-    QVariantMap data;
-    data["currentValue"] = QRandomGenerator::global()->bounded(200, 300) / 10.0;
-    data["minValue"] = 18.5;
-    data["maxValue"] = 32.7;
-    data["avgValue"] = 24.3;
-    data["updateTime"] = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss");
+    qint64 toNs = PollingScheduler::wallClockNs();
+    qint64 fromNs = toNs - qMax(1, windowSeconds) * Q_INT64_C(1000000000);
+    TimeSeriesStore::Bucket stats;
+    Result result = TimeSeriesStore::statistics(deviceId, addr, fromNs, toNs, &stats);
+    if (stats.count == 0) {
+        return result.isSuccess() ? Result::error(1, "暂无该点的历史数据") : result;
+    }
+
+    // 趋势按窗口长度选用最粗的、仍能分出HistoryPoints段的数据级别，再合并到各段
+    QVector<TimeSeriesStore::Bucket> points(HistoryPoints);
+    for (TimeSeriesStore::Bucket &point : points) {
+        point.count = 0;
+    }
+    qint64 pointNs = qMax<qint64>(1, (toNs - fromNs) / HistoryPoints + 1);
+    int tier = windowSeconds <= 15 * 60 ? TimeSeriesStore::Raw
+             : windowSeconds <= 2 * 86400 ? TimeSeriesStore::Minute : TimeSeriesStore::Hour;
+    if (tier == TimeSeriesStore::Raw) {
+        QVector<TimeSeriesStore::Sample> samples;
+        TimeSeriesStore::query(deviceId, addr, fromNs, toNs, &samples);
+        for (const TimeSeriesStore::Sample &s : samples) {
+            if (RegisterSnapshot::qualityOf(s.flags) != RegisterSnapshot::Bad) {
+                points[static_cast<int>((s.timestampNs - fromNs) / pointNs)].add(s.value);
+            }
+        }
+    } else {
+        QVector<TimeSeriesStore::Bucket> buckets;
+        TimeSeriesStore::queryBuckets(deviceId, addr, tier, fromNs, toNs, &buckets);
+        for (const TimeSeriesStore::Bucket &b : buckets) {
+            points[static_cast<int>((b.startNs - fromNs) / pointNs)].merge(b);
+        }
+    }
 
-    // 用于图表的历史数据点
     QVariantList history;
-    double base = 25.0;
-    for (int i = 0; i < 60; ++i) {
-        QVariantMap point;
-        point["time"] = QDateTime::currentDateTime().addSecs(-60 + i).toString("hh:mm");
-        point["value"] = base + (QRandomGenerator::global()->bounded(-50, 50) / 10.0);
-        history.append(point);
+    for (int i = 0; i < HistoryPoints; ++i) {
+        if (points[i].count > 0) {
+            QVariantMap point;
+            point["timestampNs"] = fromNs + i * pointNs + pointNs / 2;
+            point["value"] = points[i].sum / points[i].count;
+            point["minValue"] = points[i].min;
+            point["maxValue"] = points[i].max;
+            history.append(point);
+        }
     }
+
+    QVariantMap data;
+    data["currentValue"] = stats.last;
+    data["fromNs"] = fromNs;
+    data["toNs"] = toNs;
+    data["sampleCount"] = stats.count;
+    data["minValue"] = stats.min;
+    data["maxValue"] = stats.max;
+    data["avgValue"] = stats.sum / stats.count;
     data["history"] = history;
 
     return Result::success(data);
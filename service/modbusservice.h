@@ -3,7 +3,7 @@
  * @brief Modbus通信服务定义
  *
  * 本文件定义了Modbus通信相关的服务接口，包括轮询控制、
- * 读取保持寄存器、读取输入寄存器、获取实时值和历史数据等功能。
+ * 读取保持寄存器、读取输入寄存器、写寄存器和线圈、获取实时值和历史数据等功能。
  */
 
 #ifndef MODBUSSERVICE_H
@@ -11,6 +11,8 @@
 
 #include "../common/result.h"
 
+#include <QVector>
+
 /**
  * @class ModbusService
  * @brief Modbus通信服务类
@@ -21,7 +23,7 @@ class ModbusService
 {
 public:
     /**
-     * @brief 开始轮询指定设备
+     * @brief 开始轮询指定设备（按设备配置的pollInterval调度）
      * @param deviceId 设备ID
      * @return Result 操作结果
      */
@@ -37,32 +39,124 @@ public:
     /**
      * @brief 读取保持寄存器（功能码03）
      * @param deviceId 设备ID
-     * @return Result 包含寄存器数据列表
+     * @return Result 成功时data为RegisterSnapshotPtr
      */
     static Result readHoldingRegisters(int deviceId);
 
     /**
      * @brief 读取输入寄存器（功能码04）
      * @param deviceId 设备ID
-     * @return Result 包含寄存器数据列表
+     * @return Result 成功时data为RegisterSnapshotPtr
      */
     static Result readInputRegisters(int deviceId);
 
     /**
-     * @brief 获取指定寄存器的实时值
+     * @brief 按设备配置的功能码、起始地址和数量读取一次数据
+     *
+     * 读取在设备所在总线的采集线程中执行，调用线程阻塞到读取完成或超时。
+     * @param deviceId 设备ID
+     * @return Result 成功时data为RegisterSnapshotPtr
+     */
+    static Result pollDevice(int deviceId);
+
+    /**
+     * @brief 写单个保持寄存器（功能码06，与相邻的排队写入合并为16）
+     *
+     * 写命令登记到命令队列后立即返回，在设备所在总线的两次采集之间执行，
+     * 写入后回读校验，状态变化通过AcquisitionService::commandUpdated通知。
+     * @param deviceId 设备ID
+     * @param addr 寄存器地址
+     * @param value 写入值
+     * @return Result 包含命令ID（commandId）
+     */
+    static Result writeRegister(int deviceId, int addr, quint16 value);
+
+    /**
+     * @brief 写多个连续的保持寄存器（功能码16）
+     * @param deviceId 设备ID
+     * @param addr 起始地址
+     * @param values 写入值（1-123个）
+     * @return Result 包含命令ID（commandId）
+     */
+    static Result writeRegisters(int deviceId, int addr, const QVector<quint16> &values);
+
+    /**
+     * @brief 写单个线圈（功能码05，与相邻的排队写入合并为15）
+     * @param deviceId 设备ID
+     * @param addr 线圈地址
+     * @param on true为ON
+     * @return Result 包含命令ID（commandId）
+     */
+    static Result writeCoil(int deviceId, int addr, bool on);
+
+    /**
+     * @brief 写多个连续的线圈（功能码15）
+     * @param deviceId 设备ID
+     * @param addr 起始地址
+     * @param values 写入值（1-1968个）
+     * @return Result 包含命令ID（commandId）
+     */
+    static Result writeCoils(int deviceId, int addr, const QVector<bool> &values);
+
+    /**
+     * @brief 获取写命令列表
+     * @param deviceId 设备ID，-1表示所有设备
+     * @return Result 包含命令记录（字段同command_queue表）
+     */
+    static Result getCommandQueue(int deviceId = -1);
+
+    /**
+     * @brief 获取调度器最近一次为该设备采集到的数据（不访问总线）
+     * @param deviceId 设备ID
+     * @return Result 成功时data为RegisterSnapshotPtr
+     */
+    static Result getLatestData(int deviceId);
+
+    /**
+     * @brief 一次获取多个设备最近一次的采集数据（不访问总线）
+     *
+     * 界面需要多个设备的数据时用本接口代替逐个调用getLatestData()。
+     * @param deviceIds 设备ID列表，为空表示所有调度中的设备
+     * @return Result data为SnapshotBatchPtr，尚未采集的设备不在批中
+     */
+    static Result getLatestDataBatch(const QVector<int> &deviceIds = QVector<int>());
+
+    /**
+     * @brief 获取设备的读取合并规划
+     * @param deviceId 设备ID
+     * @return Result 包含合并前后每周期事务数和读请求列表
+     */
+    static Result getReadPlan(int deviceId);
+
+    /**
+     * @brief 获取轮询调度统计
+     * @return Result 包含每设备抖动、超期、耗时、往返时间分位数（rttP50Ms/rttP90Ms/rttP99Ms）、
+     *         自适应超时、退避状态、合并前后事务数、优先级与实际间隔（achievedIntervalMs）、
+     *         总线占用率以及各优先级的需求和间隔拉长倍数
+     */
+    static Result getPollingStats();
+
+    /**
+     * @brief 获取指定寄存器的实时值（读实时值缓存，不访问总线）
      * @param deviceId 设备ID
      * @param addr 寄存器地址
-     * @return Result 包含实时值、单位、更新时间等信息
+     * @return Result 包含实时值、单位、采集时间（timestampNs，自1970年起的纳秒数）、
+     *         标志（flags，RegisterSnapshot::Flag的组合）、是否过期（stale）、
+     *         质量码（qualityCode：0良好/1无效/2不确定）和质量说明（quality）
      */
     static Result getRealtimeValue(int deviceId, int addr);
 
     /**
-     * @brief 获取指定寄存器的历史数据
+     * @brief 获取指定寄存器的历史数据（读历史存储，不访问总线）
      * @param deviceId 设备ID
      * @param addr 寄存器地址
-     * @return Result 包含历史数据用于趋势分析
+     * @param windowSeconds 统计窗口（秒），截止到当前时间
+     * @return Result 包含窗口内最新值、最小/最大/平均值和样本数（只统计质量不是无效的样本，
+     *         长窗口由分钟和小时汇总得出）、窗口起止时间（fromNs/toNs），以及按时间均分为
+     *         最多120段、每段含平均/最小/最大值的趋势数据（history）；时间为自1970年起的
+     *         纳秒数；窗口内没有有效样本时返回错误
      */
-    static Result getHistoryData(int deviceId, int addr);
+    static Result getHistoryData(int deviceId, int addr, int windowSeconds = 3600);
 
     /**
      * @brief 检查设备是否正在轮询
@@ -70,6 +164,14 @@ public:
      * @return true表示正在轮询，false表示未轮询
      */
     static bool isPolling(int deviceId);
+
+    /**
+     * @brief 按当前串口配置重建各总线的采集线程
+     *
+     * 串口打开失败的总线不退回模拟从站，其设备按通信中断上报；只有sim://总线使用模拟从站。
+     * @return Result 成功表示已使用真实串口，失败时包含串口错误信息
+     */
+    static Result resetTransport();
 };
 
 #endif // MODBUSSERVICE_H
@@ -0,0 +1,202 @@
+/**
+ * @file modbussimulator.cpp
+ * @brief Modbus模拟从站实现
+ *
+ * 本文件实现了进程内模拟从站：解析请求帧、校验CRC、
+ * 按功能码组出正常响应或异常响应帧。
+ */
+
+#include "modbussimulator.h"
+#include "serialtransport.h"
+#include <QDateTime>
+#include <QThread>
+
+// 模拟从站的寄存器地址空间大小
+static const int SIM_ADDRESS_SPACE = 1000;
+
+// 模拟从站收到请求到开始应答的处理时间（微秒）
+static const int SIM_TURNAROUND_US = 2000;
+
+ModbusSimulator::ModbusSimulator()
+    : m_charTimeUs(0)
+    , m_t35Us(0)
+{
+}
+
+void ModbusSimulator::setLineTiming(const SerialConfig &cfg)
+{
+    SerialTransport::frameTiming(cfg, &m_charTimeUs, &m_t35Us);
+}
+
+void ModbusSimulator::waitOnWire(int bytes, int extraUs) const
+{
+    if (m_charTimeUs <= 0) {
+        return;
+    }
+    QThread::usleep(static_cast<unsigned long>(bytes * m_charTimeUs + m_t35Us + extraUs));
+}
+
+bool ModbusSimulator::isOpen() const
+{
+    return true;
+}
+
+bool ModbusSimulator::isEndpoint(const QString &port)
+{
+    return port.startsWith("sim://");
+}
+
+bool ModbusSimulator::hasSlave(int slave)
+{
+    return slave == 1 || slave == 2 || slave == 5 || slave == 10;
+}
+
+quint32 ModbusSimulator::writeKey(int slave, bool coil, int address)
+{
+    return (static_cast<quint32>(slave) << 24) | (coil ? 0u : 0x10000u) | static_cast<quint32>(address);
+}
+
+quint16 ModbusSimulator::registerValue(int slave, int functionCode, int address) const
+{
+    if (functionCode == 1 || functionCode == 3) {
+        auto it = m_written.constFind(writeKey(slave, functionCode == 1, address));
+        if (it != m_written.constEnd()) {
+            return *it;
+        }
+    }
+
+    qint64 sec = QDateTime::currentMSecsSinceEpoch() / 1000;
+
+    if (functionCode <= 2) {
+        return static_cast<quint16>(((sec / (address % 7 + 1)) + slave) & 0x01);
+    }
+
+    int base = 200 + (slave * 37 + address * 13 + functionCode * 101) % 300;
+    int phase = static_cast<int>((sec + address) % 40);
+    int wave = phase < 20 ? phase : 40 - phase;
+    return static_cast<quint16>(base + wave);
+}
+
+quint8 ModbusSimulator::applyWrite(int slave, const ModbusFrame &request)
+{
+    quint8 fc = request.data[1];
+    int start = (request.data[2] << 8) | request.data[3];
+    int word = (request.data[4] << 8) | request.data[5];
+
+    if (fc == 5 || fc == 6) {
+        if (start >= SIM_ADDRESS_SPACE) {
+            return 0x02;
+        }
+        if (fc == 5 && word != 0xFF00 && word != 0x0000) {
+            return 0x03;
+        }
+        m_written.insert(writeKey(slave, fc == 5, start), fc == 5 ? (word ? 1 : 0) : word);
+        return 0;
+    }
+
+    // FC15/16：word为数量，其后是字节数和数据
+    int count = word;
+    int byteCount = request.length >= 7 ? request.data[6] : -1;
+    int expectedBytes = fc == 15 ? (count + 7) / 8 : count * 2;
+    int maxCount = fc == 15 ? int(ModbusRtu::MaxWriteBits) : int(ModbusRtu::MaxWriteRegisters);
+    if (count == 0 || count > maxCount || byteCount != expectedBytes || request.length != 9 + byteCount) {
+        return 0x03;
+    }
+    if (start + count > SIM_ADDRESS_SPACE) {
+        return 0x02;
+    }
+    const quint8 *payload = request.data + 7;
+    for (int i = 0; i < count; ++i) {
+        quint16 value = fc == 15 ? ((payload[i >> 3] >> (i & 7)) & 0x01)
+                                 : static_cast<quint16>((payload[2 * i] << 8) | payload[2 * i + 1]);
+        m_written.insert(writeKey(slave, fc == 15, start + i), value);
+    }
+    return 0;
+}
+
+ModbusRtu::Status ModbusSimulator::transact(const ModbusFrame &request, ModbusFrame &response,
+                                            int expectedLength, int timeoutMs)
+{
+    Q_UNUSED(expectedLength)
+
+    response.length = 0;
+
+    if (request.length < 8 || !ModbusRtu::checkCrc(request)) {
+        waitOnWire(request.length, timeoutMs * 1000);
+        return ModbusRtu::ErrTimeout;   // 从站丢弃坏帧，主站只能等到超时
+    }
+
+    quint8 slave = request.data[0];
+    quint8 fc = request.data[1];
+    if (!hasSlave(slave)) {
+        waitOnWire(request.length, timeoutMs * 1000);
+        return ModbusRtu::ErrTimeout;
+    }
+
+    int start = (request.data[2] << 8) | request.data[3];
+    int count = (request.data[4] << 8) | request.data[5];
+
+    response.data[0] = slave;
+
+    // 写请求：记录写入值并回显地址和值/数量
+    if (ModbusRtu::isWriteFunction(fc)) {
+        quint8 exception = applyWrite(slave, request);
+        if (exception) {
+            response.data[1] = fc | 0x80;
+            response.data[2] = exception;
+            response.length = 3;
+        } else {
+            for (int i = 1; i < 6; ++i) {
+                response.data[i] = request.data[i];
+            }
+            response.length = 6;
+        }
+        ModbusRtu::appendCrc(response);
+        waitOnWire(request.length + response.length, SIM_TURNAROUND_US);
+        return ModbusRtu::Ok;
+    }
+
+    // 功能码或地址非法时返回异常响应
+    quint8 exception = 0;
+    if (!ModbusRtu::isReadFunction(fc)) {
+        exception = 0x01;
+    } else if (count == 0 || start + count > SIM_ADDRESS_SPACE
+               || count > ((fc <= 2) ? int(ModbusRtu::MaxReadBits) : int(ModbusRtu::MaxReadRegisters))) {
+        exception = 0x02;
+    }
+    if (exception) {
+        response.data[1] = fc | 0x80;
+        response.data[2] = exception;
+        response.length = 3;
+        ModbusRtu::appendCrc(response);
+        waitOnWire(request.length + response.length, SIM_TURNAROUND_US);
+        return ModbusRtu::Ok;
+    }
+
+    response.data[1] = fc;
+    quint8 *payload = response.data + 3;
+    if (fc <= 2) {
+        int byteCount = (count + 7) / 8;
+        for (int i = 0; i < byteCount; ++i) {
+            payload[i] = 0;
+        }
+        for (int i = 0; i < count; ++i) {
+            if (registerValue(slave, fc, start + i)) {
+                payload[i >> 3] |= static_cast<quint8>(1 << (i & 7));
+            }
+        }
+        response.data[2] = static_cast<quint8>(byteCount);
+        response.length = 3 + byteCount;
+    } else {
+        for (int i = 0; i < count; ++i) {
+            quint16 v = registerValue(slave, fc, start + i);
+            payload[2 * i] = static_cast<quint8>(v >> 8);
+            payload[2 * i + 1] = static_cast<quint8>(v & 0xFF);
+        }
+        response.data[2] = static_cast<quint8>(count * 2);
+        response.length = 3 + count * 2;
+    }
+    ModbusRtu::appendCrc(response);
+    waitOnWire(request.length + response.length, SIM_TURNAROUND_US);
+    return ModbusRtu::Ok;
+}
@@ -0,0 +1,67 @@
+/**
+ * @file modbussimulator.h
+ * @brief Modbus模拟从站定义
+ *
+ * 本文件定义了一个进程内的Modbus RTU模拟从站。它接收完整的请求帧，
+ * 按协议校验并组出响应帧，用于在没有真实RS485总线时驱动整条采集链路。
+ */
+
+#ifndef MODBUSSIMULATOR_H
+#define MODBUSSIMULATOR_H
+
+#include "modbustransport.h"
+#include "systemservice.h"
+
+#include <QHash>
+
+/**
+ * @class ModbusSimulator
+ * @brief Modbus模拟从站传输
+ *
+ * 只在总线名称（串口配置或DeviceConfig::busPort）写成 sim:// 时使用，串口打开失败时不代替真实总线。
+ * 在线的从站地址固定为1、2、5、10，其余地址按超时处理。
+ * 寄存器值由地址和时间生成，缓慢变化，便于在界面上观察。
+ * 支持FC05/06/15/16写入，写过的线圈和保持寄存器此后读出写入值。
+ * 设置线路参数后按波特率模拟帧传输时间和从站应答延时，缺席的从站
+ * 占满超时时间，使总线耗时统计与真实总线一致。
+ */
+class ModbusSimulator : public ModbusTransport
+{
+public:
+    ModbusSimulator();
+
+    bool isOpen() const override;
+    ModbusRtu::Status transact(const ModbusFrame &request, ModbusFrame &response,
+                               int expectedLength, int timeoutMs) override;
+
+    /**
+     * @brief 判断总线名称是否指定模拟从站
+     * @param port 总线名称，如 sim:// 或 sim://bus2
+     */
+    static bool isEndpoint(const QString &port);
+
+    /**
+     * @brief 判断模拟总线上是否存在指定从站
+     * @param slave 从站地址
+     * @return true表示存在
+     */
+    static bool hasSlave(int slave);
+
+    /**
+     * @brief 设置模拟的线路参数
+     * @param cfg 串口配置（仅使用波特率和字符格式）
+     */
+    void setLineTiming(const SerialConfig &cfg);
+
+private:
+    quint16 registerValue(int slave, int functionCode, int address) const;
+    quint8 applyWrite(int slave, const ModbusFrame &request);
+    static quint32 writeKey(int slave, bool coil, int address);
+    void waitOnWire(int bytes, int extraUs) const;
+
+    int m_charTimeUs;       ///< 单字符传输时间（微秒），0表示不模拟线路耗时
+    int m_t35Us;            ///< 帧间隔t3.5（微秒）
+    QHash<quint32, quint16> m_written;  ///< 写入过的线圈/保持寄存器 → 值
+};
+
+#endif // MODBUSSIMULATOR_H
@@ -0,0 +1,25 @@
+/**
+ * @file modbustransport.cpp
+ * @brief Modbus传输层接口实现
+ */
+
+#include "modbustransport.h"
+#include "pollingscheduler.h"
+
+void ModbusTransport::transactBatch(ModbusTransaction *items, int count, int timeoutMs)
+{
+    for (int i = 0; i < count; ++i) {
+        ModbusTransaction &t = items[i];
+        qint64 sentNs = PollingScheduler::monotonicNs();
+        t.status = transact(t.request, t.response, t.expectedLength, timeoutMs);
+        t.rttUs = (PollingScheduler::monotonicNs() - sentNs) / 1000;
+
+        if (t.status != ModbusRtu::Ok) {
+            for (int k = i + 1; k < count; ++k) {
+                items[k].status = t.status;
+                items[k].response.length = 0;
+            }
+            return;
+        }
+    }
+}
@@ -0,0 +1,71 @@
+/**
+ * @file modbustransport.h
+ * @brief Modbus传输层接口定义
+ *
+ * 本文件定义了Modbus传输层的抽象接口。编解码器只负责组帧，
+ * 具体的收发由实现此接口的传输对象完成（串口、TCP、模拟从站等）。
+ * 帧统一使用RTU格式（从站地址 + PDU + CRC），其他封装由传输层自行转换。
+ */
+
+#ifndef MODBUSTRANSPORT_H
+#define MODBUSTRANSPORT_H
+
+#include "modbusrtu.h"
+
+/**
+ * @struct ModbusTransaction
+ * @brief 批量收发中的一个事务
+ */
+struct ModbusTransaction {
+    ModbusFrame request;        ///< 已编码的请求帧
+    ModbusFrame response;       ///< 响应帧
+    int expectedLength;         ///< 预期的正常响应长度
+    ModbusRtu::Status status;   ///< 事务结果
+    qint64 rttUs;               ///< 往返时间（微秒），仅status为Ok时有效
+
+    ModbusTransaction() : expectedLength(0), status(ModbusRtu::Ok), rttUs(0) {}
+};
+
+/**
+ * @class ModbusTransport
+ * @brief Modbus传输层抽象类
+ *
+ * 一次transact完成"发送请求 → 接收完整响应"的一个事务。
+ * 实现类不应在事务中进行堆分配。
+ */
+class ModbusTransport
+{
+public:
+    virtual ~ModbusTransport() {}
+
+    /**
+     * @brief 传输是否可用
+     * @return true表示可以进行事务
+     */
+    virtual bool isOpen() const = 0;
+
+    /**
+     * @brief 执行一次请求/响应事务
+     * @param request 已编码的请求帧
+     * @param response 响应帧输出缓冲区
+     * @param expectedLength 预期的正常响应长度
+     * @param timeoutMs 响应超时（毫秒）
+     * @return ModbusRtu::Status 事务结果
+     */
+    virtual ModbusRtu::Status transact(const ModbusFrame &request, ModbusFrame &response,
+                                       int expectedLength, int timeoutMs) = 0;
+
+    /**
+     * @brief 执行一组相互独立的事务
+     *
+     * 默认实现逐个调用transact，遇到通信失败即停止，其余事务记为同一状态，
+     * 避免离线设备的每个读请求都等满超时。支持流水线的传输层（Modbus TCP）
+     * 重写此函数，让多个事务同时在途。
+     * @param items 事务数组
+     * @param count 事务个数
+     * @param timeoutMs 每个事务的响应超时（毫秒）
+     */
+    virtual void transactBatch(ModbusTransaction *items, int count, int timeoutMs);
+};
+
+#endif // MODBUSTRANSPORT_H
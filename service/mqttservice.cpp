@@ -7,6 +7,7 @@
  */
 
 #include "mqttservice.h"
+#include "registersnapshot.h"
 
 static MqttConfig s_mqttConfig;
 static bool s_mqttConnected = false;
@@ -67,3 +68,34 @@ Result MqttService::publish(const QString &topic, const QByteArray &payload)
     // TODO: 实现实际的消息发布
     return Result::success();
 }
+
+QByteArray MqttService::encodeSnapshot(const RegisterSnapshot &snapshot)
+{
+    QByteArray out;
+    out.reserve(48 + snapshot.changed.size() * 40);
+    out += "{\"device\":";
+    out += QByteArray::number(snapshot.deviceId);
+    out += ",\"ts\":";
+    out += QByteArray::number(snapshot.timestampsNs.isEmpty() ? 0 : snapshot.timestampsNs[0]);
+    out += ",\"values\":[";
+    for (int k = 0; k < snapshot.changed.size(); ++k) {
+        int i = snapshot.changed[k];
+        if (k > 0) {
+            out += ',';
+        }
+        out += "{\"addr\":";
+        out += QByteArray::number(snapshot.address(i));
+        out += ",\"v\":";
+        out += QByteArray::number(snapshot.values[i], 'g', 10);
+        out += ",\"q\":";
+        out += QByteArray::number(snapshot.flags(i));
+        // 与整轮时间不同的值单独带时间戳
+        if (snapshot.timestampsNs[i] != snapshot.timestampsNs[0]) {
+            out += ",\"ts\":";
+            out += QByteArray::number(snapshot.timestampsNs[i]);
+        }
+        out += '}';
+    }
+    out += "]}";
+    return out;
+}
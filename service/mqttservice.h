@@ -11,6 +11,8 @@
 
 #include "../common/result.h"
 
+struct RegisterSnapshot;
+
 /**
  * @struct MqttConfig
  * @brief MQTT配置结构体
@@ -76,6 +78,17 @@ public:
      * @return Result 发布结果
      */
     static Result publish(const QString &topic, const QByteArray &payload);
+
+    /**
+     * @brief 把有变化的采集值编码为上报消息
+     *
+     * 只编码snapshot.changed中的值，q为标志（RegisterSnapshot::Flag的组合，0表示良好）。
+     * 时间戳ts为自1970年起的纳秒数，按整数原样写出
+     * （JSON数字按double解析会丢失纳秒精度，云端需按64位整数读取）。
+     * @param snapshot 经过流水线处理的快照
+     * @return JSON格式的消息内容：{"device":1,"ts":...,"values":[{"addr":0,"v":1.5,"q":0}]}
+     */
+    static QByteArray encodeSnapshot(const RegisterSnapshot &snapshot);
 };
 
 #endif // MQTTSERVICE_H
@@ -0,0 +1,133 @@
+/**
+ * @file pointbitset.h
+ * @brief 按点下标的紧凑位集定义
+ *
+ * 本文件定义了PointBitset：每个采集点占1位，按64位字存放。质量、过期、
+ * 超量程、通信中断等标志各用一个位集，判断成千上万个点时按字做与或运算，
+ * 不需要逐点比较。
+ */
+
+#ifndef POINTBITSET_H
+#define POINTBITSET_H
+
+#include <QtGlobal>
+#include <QVector>
+
+/**
+ * @class PointBitset
+ * @brief 定长位集（值语义，隐式共享）
+ */
+class PointBitset
+{
+public:
+    PointBitset() : m_size(0) {}
+    explicit PointBitset(int size, bool value = false) { resize(size, value); }
+
+    /**
+     * @brief 设置位数，所有位置为value
+     */
+    void resize(int size, bool value = false)
+    {
+        m_size = size;
+        m_words.fill(value ? ~Q_UINT64_C(0) : 0, (size + 63) / 64);
+        trim();
+    }
+
+    /**
+     * @brief 所有位置为value
+     */
+    void fill(bool value) { resize(m_size, value); }
+
+    int size() const { return m_size; }
+
+    bool test(int i) const { return (m_words[i >> 6] >> (i & 63)) & 1; }
+
+    void set(int i, bool value = true)
+    {
+        quint64 mask = Q_UINT64_C(1) << (i & 63);
+        if (value) {
+            m_words[i >> 6] |= mask;
+        } else {
+            m_words[i >> 6] &= ~mask;
+        }
+    }
+
+    /**
+     * @brief 是否有任意一位为1
+     */
+    bool any() const
+    {
+        for (quint64 w : m_words) {
+            if (w) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief 为1的位数
+     */
+    int count() const
+    {
+        int n = 0;
+        for (quint64 w : m_words) {
+            n += __builtin_popcountll(w);
+        }
+        return n;
+    }
+
+    /**
+     * @brief 按位或（两个位集位数必须相同）
+     */
+    PointBitset &operator|=(const PointBitset &other)
+    {
+        quint64 *w = m_words.data();
+        const quint64 *o = other.m_words.constData();
+        for (int k = 0; k < m_words.size(); ++k) {
+            w[k] |= o[k];
+        }
+        return *this;
+    }
+
+    /**
+     * @brief 按位与（两个位集位数必须相同）
+     */
+    PointBitset &operator&=(const PointBitset &other)
+    {
+        quint64 *w = m_words.data();
+        const quint64 *o = other.m_words.constData();
+        for (int k = 0; k < m_words.size(); ++k) {
+            w[k] &= o[k];
+        }
+        return *this;
+    }
+
+    /**
+     * @brief 位数和各位都相同
+     */
+    bool operator==(const PointBitset &other) const
+    {
+        return m_size == other.m_size && m_words == other.m_words;
+    }
+    bool operator!=(const PointBitset &other) const { return !(*this == other); }
+
+    const quint64 *words() const { return m_words.constData(); }
+    int wordCount() const { return m_words.size(); }
+
+private:
+    void trim()
+    {
+        // 最后一个字中超出size的位保持为0，count()和比较才正确
+        if (m_size & 63) {
+            m_words.last() &= (Q_UINT64_C(1) << (m_size & 63)) - 1;
+        }
+    }
+
+    QVector<quint64> m_words;   ///< 位数据，第i位在m_words[i/64]的第i%64位
+    int m_size;                 ///< 位数
+};
+
+inline PointBitset operator|(PointBitset a, const PointBitset &b) { a |= b; return a; }
+
+#endif // POINTBITSET_H
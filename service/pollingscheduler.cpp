@@ -0,0 +1,407 @@
+/**
+ * @file pollingscheduler.cpp
+ * @brief 轮询调度器实现
+ *
+ * 本文件实现了截止时间二叉最小堆（每个优先级一个）。删除和修改间隔时不在堆中查找，
+ * 而是递增任务版本号，旧条目在出堆时被丢弃。
+ * 各级的总线需求按执行耗时的滑动平均 / 配置间隔估算，每BudgetPeriodMs重新分配一次：
+ * 从关键级开始依次扣除需求，某一级的需求超过剩余预算时按比例拉长该级间隔，更低的级
+ * 拉长到MaxStretch倍。
+ */
+
+#include "pollingscheduler.h"
+
+#include <limits>
+#include <time.h>
+
+PollingScheduler::PollingScheduler()
+    : m_nextBudgetNs(0)
+    , m_nextGeneration(1)
+    , m_statsSinceNs(monotonicNs())
+    , m_busyNs(0)
+    , m_nextStaleCheckNs(std::numeric_limits<qint64>::max())
+{
+    for (int p = 0; p < PriorityCount; ++p) {
+        m_demand[p] = 0.0;
+        m_stretch[p] = 1.0;
+    }
+}
+
+qint64 PollingScheduler::monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+qint64 PollingScheduler::wallClockNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+void PollingScheduler::push(int priority, const HeapEntry &entry)
+{
+    QVector<HeapEntry> &heap = m_heaps[priority];
+    heap.append(entry);
+    int i = heap.size() - 1;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (heap[parent].deadlineNs <= heap[i].deadlineNs) break;
+        qSwap(heap[parent], heap[i]);
+        i = parent;
+    }
+}
+
+void PollingScheduler::pop(int priority)
+{
+    QVector<HeapEntry> &heap = m_heaps[priority];
+    int last = heap.size() - 1;
+    heap[0] = heap[last];
+    heap.removeLast();
+
+    int n = heap.size();
+    int i = 0;
+    for (;;) {
+        int left = 2 * i + 1;
+        int right = left + 1;
+        int smallest = i;
+        if (left < n && heap[left].deadlineNs < heap[smallest].deadlineNs) smallest = left;
+        if (right < n && heap[right].deadlineNs < heap[smallest].deadlineNs) smallest = right;
+        if (smallest == i) break;
+        qSwap(heap[smallest], heap[i]);
+        i = smallest;
+    }
+}
+
+bool PollingScheduler::isStale(const HeapEntry &entry) const
+{
+    auto it = m_tasks.constFind(entry.deviceId);
+    return it == m_tasks.constEnd() || it->generation != entry.generation || it->running;
+}
+
+qint64 PollingScheduler::dropStale(int priority)
+{
+    QVector<HeapEntry> &heap = m_heaps[priority];
+    while (!heap.isEmpty() && isStale(heap[0])) {
+        pop(priority);
+    }
+    return heap.isEmpty() ? -1 : heap[0].deadlineNs;
+}
+
+void PollingScheduler::addDevice(int deviceId, int intervalMs, qint64 nowNs, int priority)
+{
+    intervalMs = qBound(static_cast<int>(MinIntervalMs), intervalMs, static_cast<int>(MaxIntervalMs));
+    if (priority < Critical || priority >= PriorityCount) {
+        priority = Normal;
+    }
+
+    auto it = m_tasks.find(deviceId);
+    if (it != m_tasks.end()) {
+        // 已在调度中：只修改间隔和优先级，保留统计；旧堆中的条目因版本号变化而作废
+        it->stats.intervalMs = intervalMs;
+        it->stats.priority = priority;
+        it->stats.effectiveIntervalMs = static_cast<int>(intervalNs(*it) / 1000000);
+        if (!it->running) {
+            it->generation = m_nextGeneration++;
+            it->deadlineNs = nowNs;
+            push(priority, { it->deadlineNs, deviceId, it->generation });
+        }
+        it->freshUntilNs = qMax(it->freshUntilNs, nowNs + intervalNs(*it));
+        return;
+    }
+
+    Task task;
+    task.deadlineNs = nowNs;
+    task.generation = m_nextGeneration++;
+    task.running = false;
+    task.staleReported = false;
+    task.lastStartNs = 0;
+    task.avgDurationNs = 0;
+    task.failing = false;
+    task.stats.deviceId = deviceId;
+    task.stats.priority = priority;
+    task.stats.intervalMs = intervalMs;
+    task.stats.effectiveIntervalMs = static_cast<int>(intervalNs(task) / 1000000);
+    task.freshUntilNs = nowNs + intervalNs(task);  // 首次采集的截止时间之后一个间隔
+    m_tasks.insert(deviceId, task);
+    push(priority, { task.deadlineNs, deviceId, task.generation });
+    m_nextStaleCheckNs = qMin(m_nextStaleCheckNs, task.freshUntilNs);
+}
+
+bool PollingScheduler::removeDevice(int deviceId)
+{
+    // 堆中的旧条目在出堆时丢弃
+    return m_tasks.remove(deviceId) > 0;
+}
+
+bool PollingScheduler::contains(int deviceId) const
+{
+    return m_tasks.contains(deviceId);
+}
+
+int PollingScheduler::deviceCount() const
+{
+    return m_tasks.size();
+}
+
+qint64 PollingScheduler::nextDeadlineNs()
+{
+    qint64 earliest = -1;
+    for (int p = 0; p < PriorityCount; ++p) {
+        qint64 deadline = dropStale(p);
+        if (deadline >= 0 && (earliest < 0 || deadline < earliest)) {
+            earliest = deadline;
+        }
+    }
+    return earliest;
+}
+
+int PollingScheduler::takeDue(qint64 nowNs)
+{
+    // 多个任务同时到期时先执行高优先级，总线超载时低优先级的任务排在后面
+    int priority = -1;
+    for (int p = 0; p < PriorityCount; ++p) {
+        qint64 deadline = dropStale(p);
+        if (deadline >= 0 && deadline <= nowNs) {
+            priority = p;
+            break;
+        }
+    }
+    if (priority < 0) {
+        return -1;
+    }
+
+    int deviceId = m_heaps[priority][0].deviceId;
+    pop(priority);
+
+    Task &task = m_tasks[deviceId];
+    task.running = true;
+
+    qint64 jitterUs = (nowNs - task.deadlineNs) / 1000;
+    task.stats.lastJitterUs = jitterUs;
+    task.stats.totalJitterUs += jitterUs;
+    if (jitterUs > task.stats.maxJitterUs) {
+        task.stats.maxJitterUs = jitterUs;
+    }
+    return deviceId;
+}
+
+void PollingScheduler::complete(int deviceId, qint64 startNs, qint64 endNs, bool success)
+{
+    auto it = m_tasks.find(deviceId);
+    if (it == m_tasks.end()) {
+        return;     // 执行期间已被移除
+    }
+
+    Task &task = *it;
+    task.running = false;
+
+    qint64 durationUs = (endNs - startNs) / 1000;
+    task.stats.runs++;
+    task.stats.lastDurationUs = durationUs;
+    task.stats.totalDurationUs += durationUs;
+    if (durationUs > task.stats.maxDurationUs) {
+        task.stats.maxDurationUs = durationUs;
+    }
+    if (task.lastStartNs > 0) {
+        task.stats.periods++;
+        task.stats.totalPeriodUs += (startNs - task.lastStartNs) / 1000;
+    }
+    task.lastStartNs = startNs;
+    qint64 durationNs = endNs - startNs;
+    // 离线设备每次都等满超时，这类耗时计入需求会拉长本级和所有更低级的间隔
+    task.failing = !success;
+    if (success) {
+        task.avgDurationNs = task.avgDurationNs > 0 ? task.avgDurationNs + (durationNs - task.avgDurationNs) / 8
+                                                    : durationNs;
+    }
+    m_busyNs += durationNs;
+
+    if (endNs >= m_nextBudgetNs) {
+        updateBudget(endNs);
+    }
+    reschedule(deviceId, task, endNs);
+}
+
+void PollingScheduler::markFresh(int deviceId)
+{
+    auto it = m_tasks.find(deviceId);
+    if (it == m_tasks.end()) {
+        return;
+    }
+    it->freshUntilNs = it->deadlineNs + intervalNs(*it);
+    it->staleReported = false;
+    m_nextStaleCheckNs = qMin(m_nextStaleCheckNs, it->freshUntilNs);
+}
+
+int PollingScheduler::takeStale(qint64 nowNs)
+{
+    if (nowNs < m_nextStaleCheckNs) {
+        return -1;
+    }
+
+    // 到期时才扫描一遍，同时求出下一次需要检查的时间
+    int found = -1;
+    qint64 next = std::numeric_limits<qint64>::max();
+    for (auto it = m_tasks.begin(); it != m_tasks.end(); ++it) {
+        if (it->staleReported) {
+            continue;
+        }
+        if (found < 0 && it->freshUntilNs <= nowNs) {
+            it->staleReported = true;
+            found = it.key();
+        } else {
+            next = qMin(next, it->freshUntilNs);
+        }
+    }
+    m_nextStaleCheckNs = next;
+    return found;
+}
+
+void PollingScheduler::skip(int deviceId, qint64 nowNs)
+{
+    auto it = m_tasks.find(deviceId);
+    if (it == m_tasks.end()) {
+        return;
+    }
+
+    Task &task = *it;
+    task.running = false;
+    task.failing = true;
+    task.stats.skipped++;
+    reschedule(deviceId, task, nowNs);
+}
+
+void PollingScheduler::reschedule(int deviceId, Task &task, qint64 endNs)
+{
+    // 固定速率：从本次截止时间推进；已错过的周期直接跳过
+    qint64 interval = intervalNs(task);
+    task.stats.effectiveIntervalMs = static_cast<int>(interval / 1000000);
+    qint64 next = task.deadlineNs + interval;
+    if (next <= endNs) {
+        qint64 missed = (endNs - task.deadlineNs) / interval;
+        task.stats.overruns += missed;
+        next = task.deadlineNs + (missed + 1) * interval;
+    }
+
+    task.deadlineNs = next;
+    task.generation = m_nextGeneration++;
+    push(task.stats.priority, { task.deadlineNs, deviceId, task.generation });
+}
+
+qint64 PollingScheduler::intervalNs(const Task &task) const
+{
+    return static_cast<qint64>(task.stats.intervalMs * 1000000.0 * m_stretch[task.stats.priority]);
+}
+
+void PollingScheduler::updateBudget(qint64 nowNs)
+{
+    m_nextBudgetNs = nowNs + BudgetPeriodMs * 1000000LL;
+
+    for (int p = 0; p < PriorityCount; ++p) {
+        m_demand[p] = 0.0;
+    }
+    for (auto it = m_tasks.constBegin(); it != m_tasks.constEnd(); ++it) {
+        if (!it->failing) {
+            m_demand[it->stats.priority] += static_cast<double>(it->avgDurationNs) / (it->stats.intervalMs * 1000000.0);
+        }
+    }
+
+    // 关键级不拉长；其余各级依次分配剩余预算，不够时按需求/剩余预算的比例拉长
+    double remaining = BudgetPercent / 100.0;
+    for (int p = 0; p < PriorityCount; ++p) {
+        double demand = m_demand[p];
+        if (p == Critical || demand <= remaining) {
+            m_stretch[p] = 1.0;
+        } else {
+            m_stretch[p] = remaining > demand / MaxStretch ? demand / remaining : static_cast<double>(MaxStretch);
+        }
+        remaining = qMax(0.0, remaining - demand / m_stretch[p]);
+    }
+}
+
+PollingStats PollingScheduler::stats(int deviceId) const
+{
+    auto it = m_tasks.constFind(deviceId);
+    return it == m_tasks.constEnd() ? PollingStats() : it->stats;
+}
+
+QList<PollingStats> PollingScheduler::allStats() const
+{
+    QList<PollingStats> list;
+    for (auto it = m_tasks.constBegin(); it != m_tasks.constEnd(); ++it) {
+        list.append(it->stats);
+    }
+    return list;
+}
+
+QList<PriorityClassStats> PollingScheduler::classStats() const
+{
+    QList<PriorityClassStats> list;
+    double achievedSum[PriorityCount] = {};
+    int achievedCount[PriorityCount] = {};
+    for (int p = 0; p < PriorityCount; ++p) {
+        PriorityClassStats s;
+        s.priority = p;
+        s.demand = m_demand[p];
+        s.stretch = m_stretch[p];
+        list.append(s);
+    }
+    for (auto it = m_tasks.constBegin(); it != m_tasks.constEnd(); ++it) {
+        const PollingStats &st = it->stats;
+        PriorityClassStats &s = list[st.priority];
+        s.deviceCount++;
+        s.configuredIntervalMs += st.intervalMs;
+        if (st.periods > 0) {
+            achievedSum[st.priority] += st.totalPeriodUs / 1000.0 / st.periods;
+            achievedCount[st.priority]++;
+        }
+    }
+    for (int p = 0; p < PriorityCount; ++p) {
+        PriorityClassStats &s = list[p];
+        if (s.deviceCount > 0) {
+            s.configuredIntervalMs /= s.deviceCount;
+        }
+        if (achievedCount[p] > 0) {
+            s.achievedIntervalMs = achievedSum[p] / achievedCount[p];
+        }
+    }
+    return list;
+}
+
+QString PollingScheduler::priorityName(int priority)
+{
+    switch (priority) {
+    case Critical:   return "关键";
+    case Normal:     return "常规";
+    case Diagnostic: return "诊断";
+    default:         return "未知";
+    }
+}
+
+void PollingScheduler::addBusyTime(qint64 durationNs)
+{
+    m_busyNs += durationNs;
+}
+
+double PollingScheduler::utilization(qint64 nowNs) const
+{
+    qint64 elapsed = nowNs - m_statsSinceNs;
+    return elapsed > 0 ? static_cast<double>(m_busyNs) / elapsed : 0.0;
+}
+
+void PollingScheduler::resetStats(qint64 nowNs)
+{
+    for (auto it = m_tasks.begin(); it != m_tasks.end(); ++it) {
+        PollingStats previous = it->stats;
+        it->stats = PollingStats();
+        it->stats.deviceId = previous.deviceId;
+        it->stats.priority = previous.priority;
+        it->stats.intervalMs = previous.intervalMs;
+        it->stats.effectiveIntervalMs = previous.effectiveIntervalMs;
+    }
+    m_statsSinceNs = nowNs;
+    m_busyNs = 0;
+}
@@ -0,0 +1,258 @@
+/**
+ * @file pollingscheduler.h
+ * @brief 轮询调度器定义
+ *
+ * 本文件定义了基于截止时间最小堆的轮询调度器。每个设备按自己的
+ * pollInterval（100ms-60s）独立调度，并记录抖动、超期和耗时统计。
+ * 调度器同时按截止时间判断数据是否过期：设备在下一截止时间之后再过一个间隔
+ * 仍没有成功采集，其数据即视为过期。
+ * 设备分为关键、常规、诊断三个优先级，同时到期时先执行高优先级；总线超载时
+ * 按各级的总线需求从低优先级开始拉长间隔，关键设备的间隔不变。
+ */
+
+#ifndef POLLINGSCHEDULER_H
+#define POLLINGSCHEDULER_H
+
+#include <QtGlobal>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+/**
+ * @struct PollingStats
+ * @brief 单个设备的调度统计
+ */
+struct PollingStats {
+    int deviceId;           ///< 设备ID
+    int priority;           ///< 优先级（PollingScheduler::Priority）
+    int intervalMs;         ///< 配置的轮询间隔（毫秒）
+    int effectiveIntervalMs; ///< 按总线预算拉长后实际使用的间隔（毫秒）
+    qint64 runs;            ///< 已执行次数
+    qint64 overruns;        ///< 因上一轮超时而错过的周期数
+    qint64 skipped;         ///< 因设备退避而放弃的周期数
+    qint64 lastJitterUs;    ///< 最近一次实际开始时间与截止时间之差（微秒）
+    qint64 maxJitterUs;     ///< 最大抖动（微秒）
+    qint64 totalJitterUs;   ///< 抖动累计（微秒），除以runs得平均值
+    qint64 lastDurationUs;  ///< 最近一次执行耗时（微秒）
+    qint64 maxDurationUs;   ///< 最大执行耗时（微秒）
+    qint64 totalDurationUs; ///< 执行耗时累计（微秒）
+    qint64 periods;         ///< 相邻两次执行的间隔个数
+    qint64 totalPeriodUs;   ///< 相邻两次执行开始时间之差的累计（微秒），除以periods得实际间隔
+
+    PollingStats()
+        : deviceId(-1), priority(1), intervalMs(0), effectiveIntervalMs(0), runs(0), overruns(0),
+          skipped(0), lastJitterUs(0), maxJitterUs(0), totalJitterUs(0), lastDurationUs(0),
+          maxDurationUs(0), totalDurationUs(0), periods(0), totalPeriodUs(0) {}
+};
+
+/**
+ * @struct PriorityClassStats
+ * @brief 一个优先级的调度统计
+ */
+struct PriorityClassStats {
+    int priority;                   ///< 优先级（PollingScheduler::Priority）
+    int deviceCount;                ///< 设备数
+    double demand;                  ///< 按配置间隔需要的总线占用率（0.0-1.0，可超过1.0）
+    double stretch;                 ///< 间隔拉长倍数，1.0表示未拉长
+    double configuredIntervalMs;    ///< 配置间隔的平均值（毫秒）
+    double achievedIntervalMs;      ///< 实际间隔的平均值（毫秒），尚无数据时为0
+
+    PriorityClassStats()
+        : priority(0), deviceCount(0), demand(0.0), stretch(1.0), configuredIntervalMs(0.0),
+          achievedIntervalMs(0.0) {}
+};
+
+/**
+ * @class PollingScheduler
+ * @brief 轮询调度器类
+ *
+ * 以固定速率调度：下一截止时间 = 本次截止时间 + 间隔，不随执行耗时漂移。
+ * 执行耗时超过间隔时跳过已错过的周期并计入overruns，不会积压补跑。
+ * 本类不持有定时器，由调用者按nextDeadlineNs()等待后调用takeDue()。
+ * 非线程安全，应由单一线程驱动。
+ */
+class PollingScheduler
+{
+public:
+    /**
+     * @brief 间隔限制（与DeviceService::validateConfig一致）
+     */
+    enum Limits {
+        MinIntervalMs = 100,
+        MaxIntervalMs = 60000,
+        BudgetPercent = 90,     ///< 周期采集可用的总线时间比例，其余留给写命令和探测
+        MaxStretch = 16,        ///< 间隔最多拉长的倍数
+        BudgetPeriodMs = 1000   ///< 重新计算各级拉长倍数的周期
+    };
+
+    /**
+     * @brief 优先级（数值越小越优先）
+     */
+    enum Priority {
+        Critical = 0,           ///< 关键：安全相关值，总线超载时也按配置间隔采集
+        Normal = 1,             ///< 常规：工艺过程值
+        Diagnostic = 2,         ///< 诊断：慢变的诊断信息，总线超载时最先拉长间隔
+        PriorityCount = 3
+    };
+
+    PollingScheduler();
+
+    /**
+     * @brief 添加或更新设备的调度任务
+     * @param deviceId 设备ID
+     * @param intervalMs 轮询间隔（毫秒），超出范围时截断
+     * @param nowNs 当前单调时间，首次截止时间即为此刻
+     * @param priority 优先级，超出范围时按Normal处理
+     */
+    void addDevice(int deviceId, int intervalMs, qint64 nowNs, int priority = Normal);
+
+    /**
+     * @brief 移除设备的调度任务
+     * @param deviceId 设备ID
+     * @return true表示该设备原本在调度中
+     */
+    bool removeDevice(int deviceId);
+
+    /**
+     * @brief 判断设备是否在调度中
+     */
+    bool contains(int deviceId) const;
+
+    /**
+     * @brief 调度中的设备数
+     */
+    int deviceCount() const;
+
+    /**
+     * @brief 最早的截止时间
+     * @return 单调时间（纳秒），没有待调度任务时返回-1
+     */
+    qint64 nextDeadlineNs();
+
+    /**
+     * @brief 取出一个已到期的任务
+     * @param nowNs 当前单调时间
+     * @return 设备ID，没有到期任务时返回-1
+     */
+    int takeDue(qint64 nowNs);
+
+    /**
+     * @brief 报告任务执行完成并重新排入堆
+     * @param deviceId 设备ID
+     * @param startNs 实际开始时间
+     * @param endNs 实际结束时间
+     * @param success 是否采集成功；失败（多为等满超时）的耗时不计入总线需求
+     */
+    void complete(int deviceId, qint64 startNs, qint64 endNs, bool success);
+
+    /**
+     * @brief 放弃本周期（设备处于退避期），不计入执行次数和耗时，退避期间不计入总线需求
+     * @param deviceId 设备ID
+     * @param nowNs 当前单调时间
+     */
+    void skip(int deviceId, qint64 nowNs);
+
+    /**
+     * @brief 报告设备本轮采集成功，数据保鲜到下一截止时间之后一个间隔
+     *
+     * 应在complete()之后调用（此时下一截止时间已确定）。
+     * @param deviceId 设备ID
+     */
+    void markFresh(int deviceId);
+
+    /**
+     * @brief 取出一个刚过期的设备（每次过期只报告一次，直到再次markFresh()）
+     * @param nowNs 当前单调时间
+     * @return 设备ID，没有新过期的设备时返回-1；最早保鲜期未到时O(1)返回
+     */
+    int takeStale(qint64 nowNs);
+
+    /**
+     * @brief 计入非周期任务（写命令、探测等）占用的总线时间
+     * @param durationNs 占用时间（纳秒）
+     */
+    void addBusyTime(qint64 durationNs);
+
+    /**
+     * @brief 获取单个设备的统计
+     */
+    PollingStats stats(int deviceId) const;
+
+    /**
+     * @brief 获取所有设备的统计
+     */
+    QList<PollingStats> allStats() const;
+
+    /**
+     * @brief 获取各优先级的统计（按优先级排列，共PriorityCount项）
+     */
+    QList<PriorityClassStats> classStats() const;
+
+    /**
+     * @brief 优先级名称
+     */
+    static QString priorityName(int priority);
+
+    /**
+     * @brief 统计窗口内的总线占用率（执行耗时之和 / 经过时间）
+     * @param nowNs 当前单调时间
+     * @return 0.0-1.0，超过1.0表示任务量超出总线能力
+     */
+    double utilization(qint64 nowNs) const;
+
+    /**
+     * @brief 清零所有统计，重新开始统计窗口
+     * @param nowNs 当前单调时间
+     */
+    void resetStats(qint64 nowNs);
+
+    /**
+     * @brief 获取单调时钟（纳秒）
+     */
+    static qint64 monotonicNs();
+
+    /**
+     * @brief 获取墙上时钟（自1970年起的纳秒数，用作采集时间戳）
+     */
+    static qint64 wallClockNs();
+
+private:
+    struct Task {
+        qint64 deadlineNs;      ///< 当前截止时间
+        quint32 generation;     ///< 版本号，用于堆中旧条目的惰性删除
+        bool running;           ///< 是否已取出正在执行
+        qint64 freshUntilNs;    ///< 数据保鲜期限，过后仍未成功采集即为过期
+        bool staleReported;     ///< 本次过期是否已由takeStale()报告
+        qint64 lastStartNs;     ///< 上次执行的开始时间，0表示尚未执行
+        qint64 avgDurationNs;   ///< 成功执行耗时的指数滑动平均，用于估算总线需求
+        bool failing;           ///< 最近一次执行失败或处于退避期，不计入总线需求
+        PollingStats stats;     ///< 统计
+    };
+
+    struct HeapEntry {
+        qint64 deadlineNs;
+        int deviceId;
+        quint32 generation;
+    };
+
+    void push(int priority, const HeapEntry &entry);
+    void pop(int priority);
+    bool isStale(const HeapEntry &entry) const;
+    qint64 dropStale(int priority);
+    void reschedule(int deviceId, Task &task, qint64 endNs);
+    qint64 intervalNs(const Task &task) const;
+    void updateBudget(qint64 nowNs);
+
+    QVector<HeapEntry> m_heaps[PriorityCount];  ///< 每个优先级一个按截止时间排列的二叉最小堆
+    double m_demand[PriorityCount];     ///< 各级按配置间隔需要的总线占用率
+    double m_stretch[PriorityCount];    ///< 各级的间隔拉长倍数
+    qint64 m_nextBudgetNs;          ///< 下次重新计算拉长倍数的时间
+    QHash<int, Task> m_tasks;       ///< 设备ID → 任务
+    quint32 m_nextGeneration;       ///< 下一个版本号
+    qint64 m_statsSinceNs;          ///< 统计窗口起点
+    qint64 m_busyNs;                ///< 统计窗口内执行耗时之和
+    qint64 m_nextStaleCheckNs;      ///< 未报告设备中最早的保鲜期限（下界）
+};
+
+#endif // POLLINGSCHEDULER_H
@@ -0,0 +1,194 @@
+/**
+ * @file pollingtask.cpp
+ * @brief 单设备采集任务实现
+ *
+ * 本文件实现了采集任务的规划、执行和结果拆分。寄存器先按读请求整段解码，
+ * 再按每个采集点的数据类型和字节序整段解码，直接写入结果快照。
+ */
+
+#include "pollingtask.h"
+#include "pollingscheduler.h"
+#include "realtimecache.h"
+#include "timeseriesstore.h"
+
+PollingTask::PollingTask(const DeviceConfig &cfg)
+    : m_cfg(cfg)
+    , m_points(ReadPlanner::devicePoints(cfg))
+    , m_blocks(ReadPlanner::plan(m_points, cfg.gapThreshold))
+    , m_valueCount(0)
+{
+    int total = 0;
+    for (const ReadBlock &block : m_blocks) {
+        m_blockOffsets.append(total);
+        total += block.count;
+    }
+    m_values.resize(total);
+    m_transactions.resize(m_blocks.size());
+
+    // 为每个采集点找到覆盖它的读请求
+    int valueTotal = 0;
+    int maxSpan = 0;
+    for (const RegisterPoint &p : m_points) {
+        m_valueOffsets.append(valueTotal);
+        valueTotal += p.valueCount();
+        maxSpan = qMax(maxSpan, p.count);
+
+        int offset = 0;
+        for (int b = 0; b < m_blocks.size(); ++b) {
+            const ReadBlock &block = m_blocks[b];
+            if (block.functionCode == p.functionCode && block.start <= p.address
+                    && p.address + p.count <= block.start + block.count) {
+                offset = m_blockOffsets[b] + (p.address - block.start);
+                break;
+            }
+        }
+        m_pointOffsets.append(offset);
+    }
+    m_scratch.resize(maxSpan);
+    m_snapshotPool.reserve(MaxPooledSnapshots);
+
+    m_layout = QSharedPointer<RegisterLayout>::create();
+    m_layout->addresses.reserve(valueTotal);
+    m_layout->names.reserve(valueTotal);
+    m_layout->units.reserve(valueTotal);
+    for (const RegisterPoint &p : m_points) {
+        int width = RegisterDecoder::registerWidth(p.dataType);
+        int valueCount = p.valueCount();
+        for (int k = 0; k < valueCount; ++k) {
+            int address = p.address + k * width;
+            m_layout->addresses.append(address);
+            if (p.name.isEmpty()) {
+                m_layout->names.append(QString("寄存器 %1").arg(address));
+            } else {
+                m_layout->names.append(valueCount > 1 ? QString("%1[%2]").arg(p.name).arg(k) : p.name);
+            }
+            m_layout->units.append(p.unit);
+            m_layout->scales.append(p.scale);
+            m_layout->offsets.append(p.offset);
+            m_layout->deadbands.append(p.deadband);
+            m_layout->rangeLows.append(p.rangeLow);
+            m_layout->rangeHighs.append(p.rangeHigh);
+        }
+    }
+    m_layout->physicalCount = valueTotal;
+
+    // 派生点公式在这里编译一次，之后每轮只执行字节码；配置已校验过，失败时该点恒为无效
+    DeviceService::compileDerivedPoints(cfg, m_layout->addresses, &m_layout->formulas);
+    for (int k = 0; k < cfg.derivedPoints.size(); ++k) {
+        const DerivedPoint &d = cfg.derivedPoints[k];
+        if (k >= m_layout->formulas.size()) {
+            m_layout->formulas.append(Formula());
+        }
+        m_layout->addresses.append(d.address);
+        m_layout->names.append(d.name.isEmpty() ? QString("派生 %1").arg(d.address) : d.name);
+        m_layout->units.append(d.unit);
+        m_layout->scales.append(1.0);
+        m_layout->offsets.append(0.0);
+        m_layout->deadbands.append(d.deadband);
+        m_layout->rangeLows.append(d.rangeLow);
+        m_layout->rangeHighs.append(d.rangeHigh);
+    }
+    m_valueCount = m_layout->addresses.size();
+}
+
+void PollingTask::bindRealtimeCache()
+{
+    m_layout->cacheSlots.clear();
+    for (int address : m_layout->addresses) {
+        int slot = RealtimeCache::acquireSlot(m_cfg.id, address);
+        m_layout->cacheSlots.append(slot);
+        TimeSeriesStore::attach(slot, m_cfg.id, address);
+    }
+}
+
+void PollingTask::addCacheFlags(quint8 flags)
+{
+    for (int slot : m_layout->cacheSlots) {
+        RealtimeCache::addFlags(slot, flags);
+    }
+}
+
+QExplicitlySharedDataPointer<RegisterSnapshot> PollingTask::takeSnapshot()
+{
+    // 只剩池中一个引用的快照已被所有下游释放，引用计数不会再增加，可以原地复用
+    for (const QExplicitlySharedDataPointer<RegisterSnapshot> &s : m_snapshotPool) {
+        if (s->ref.loadAcquire() == 1) {
+            return s;
+        }
+    }
+    QExplicitlySharedDataPointer<RegisterSnapshot> s(new RegisterSnapshot());
+    if (m_snapshotPool.size() < MaxPooledSnapshots) {
+        m_snapshotPool.append(s);
+    }
+    return s;
+}
+
+Result PollingTask::execute(ModbusTransport *transport, int timeoutMs,
+                            QExplicitlySharedDataPointer<RegisterSnapshot> *snapshot)
+{
+    quint8 slave = static_cast<quint8>(m_cfg.modbusAddress);
+
+    for (int b = 0; b < m_blocks.size(); ++b) {
+        const ReadBlock &block = m_blocks[b];
+        quint8 fc = static_cast<quint8>(block.functionCode);
+        quint16 count = static_cast<quint16>(block.count);
+        ModbusTransaction &t = m_transactions[b];
+
+        ModbusRtu::Status status = ModbusRtu::encodeReadRequest(
+            t.request, slave, fc, static_cast<quint16>(block.start), count);
+        if (status != ModbusRtu::Ok) {
+            return Result::error(status, ModbusRtu::statusText(status));
+        }
+        t.expectedLength = ModbusRtu::expectedReadResponseLength(fc, count);
+    }
+
+    // 各读请求相互独立，支持流水线的传输层可让它们同时在途
+    transport->transactBatch(m_transactions.data(), m_transactions.size(), timeoutMs);
+
+    for (int b = 0; b < m_blocks.size(); ++b) {
+        const ReadBlock &block = m_blocks[b];
+        quint8 fc = static_cast<quint8>(block.functionCode);
+        quint16 count = static_cast<quint16>(block.count);
+        const ModbusTransaction &t = m_transactions[b];
+
+        ModbusRtu::Status status = t.status;
+        if (status == ModbusRtu::Ok) {
+            m_health.recordRtt(t.rttUs);
+
+            quint8 exceptionCode = 0;
+            status = ModbusRtu::decodeReadResponse(t.response, slave, fc, count,
+                                                   m_values.data() + m_blockOffsets[b], &exceptionCode);
+            if (status == ModbusRtu::ErrException) {
+                m_health.recordSuccess();   // 设备有应答，链路正常
+                addCacheFlags(RegisterSnapshot::FlagCommLost);
+                return Result::error(status, QString("%1（异常码%2）")
+                                     .arg(ModbusRtu::statusText(status)).arg(exceptionCode));
+            }
+        }
+        if (status != ModbusRtu::Ok) {
+            m_health.recordFailure(PollingScheduler::monotonicNs(), m_cfg.pollInterval);
+            addCacheFlags(RegisterSnapshot::FlagCommLost);
+            return Result::error(status, ModbusRtu::statusText(status));
+        }
+    }
+    m_health.recordSuccess();
+
+    // 复用的快照各数组大小不变，resize和fill不会重新分配
+    QExplicitlySharedDataPointer<RegisterSnapshot> s = takeSnapshot();
+    s->deviceId = m_cfg.id;
+    s->layout = m_layout;
+    s->values.resize(m_valueCount);
+    s->resetFlags(m_valueCount);
+    s->timestampsNs.fill(PollingScheduler::wallClockNs(), m_valueCount);
+    s->monotonicNs = PollingScheduler::monotonicNs();
+
+    for (int i = 0; i < m_points.size(); ++i) {
+        const RegisterPoint &p = m_points[i];
+        RegisterDecoder::decode(p.dataType, p.byteOrder, m_values.constData() + m_pointOffsets[i],
+                                p.valueCount(), 1.0, 0.0,
+                                s->values.data() + m_valueOffsets[i], m_scratch.data());
+    }
+
+    *snapshot = s;
+    return Result::success();
+}
@@ -0,0 +1,108 @@
+/**
+ * @file pollingtask.h
+ * @brief 单设备采集任务定义
+ *
+ * 本文件定义了PollingTask：针对单个设备按读取规划执行读操作，
+ * 并把各读请求的结果拆回到每个采集点。任务在构造时完成规划并预分配
+ * 帧缓冲区和寄存器缓冲区，之后每次执行都复用这些缓冲区；结果快照取自任务的快照池，
+ * 下游释放后原地复用，预热后每轮采集不分配内存。
+ * 一个周期的所有读请求作为一批交给传输层，Modbus TCP下可同时在途。
+ */
+
+#ifndef POLLINGTASK_H
+#define POLLINGTASK_H
+
+#include "deviceservice.h"
+#include "linkhealth.h"
+#include "modbustransport.h"
+#include "readplanner.h"
+#include "registersnapshot.h"
+
+/**
+ * @class PollingTask
+ * @brief 单设备采集任务类
+ *
+ * 非线程安全，一个任务同一时间只应由一个线程执行。
+ */
+class PollingTask
+{
+public:
+    enum Limits {
+        MaxPooledSnapshots = 8      ///< 快照池上限，下游同时持有更多快照时另行分配且不回收
+    };
+
+    /**
+     * @brief 按设备配置构造任务并完成读取规划
+     * @param cfg 设备配置
+     */
+    explicit PollingTask(const DeviceConfig &cfg);
+
+    /**
+     * @brief 执行一次采集
+     *
+     * 快照中是按数据类型解码后的原始值，系数、偏移和死区由DataPipeline处理。
+     * @param transport 传输层
+     * @param timeoutMs 每个读请求的响应超时（毫秒）
+     * @param snapshot 成功时输出新的快照
+     * @return Result 采集结果
+     */
+    Result execute(ModbusTransport *transport, int timeoutMs,
+                   QExplicitlySharedDataPointer<RegisterSnapshot> *snapshot);
+
+    /**
+     * @brief 为各值分配实时值缓存槽和历史存储的内存环，之后每次采集都写入缓存和历史
+     *
+     * 只由周期采集的任务调用；一次性读取（可能改写了功能码和区间）不写缓存。
+     */
+    void bindRealtimeCache();
+
+    /**
+     * @brief 给该设备在实时值缓存中的所有值追加标志（下次采集成功时清除）
+     * @param flags RegisterSnapshot::Flag的组合
+     */
+    void addCacheFlags(quint8 flags);
+
+    /**
+     * @brief 设备配置
+     */
+    const DeviceConfig &config() const { return m_cfg; }
+
+    /**
+     * @brief 合并后的读请求
+     */
+    const QVector<ReadBlock> &blocks() const { return m_blocks; }
+
+    /**
+     * @brief 采集点数（不合并时每点一次事务）
+     */
+    int pointCount() const { return m_points.size(); }
+
+    /**
+     * @brief 合并后每周期的事务数
+     */
+    int transactionCount() const { return m_blocks.size(); }
+
+    /**
+     * @brief 链路健康度（往返时间、自适应超时和退避状态）
+     */
+    const LinkHealth &health() const { return m_health; }
+
+private:
+    QExplicitlySharedDataPointer<RegisterSnapshot> takeSnapshot();
+
+    DeviceConfig m_cfg;                 ///< 设备配置
+    QVector<RegisterPoint> m_points;    ///< 采集点
+    QVector<ReadBlock> m_blocks;        ///< 合并后的读请求
+    QVector<int> m_blockOffsets;        ///< 每个读请求在m_values中的起始下标
+    QVector<int> m_pointOffsets;        ///< 每个采集点在m_values中的起始下标
+    QVector<quint16> m_values;          ///< 所有读请求的解码结果
+    QVector<int> m_valueOffsets;        ///< 每个采集点在快照值数组中的起始下标
+    int m_valueCount;                   ///< 快照中的值个数（含派生点）
+    QSharedPointer<RegisterLayout> m_layout;    ///< 各轮快照共享的地址、名称、换算参数和缓存槽
+    QVector<quint16> m_scratch;         ///< 字节交换用的临时缓冲区
+    QVector<ModbusTransaction> m_transactions;  ///< 每个读请求的收发缓冲区
+    LinkHealth m_health;                ///< 链路健康度
+    QVector<QExplicitlySharedDataPointer<RegisterSnapshot>> m_snapshotPool; ///< 快照池，池外无引用的快照可复用
+};
+
+#endif // POLLINGTASK_H
@@ -0,0 +1,60 @@
+/**
+ * @file readplanner.cpp
+ * @brief Modbus读取合并规划器实现
+ *
+ * 本文件实现了贪心合并：按(功能码, 地址)排序后顺序扫描，下一个点与当前块
+ * 的空洞不超过阈值、且合并后长度不超过上限时并入当前块，否则开始新块。
+ */
+
+#include "readplanner.h"
+#include "modbusrtu.h"
+
+#include <algorithm>
+
+int ReadPlanner::maxBlockSize(int functionCode)
+{
+    return functionCode <= 2 ? static_cast<int>(ModbusRtu::MaxReadBits)
+                             : static_cast<int>(ModbusRtu::MaxReadRegisters);
+}
+
+QVector<RegisterPoint> ReadPlanner::devicePoints(const DeviceConfig &cfg)
+{
+    if (!cfg.points.isEmpty()) {
+        return cfg.points;
+    }
+    return QVector<RegisterPoint>() << RegisterPoint(cfg.functionCode, cfg.startAddress, cfg.registerCount);
+}
+
+QVector<ReadBlock> ReadPlanner::plan(QVector<RegisterPoint> points, int gapThreshold)
+{
+    QVector<ReadBlock> blocks;
+    if (points.isEmpty()) {
+        return blocks;
+    }
+
+    std::sort(points.begin(), points.end(), [](const RegisterPoint &a, const RegisterPoint &b) {
+        return a.functionCode != b.functionCode ? a.functionCode < b.functionCode
+                                                : a.address < b.address;
+    });
+
+    ReadBlock current = { points[0].functionCode, points[0].address, points[0].count };
+    for (int i = 1; i < points.size(); ++i) {
+        const RegisterPoint &p = points[i];
+        int currentEnd = current.start + current.count;
+        int pointEnd = p.address + p.count;
+        int mergedEnd = qMax(currentEnd, pointEnd);
+
+        if (p.functionCode == current.functionCode
+                && p.address - currentEnd <= gapThreshold
+                && mergedEnd - current.start <= maxBlockSize(p.functionCode)) {
+            current.count = mergedEnd - current.start;
+            continue;
+        }
+
+        blocks.append(current);
+        current = { p.functionCode, p.address, p.count };
+    }
+    blocks.append(current);
+
+    return blocks;
+}
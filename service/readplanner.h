@@ -0,0 +1,57 @@
+/**
+ * @file readplanner.h
+ * @brief Modbus读取合并规划器定义
+ *
+ * 本文件定义了读取规划器：把设备需要的离散采集点合并为尽量少的合法读请求。
+ * 每个读请求只包含一种功能码，长度不超过协议上限（125个寄存器/2000个位），
+ * 点之间不超过空洞阈值的未用寄存器会被一并读取。
+ */
+
+#ifndef READPLANNER_H
+#define READPLANNER_H
+
+#include "deviceservice.h"
+
+/**
+ * @struct ReadBlock
+ * @brief 一次读请求覆盖的连续区间
+ */
+struct ReadBlock {
+    int functionCode;   ///< 功能码（01-04）
+    int start;          ///< 起始地址
+    int count;          ///< 数量（寄存器数或位数）
+};
+
+/**
+ * @class ReadPlanner
+ * @brief 读取合并规划器类
+ */
+class ReadPlanner
+{
+public:
+    /**
+     * @brief 将采集点合并为读请求
+     * @param points 采集点（无需排序，可重叠）
+     * @param gapThreshold 允许填充的最大空洞（寄存器/位数）
+     * @return 读请求列表，按功能码、地址升序
+     */
+    static QVector<ReadBlock> plan(QVector<RegisterPoint> points, int gapThreshold);
+
+    /**
+     * @brief 获取设备实际需要采集的点
+     *
+     * 设备配置了离散采集点时直接返回；否则返回startAddress起registerCount个寄存器组成的单个点。
+     * @param cfg 设备配置
+     * @return 采集点列表
+     */
+    static QVector<RegisterPoint> devicePoints(const DeviceConfig &cfg);
+
+    /**
+     * @brief 获取功能码单次读取的最大数量
+     * @param functionCode 功能码
+     * @return FC01/02为2000，FC03/04为125
+     */
+    static int maxBlockSize(int functionCode);
+};
+
+#endif // READPLANNER_H
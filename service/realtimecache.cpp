@@ -0,0 +1,159 @@
+/**
+ * @file realtimecache.cpp
+ * @brief 实时值缓存实现
+ */
+
+#include "realtimecache.h"
+
+#include <atomic>
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief 一个点的槽
+ *
+ * 数据字段也声明为原子量（relaxed读写），使读者与写者并发访问在语言层面无数据竞争；
+ * 一致性由seq保证。
+ */
+struct Slot {
+    std::atomic<quint64> key;           ///< 0表示空槽
+    std::atomic<quint32> seq;           ///< 顺序锁序号，奇数表示正在写
+    std::atomic<quint64> valueBits;     ///< 工程值（double的位模式）
+    std::atomic<qint64> timestampNs;    ///< 采集时间，0表示尚未写入
+    std::atomic<quint32> flags;         ///< 标志（RegisterSnapshot::Flag）
+};
+
+Slot s_slots[RealtimeCache::Capacity];
+std::atomic<int> s_slotCount(0);
+
+inline quint64 makeKey(int deviceId, int address)
+{
+    // 最高位置1，保证键非0
+    return (Q_UINT64_C(1) << 63) | (static_cast<quint64>(static_cast<quint32>(deviceId)) << 32)
+            | static_cast<quint32>(address);
+}
+
+inline int homeIndex(quint64 key)
+{
+    return static_cast<int>((key * Q_UINT64_C(0x9E3779B97F4A7C15)) >> 52) & (RealtimeCache::Capacity - 1);
+}
+
+inline void beginWrite(Slot &s)
+{
+    quint32 seq = s.seq.load(std::memory_order_relaxed);
+    s.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+inline void endWrite(Slot &s)
+{
+    s.seq.store(s.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+} // namespace
+
+int RealtimeCache::acquireSlot(int deviceId, int address)
+{
+    quint64 key = makeKey(deviceId, address);
+    int index = homeIndex(key);
+    for (int probe = 0; probe < Capacity; ++probe, index = (index + 1) & (Capacity - 1)) {
+        quint64 expected = 0;
+        std::atomic<quint64> &slotKey = s_slots[index].key;
+        if (slotKey.load(std::memory_order_acquire) == key) {
+            return index;
+        }
+        if (slotKey.compare_exchange_strong(expected, key, std::memory_order_acq_rel)) {
+            s_slotCount.fetch_add(1, std::memory_order_relaxed);
+            return index;
+        }
+        if (expected == key) {
+            return index;   // 另一个线程刚刚分配了同一个点
+        }
+    }
+    return -1;
+}
+
+int RealtimeCache::findSlot(int deviceId, int address)
+{
+    quint64 key = makeKey(deviceId, address);
+    int index = homeIndex(key);
+    for (int probe = 0; probe < Capacity; ++probe, index = (index + 1) & (Capacity - 1)) {
+        quint64 slotKey = s_slots[index].key.load(std::memory_order_acquire);
+        if (slotKey == key) {
+            return index;
+        }
+        if (slotKey == 0) {
+            return -1;      // 槽不回收，遇到空槽即可停止探测
+        }
+    }
+    return -1;
+}
+
+void RealtimeCache::store(int slot, double value, qint64 timestampNs, quint8 flags)
+{
+    if (slot < 0 || slot >= Capacity) {
+        return;
+    }
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    Slot &s = s_slots[slot];
+    beginWrite(s);
+    s.valueBits.store(bits, std::memory_order_relaxed);
+    s.timestampNs.store(timestampNs, std::memory_order_relaxed);
+    s.flags.store(flags, std::memory_order_relaxed);
+    endWrite(s);
+}
+
+void RealtimeCache::addFlags(int slot, quint8 flags)
+{
+    if (slot < 0 || slot >= Capacity) {
+        return;
+    }
+    Slot &s = s_slots[slot];
+    beginWrite(s);
+    s.flags.store(s.flags.load(std::memory_order_relaxed) | flags, std::memory_order_relaxed);
+    endWrite(s);
+}
+
+bool RealtimeCache::read(int slot, Value *value)
+{
+    if (slot < 0 || slot >= Capacity) {
+        return false;
+    }
+    const Slot &s = s_slots[slot];
+    quint64 bits;
+    qint64 timestampNs;
+    quint32 flags;
+    for (;;) {
+        quint32 before = s.seq.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;   // 写者正在写，写入只有几条指令，自旋即可
+        }
+        bits = s.valueBits.load(std::memory_order_relaxed);
+        timestampNs = s.timestampNs.load(std::memory_order_relaxed);
+        flags = s.flags.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s.seq.load(std::memory_order_relaxed) == before) {
+            break;
+        }
+    }
+    if (timestampNs == 0) {
+        return false;
+    }
+    std::memcpy(&value->value, &bits, sizeof(bits));
+    value->timestampNs = timestampNs;
+    value->flags = static_cast<quint8>(flags);
+    return true;
+}
+
+bool RealtimeCache::read(int deviceId, int address, Value *value)
+{
+    return read(findSlot(deviceId, address), value);
+}
+
+int RealtimeCache::slotCount()
+{
+    return s_slotCount.load(std::memory_order_relaxed);
+}
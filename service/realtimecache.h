@@ -0,0 +1,84 @@
+/**
+ * @file realtimecache.h
+ * @brief 实时值缓存定义
+ *
+ * 本文件定义了进程内的实时值表：按(设备ID, 地址)索引，每个采集点占一个槽。
+ * 采集线程写入，界面、告警、MQTT等读者无锁读取：
+ * - 索引是开放寻址哈希表，槽一经分配不再移动，键用原子CAS占用；
+ * - 每个槽用顺序锁（seqlock）保护，写者写前写后各递增一次序号，
+ *   读者读到奇数序号或前后序号不一致时重读。
+ * 读取实时值因此从不访问总线，也不与采集线程争锁。
+ */
+
+#ifndef REALTIMECACHE_H
+#define REALTIMECACHE_H
+
+#include <QtGlobal>
+
+/**
+ * @class RealtimeCache
+ * @brief 实时值缓存类
+ *
+ * 每个槽只应有一个写者（设备所在总线的采集线程），读者数量不限。
+ * 槽在设备删除后不回收，容量按现场点数留有余量。
+ */
+class RealtimeCache
+{
+public:
+    enum Limits {
+        Capacity = 4096     ///< 槽数（2的幂）
+    };
+
+    /**
+     * @struct Value
+     * @brief 一个点的实时值
+     */
+    struct Value {
+        double value;           ///< 工程值
+        qint64 timestampNs;     ///< 采集时间（自1970年起的纳秒数）
+        quint8 flags;           ///< 标志（RegisterSnapshot::Flag的组合）
+    };
+
+    /**
+     * @brief 获取点的槽，不存在时分配（采集任务创建时调用）
+     * @param deviceId 设备ID
+     * @param address 地址
+     * @return 槽下标，表已满时返回-1
+     */
+    static int acquireSlot(int deviceId, int address);
+
+    /**
+     * @brief 查找点的槽
+     * @return 槽下标，不存在时返回-1
+     */
+    static int findSlot(int deviceId, int address);
+
+    /**
+     * @brief 写入实时值（仅该槽的写者调用）
+     */
+    static void store(int slot, double value, qint64 timestampNs, quint8 flags);
+
+    /**
+     * @brief 追加标志，保留上次的值和时间（通信中断、过期时调用，下次store()时清除）
+     */
+    static void addFlags(int slot, quint8 flags);
+
+    /**
+     * @brief 读取槽的实时值
+     * @return false表示槽无效或尚未写入过
+     */
+    static bool read(int slot, Value *value);
+
+    /**
+     * @brief 按(设备ID, 地址)读取实时值
+     * @return false表示该点尚无数据
+     */
+    static bool read(int deviceId, int address, Value *value);
+
+    /**
+     * @brief 已分配的槽数
+     */
+    static int slotCount();
+};
+
+#endif // REALTIMECACHE_H
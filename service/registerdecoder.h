@@ -0,0 +1,153 @@
+/**
+ * @file registerdecoder.h
+ * @brief 寄存器类型解码定义
+ *
+ * 本文件定义了采集点的数据类型、字节序以及按类型特化的解码模板。
+ * 数据类型和字序是模板参数，每种组合编译出一个无分支的紧凑循环；
+ * 运行时只在每个采集点上按配置选择一次模板实例，不对单个寄存器做类型判断。
+ */
+
+#ifndef REGISTERDECODER_H
+#define REGISTERDECODER_H
+
+#include <QtGlobal>
+#include <QString>
+#include <cstring>
+
+/**
+ * @class RegisterDecoder
+ * @brief 寄存器类型解码器
+ *
+ * 纯函数式的静态接口，输入为已按大端拼好的寄存器值（ModbusRtu::decodeReadResponse的输出），
+ * 输出为工程值：原始值 × scale + offset。
+ */
+class RegisterDecoder
+{
+public:
+    /**
+     * @brief 数据类型
+     */
+    enum DataType {
+        Int16,      ///< 有符号16位（1个寄存器）
+        UInt16,     ///< 无符号16位（1个寄存器），位读取的点也按此类型
+        Int32,      ///< 有符号32位（2个寄存器）
+        UInt32,     ///< 无符号32位（2个寄存器）
+        Float32,    ///< IEEE754单精度（2个寄存器）
+        Float64     ///< IEEE754双精度（4个寄存器）
+    };
+
+    /**
+     * @brief 字节序（A为最高字节）
+     */
+    enum ByteOrder {
+        ABCD,       ///< 高字在前，字内高字节在前（Modbus标准）
+        BADC,       ///< 高字在前，字内字节交换
+        CDAB,       ///< 低字在前，字内高字节在前
+        DCBA        ///< 低字在前，字内字节交换
+    };
+
+    /**
+     * @brief 数据类型占用的寄存器数
+     */
+    static int registerWidth(DataType type);
+
+    /**
+     * @brief 是否需要交换字内字节（BADC、DCBA）
+     */
+    static bool swapsBytes(ByteOrder order) { return order == BADC || order == DCBA; }
+
+    /**
+     * @brief 是否低字在前（CDAB、DCBA）
+     */
+    static bool swapsWords(ByteOrder order) { return order == CDAB || order == DCBA; }
+
+    /**
+     * @brief 交换一段寄存器的字内字节（支持NEON时每次处理8个寄存器）
+     * @param src 输入寄存器
+     * @param dst 输出寄存器（可与src相同）
+     * @param count 寄存器数
+     */
+    static void swapBytes(const quint16 *src, quint16 *dst, int count);
+
+    /**
+     * @brief 将连续寄存器解码为工程值
+     * @param type 数据类型
+     * @param order 字节序
+     * @param regs 输入寄存器，valueCount × registerWidth(type)个
+     * @param valueCount 值的个数
+     * @param scale 系数
+     * @param offset 偏移
+     * @param out 输出工程值，valueCount个
+     * @param scratch 字节交换用的临时缓冲区，不少于regs的长度；ABCD、CDAB时不使用
+     */
+    static void decode(DataType type, ByteOrder order, const quint16 *regs, int valueCount,
+                       double scale, double offset, double *out, quint16 *scratch);
+
+    /**
+     * @brief 数据类型名称（int16/uint16/int32/uint32/float32/float64）
+     */
+    static QString typeName(DataType type);
+
+    /**
+     * @brief 字节序名称（ABCD/BADC/CDAB/DCBA）
+     */
+    static QString orderName(ByteOrder order);
+
+    /**
+     * @brief 解析数据类型名称
+     * @return false表示名称无效
+     */
+    static bool parseType(const QString &name, DataType *type);
+
+    /**
+     * @brief 解析字节序名称
+     * @return false表示名称无效
+     */
+    static bool parseOrder(const QString &name, ByteOrder *order);
+};
+
+/**
+ * @struct RegisterTraits
+ * @brief 数据类型的编译期属性：原始C++类型、寄存器数和位宽
+ */
+template <RegisterDecoder::DataType T> struct RegisterTraits;
+
+template <> struct RegisterTraits<RegisterDecoder::Int16>   { typedef qint16 Raw;  typedef quint16 Bits; enum { Width = 1 }; };
+template <> struct RegisterTraits<RegisterDecoder::UInt16>  { typedef quint16 Raw; typedef quint16 Bits; enum { Width = 1 }; };
+template <> struct RegisterTraits<RegisterDecoder::Int32>   { typedef qint32 Raw;  typedef quint32 Bits; enum { Width = 2 }; };
+template <> struct RegisterTraits<RegisterDecoder::UInt32>  { typedef quint32 Raw; typedef quint32 Bits; enum { Width = 2 }; };
+template <> struct RegisterTraits<RegisterDecoder::Float32> { typedef float Raw;   typedef quint32 Bits; enum { Width = 2 }; };
+template <> struct RegisterTraits<RegisterDecoder::Float64> { typedef double Raw;  typedef quint64 Bits; enum { Width = 4 }; };
+
+/**
+ * @brief 按字序把Width个寄存器拼成位模式
+ */
+template <typename Bits, int Width, bool WordSwap>
+inline Bits assembleWords(const quint16 *w)
+{
+    Bits bits = 0;
+    for (int i = 0; i < Width; ++i) {
+        bits = static_cast<Bits>((bits << 16) | w[WordSwap ? Width - 1 - i : i]);
+    }
+    return bits;
+}
+
+/**
+ * @brief 解码一段同类型的寄存器（字内字节已是大端）
+ */
+template <RegisterDecoder::DataType T, bool WordSwap>
+void decodeRegisters(const quint16 *regs, int valueCount, double scale, double offset, double *out)
+{
+    typedef RegisterTraits<T> Traits;
+    typedef typename Traits::Raw Raw;
+    typedef typename Traits::Bits Bits;
+
+    for (int i = 0; i < valueCount; ++i) {
+        Bits bits = assembleWords<Bits, Traits::Width, WordSwap>(regs + i * Traits::Width);
+        Raw raw;
+        std::memcpy(&raw, &bits, sizeof(raw));
+        out[i] = static_cast<double>(raw) * scale + offset;
+    }
+}
+
+#endif // REGISTERDECODER_H
@@ -0,0 +1,193 @@
+/**
+ * @file registersnapshot.h
+ * @brief 寄存器快照定义
+ *
+ * 本文件定义了一次采集结果的紧凑表示：按值平行排列的数组（结构体数组转数组结构体），
+ * 代替每个寄存器一个QVariantMap的列表。快照发布后不再修改，以侵入式引用计数指针在
+ * 采集线程、服务层和界面之间传递，跨线程也只复制一个指针、增减一次计数。
+ * 地址、名称、单位等每轮不变的信息放在采集任务持有的RegisterLayout中，各轮快照共享。
+ */
+
+#ifndef REGISTERSNAPSHOT_H
+#define REGISTERSNAPSHOT_H
+
+#include "formula.h"
+#include "pointbitset.h"
+
+#include <QExplicitlySharedDataPointer>
+#include <QMetaType>
+#include <QSharedData>
+#include <QSharedPointer>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+/**
+ * @struct RegisterLayout
+ * @brief 快照中各值的静态信息（采集任务构造时生成，之后只读）
+ *
+ * 前physicalCount个值来自设备寄存器，其后依次是各派生点，由DerivedStage按formulas计算。
+ */
+struct RegisterLayout {
+    QVector<int> addresses;     ///< 值的起始寄存器/位地址
+    QVector<QString> names;     ///< 名称
+    QVector<QString> units;     ///< 单位
+    QVector<double> scales;     ///< 系数
+    QVector<double> offsets;    ///< 偏移
+    QVector<double> deadbands;  ///< 死区（工程值），0表示任何变化都上报
+    QVector<double> rangeLows;  ///< 量程下限（工程值），-inf表示不检查
+    QVector<double> rangeHighs; ///< 量程上限（工程值），+inf表示不检查
+    QVector<int> cacheSlots;    ///< 实时值缓存槽，未绑定缓存时为空
+    int physicalCount;          ///< 寄存器值的个数
+    QVector<Formula> formulas;  ///< 派生点公式，第k个的结果写入下标physicalCount + k
+
+    RegisterLayout() : physicalCount(0) {}
+};
+
+/**
+ * @struct RegisterSnapshot
+ * @brief 一个设备一次采集的所有值
+ *
+ * values、timestampsNs、各标志位集与layout中的数组按下标一一对应。时间一律以整数纳秒
+ * 传递，只在界面显示时格式化。
+ * 快照在DataPipeline处理完之前由采集线程独占修改，发布后只读。
+ * 引用计数在对象内（QSharedData），采集任务把下游都已释放的快照连同各数组的容量
+ * 原地复用，稳态采集不分配内存。
+ */
+struct RegisterSnapshot : public QSharedData {
+    /**
+     * @brief 值的质量（与数据库quality列一致）
+     */
+    enum Quality {
+        Good = 0,       ///< 正常
+        Bad = 1,        ///< 无效（值非法或通信中断）
+        Uncertain = 2   ///< 不确定（过期或超量程）
+    };
+
+    /**
+     * @brief 单点标志（实时值缓存和上报消息中按字节存放）
+     */
+    enum Flag {
+        FlagBad = 0x01,         ///< 值非法（NaN、Inf等）
+        FlagStale = 0x02,       ///< 过期：设备错过调度截止时间，值未按时刷新
+        FlagOutOfRange = 0x04,  ///< 超出量程
+        FlagCommLost = 0x08     ///< 通信中断，保留的是上次的值
+    };
+
+    int deviceId;                                   ///< 设备ID
+    QSharedPointer<const RegisterLayout> layout;    ///< 地址、名称、单位
+    QVector<double> values;                         ///< 工程值
+    PointBitset bad;                                ///< 值非法
+    PointBitset stale;                              ///< 过期
+    PointBitset outOfRange;                         ///< 超出量程
+    PointBitset commLost;                           ///< 通信中断
+    QVector<qint64> timestampsNs;                   ///< 采集时间（墙上时钟，自1970年起的纳秒数）
+    QVector<int> changed;                           ///< 超出死区、需要下游处理的值下标（升序）
+    qint64 monotonicNs;                             ///< 采集时间（单调时钟纳秒，用于计算间隔）
+
+    RegisterSnapshot() : deviceId(-1), monotonicNs(0) {}
+
+    /**
+     * @brief 值的个数
+     */
+    int size() const { return values.size(); }
+
+    /**
+     * @brief 所有标志位集置为n位全0
+     */
+    void resetFlags(int n)
+    {
+        bad.resize(n);
+        stale.resize(n);
+        outOfRange.resize(n);
+        commLost.resize(n);
+    }
+
+    /**
+     * @brief 是否有任意一个值带标志（按字判断）
+     */
+    bool anyFlags() const { return bad.any() || stale.any() || outOfRange.any() || commLost.any(); }
+
+    /**
+     * @brief 第i个值的标志（Flag的组合）
+     */
+    quint8 flags(int i) const
+    {
+        return (bad.test(i) ? FlagBad : 0) | (stale.test(i) ? FlagStale : 0)
+                | (outOfRange.test(i) ? FlagOutOfRange : 0) | (commLost.test(i) ? FlagCommLost : 0);
+    }
+
+    /**
+     * @brief 由标志得出的质量
+     */
+    static Quality qualityOf(quint8 flags)
+    {
+        if (flags & (FlagBad | FlagCommLost)) {
+            return Bad;
+        }
+        return (flags & (FlagStale | FlagOutOfRange)) ? Uncertain : Good;
+    }
+
+    Quality quality(int i) const { return qualityOf(flags(i)); }
+
+    int address(int i) const { return layout->addresses[i]; }
+    const QString &name(int i) const { return layout->names[i]; }
+    const QString &unit(int i) const { return layout->units[i]; }
+};
+
+typedef QExplicitlySharedDataPointer<const RegisterSnapshot> RegisterSnapshotPtr;
+
+/**
+ * @struct SnapshotBatch
+ * @brief 多个设备的一批采集结果（按设备平行排列，创建后不再修改）
+ *
+ * 一个采集周期内各设备的结果合成一批，一次信号或一次查询交付给界面，
+ * 代替每个设备一次信号和一次按设备查询。
+ */
+struct SnapshotBatch {
+    QVector<int> deviceIds;                 ///< 设备ID
+    QVector<RegisterSnapshotPtr> snapshots; ///< 采集快照，采集失败时为空
+    QVector<int> errorCodes;                ///< 错误码，0表示成功
+    QVector<QString> errorMessages;         ///< 错误信息，成功时为空
+
+    /**
+     * @brief 设备个数
+     */
+    int size() const { return deviceIds.size(); }
+
+    /**
+     * @brief 预留n个设备的空间
+     */
+    void reserve(int n)
+    {
+        deviceIds.reserve(n);
+        snapshots.reserve(n);
+        errorCodes.reserve(n);
+        errorMessages.reserve(n);
+    }
+
+    /**
+     * @brief 追加一个设备的结果
+     */
+    void append(int deviceId, const RegisterSnapshotPtr &snapshot, int errorCode = 0,
+                const QString &errorMessage = QString())
+    {
+        deviceIds.append(deviceId);
+        snapshots.append(snapshot);
+        errorCodes.append(errorCode);
+        errorMessages.append(errorMessage);
+    }
+
+    /**
+     * @brief 设备在批中的下标
+     * @return 下标，不在批中时返回-1
+     */
+    int indexOf(int deviceId) const { return deviceIds.indexOf(deviceId); }
+};
+
+typedef QSharedPointer<const SnapshotBatch> SnapshotBatchPtr;
+
+Q_DECLARE_METATYPE(RegisterSnapshotPtr)
+Q_DECLARE_METATYPE(SnapshotBatchPtr)
+
+#endif // REGISTERSNAPSHOT_H
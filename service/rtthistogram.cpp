@@ -0,0 +1,78 @@
+/**
+ * @file rtthistogram.cpp
+ * @brief 往返时间直方图实现
+ */
+
+#include "rtthistogram.h"
+
+#include <cstring>
+
+RttHistogram::RttHistogram()
+{
+    reset();
+}
+
+void RttHistogram::reset()
+{
+    std::memset(m_buckets, 0, sizeof(m_buckets));
+    m_count = 0;
+}
+
+int RttHistogram::bucketOf(qint64 rttUs)
+{
+    if (rttUs < LinearBuckets) {
+        return rttUs > 0 ? static_cast<int>(rttUs) : 0;
+    }
+    if (rttUs >= (qint64(1) << MaxExponent)) {
+        return BucketCount - 1;
+    }
+
+    quint32 v = static_cast<quint32>(rttUs);
+    int exponent = 31 - __builtin_clz(v);                       // 4..MaxExponent-1
+    int sub = static_cast<int>((v >> (exponent - 3)) & (SubBuckets - 1));
+    return LinearBuckets + (exponent - 4) * SubBuckets + sub;
+}
+
+qint64 RttHistogram::upperBoundOf(int bucket)
+{
+    if (bucket < LinearBuckets) {
+        return bucket;
+    }
+    int exponent = (bucket - LinearBuckets) / SubBuckets + 4;
+    int sub = (bucket - LinearBuckets) % SubBuckets;
+    qint64 width = qint64(1) << (exponent - 3);
+    return (SubBuckets + sub) * width + width - 1;
+}
+
+void RttHistogram::record(qint64 rttUs)
+{
+    if (m_count >= DecayThreshold) {
+        m_count = 0;
+        for (int i = 0; i < BucketCount; ++i) {
+            m_buckets[i] >>= 1;
+            m_count += m_buckets[i];
+        }
+    }
+    m_buckets[bucketOf(rttUs)]++;
+    m_count++;
+}
+
+qint64 RttHistogram::percentileUs(double fraction) const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+
+    // 第rank个样本（从1计）所在的桶
+    quint32 rank = static_cast<quint32>(fraction * m_count + 0.5);
+    rank = qBound<quint32>(1, rank, m_count);
+
+    quint32 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += m_buckets[i];
+        if (seen >= rank) {
+            return upperBoundOf(i);
+        }
+    }
+    return upperBoundOf(BucketCount - 1);
+}
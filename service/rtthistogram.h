@@ -0,0 +1,65 @@
+/**
+ * @file rtthistogram.h
+ * @brief 往返时间直方图定义
+ *
+ * 本文件定义了RttHistogram：以对数分桶统计Modbus请求的往返时间（微秒），
+ * 每个2的幂区间再细分8个桶，相对误差约12%。样本数达到上限后所有桶减半，
+ * 使分位数跟随设备近期的表现变化。
+ */
+
+#ifndef RTTHISTOGRAM_H
+#define RTTHISTOGRAM_H
+
+#include <QtGlobal>
+
+/**
+ * @class RttHistogram
+ * @brief 往返时间直方图类
+ *
+ * 固定大小、不分配内存，记录一次为O(1)，求分位数为O(桶数)。
+ */
+class RttHistogram
+{
+public:
+    enum Limits {
+        LinearBuckets = 16,         ///< 0-15微秒每微秒一个桶
+        SubBuckets = 8,             ///< 每个2的幂区间的细分桶数
+        MaxExponent = 24,           ///< 上限2^24微秒（约16.7秒）
+        BucketCount = LinearBuckets + (MaxExponent - 4) * SubBuckets,
+        DecayThreshold = 2048       ///< 样本数达到此值时所有桶减半
+    };
+
+    RttHistogram();
+
+    /**
+     * @brief 记录一次往返时间
+     * @param rttUs 往返时间（微秒），超出上限时计入最后一个桶
+     */
+    void record(qint64 rttUs);
+
+    /**
+     * @brief 求分位数
+     * @param fraction 分位（0.0-1.0，如0.99）
+     * @return 该分位所在桶的上界（微秒），没有样本时返回0
+     */
+    qint64 percentileUs(double fraction) const;
+
+    /**
+     * @brief 当前（衰减后的）样本数
+     */
+    quint32 count() const { return m_count; }
+
+    /**
+     * @brief 清空
+     */
+    void reset();
+
+private:
+    static int bucketOf(qint64 rttUs);
+    static qint64 upperBoundOf(int bucket);
+
+    quint32 m_buckets[BucketCount];     ///< 各桶计数
+    quint32 m_count;                    ///< 样本总数
+};
+
+#endif // RTTHISTOGRAM_H
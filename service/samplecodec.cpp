@@ -0,0 +1,239 @@
+/**
+ * @file samplecodec.cpp
+ * @brief 历史样本块压缩编码实现
+ *
+ * 位流按高位在前写入字节。每个样本（第一个除外）依次为：
+ * - 时间戳二阶差分d：0写“0”；-2^13≤d<2^13写“10”+14位；-2^19≤d<2^19写“110”+20位；
+ *   -2^31≤d<2^31写“1110”+32位；其余写“1111”+64位（均为补码）；
+ * - 值异或x：0写“0”；有效位落在上次窗口内写“10”+窗口内的位；
+ *   否则写“11”+5位前导零数+6位（有效位数-1）+有效位；
+ * - 标志：相同写“0”，否则写“1”+8位。
+ */
+
+#include "samplecodec.h"
+
+#include <QtAlgorithms>
+#include <cstring>
+
+namespace {
+
+const int FirstSampleBits = 64 + 64 + 8;
+const int MaxSampleBits = (4 + 64) + (2 + 5 + 6 + 64) + (1 + 8);
+
+/**
+ * @brief 位写入器
+ */
+struct BitWriter {
+    quint8 *p;          ///< 下一个待写字节
+    quint64 acc;        ///< 尚未写出的位（低bits位有效）
+    int bits;           ///< acc中的位数，写完一次后小于8
+
+    explicit BitWriter(char *out)
+        : p(reinterpret_cast<quint8 *>(out)), acc(0), bits(0) {}
+
+    void write(quint64 value, int n)
+    {
+        if (n > 32) {
+            write(value >> 32, n - 32);
+            n = 32;
+        }
+        acc = (acc << n) | (value & ((Q_UINT64_C(1) << n) - 1));
+        bits += n;
+        while (bits >= 8) {
+            bits -= 8;
+            *p++ = static_cast<quint8>(acc >> bits);
+        }
+    }
+
+    void finish()
+    {
+        if (bits > 0) {
+            *p++ = static_cast<quint8>(acc << (8 - bits));
+            bits = 0;
+        }
+    }
+};
+
+/**
+ * @brief 位读取器，读过数据末尾时补0并置overrun
+ */
+struct BitReader {
+    const quint8 *p;    ///< 下一个待读字节
+    const quint8 *end;  ///< 数据末尾
+    quint64 acc;        ///< 已读入的位（低bits位有效）
+    int bits;           ///< acc中尚未取出的位数
+    bool overrun;       ///< 是否读过了数据末尾
+
+    BitReader(const char *data, int bytes)
+        : p(reinterpret_cast<const quint8 *>(data)), end(p + bytes), acc(0), bits(0), overrun(false) {}
+
+    quint64 read(int n)
+    {
+        if (n > 32) {
+            quint64 high = read(n - 32);
+            return (high << 32) | read(32);
+        }
+        while (bits < n) {
+            if (p < end) {
+                acc = (acc << 8) | *p++;
+            } else {
+                acc <<= 8;
+                overrun = true;
+            }
+            bits += 8;
+        }
+        bits -= n;
+        return (acc >> bits) & ((Q_UINT64_C(1) << n) - 1);
+    }
+
+    /**
+     * @brief 读取最多max个连续的1，遇到0停止
+     * @return 1的个数
+     */
+    int readOnes(int max)
+    {
+        int n = 0;
+        while (n < max && read(1)) {
+            n++;
+        }
+        return n;
+    }
+};
+
+inline quint64 bitsOf(double value)
+{
+    quint64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline double valueOf(quint64 bits)
+{
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+inline qint64 signExtend(quint64 value, int n)
+{
+    quint64 sign = Q_UINT64_C(1) << (n - 1);
+    return static_cast<qint64>((value ^ sign) - sign);
+}
+
+// 二阶差分的编码宽度，与前缀中1的个数一一对应
+const int DodWidths[] = { 0, 14, 20, 32, 64 };
+
+} // namespace
+
+int SampleCodec::maxEncodedBytes(int count)
+{
+    return (FirstSampleBits + (count - 1) * MaxSampleBits + 7) / 8;
+}
+
+int SampleCodec::encode(const TimeSeriesStore::Sample *samples, int count, char *out)
+{
+    BitWriter w(out);
+    w.write(static_cast<quint64>(samples[0].timestampNs), 64);
+    w.write(bitsOf(samples[0].value), 64);
+    w.write(samples[0].flags, 8);
+
+    qint64 prevDelta = 0;
+    quint64 prevBits = bitsOf(samples[0].value);
+    int prevLeading = -1;       // -1表示还没有窗口
+    int prevTrailing = 0;
+    for (int i = 1; i < count; ++i) {
+        const TimeSeriesStore::Sample &s = samples[i];
+
+        qint64 delta = s.timestampNs - samples[i - 1].timestampNs;
+        qint64 dod = delta - prevDelta;
+        prevDelta = delta;
+        if (dod == 0) {
+            w.write(0, 1);
+        } else {
+            int ones = 1;
+            while (ones < 4 && (dod < -(Q_INT64_C(1) << (DodWidths[ones] - 1))
+                                || dod >= (Q_INT64_C(1) << (DodWidths[ones] - 1)))) {
+                ones++;
+            }
+            if (ones < 4) {
+                w.write(((Q_UINT64_C(1) << ones) - 1) << 1, ones + 1);
+            } else {
+                w.write(0xF, 4);
+            }
+            w.write(static_cast<quint64>(dod), DodWidths[ones]);
+        }
+
+        quint64 bits = bitsOf(s.value);
+        quint64 x = bits ^ prevBits;
+        prevBits = bits;
+        if (x == 0) {
+            w.write(0, 1);
+        } else {
+            int leading = qMin(31, static_cast<int>(qCountLeadingZeroBits(x)));
+            int trailing = static_cast<int>(qCountTrailingZeroBits(x));
+            if (prevLeading >= 0 && leading >= prevLeading && trailing >= prevTrailing) {
+                w.write(2, 2);
+                w.write(x >> prevTrailing, 64 - prevLeading - prevTrailing);
+            } else {
+                int meaningful = 64 - leading - trailing;
+                w.write(3, 2);
+                w.write(static_cast<quint64>(leading), 5);
+                w.write(static_cast<quint64>(meaningful - 1), 6);
+                w.write(x >> trailing, meaningful);
+                prevLeading = leading;
+                prevTrailing = trailing;
+            }
+        }
+
+        if (s.flags == samples[i - 1].flags) {
+            w.write(0, 1);
+        } else {
+            w.write(1, 1);
+            w.write(s.flags, 8);
+        }
+    }
+    w.finish();
+    return static_cast<int>(reinterpret_cast<char *>(w.p) - out);
+}
+
+bool SampleCodec::decode(const char *data, int bytes, int count, TimeSeriesStore::Sample *samples)
+{
+    if (count <= 0 || bytes > maxEncodedBytes(count)) {
+        return false;
+    }
+    BitReader r(data, bytes);
+    qint64 timestampNs = static_cast<qint64>(r.read(64));
+    quint64 bits = r.read(64);
+    quint8 flags = static_cast<quint8>(r.read(8));
+    samples[0] = { timestampNs, valueOf(bits), flags };
+
+    qint64 delta = 0;
+    int leading = -1;
+    int trailing = 0;
+    for (int i = 1; i < count; ++i) {
+        int ones = r.readOnes(4);
+        if (ones > 0) {
+            delta += signExtend(r.read(DodWidths[ones]), DodWidths[ones]);
+        }
+        timestampNs += delta;
+
+        if (r.read(1)) {
+            if (r.read(1)) {
+                leading = static_cast<int>(r.read(5));
+                trailing = 64 - leading - static_cast<int>(r.read(6)) - 1;
+                if (trailing < 0) {
+                    return false;
+                }
+            } else if (leading < 0) {
+                return false;
+            }
+            bits ^= r.read(64 - leading - trailing) << trailing;
+        }
+
+        if (r.read(1)) {
+            flags = static_cast<quint8>(r.read(8));
+        }
+        samples[i] = { timestampNs, valueOf(bits), flags };
+    }
+    return !r.overrun;
+}
@@ -0,0 +1,54 @@
+/**
+ * @file samplecodec.h
+ * @brief 历史样本块压缩编码定义
+ *
+ * 本文件定义了历史样本块的压缩格式（参照Gorilla）：
+ * - 时间戳写二阶差分（本次间隔与上次间隔之差），按轮询周期采集的点大多只占1位，
+ *   抖动在微秒级时占23位；
+ * - 值写与上一个值按位异或的结果，值不变时只占1位，变化时只写异或结果中
+ *   去掉前导零和尾随零的有效位，有效位窗口与上次相同时不重复写窗口；
+ * - 标志与上一个相同时只占1位。
+ * 第一个样本的时间戳、值和标志原样写入。编码无损。
+ */
+
+#ifndef SAMPLECODEC_H
+#define SAMPLECODEC_H
+
+#include "timeseriesstore.h"
+
+/**
+ * @class SampleCodec
+ * @brief 历史样本块编解码器
+ *
+ * 纯函数式的静态接口，不持有任何状态，可在任意线程中调用。
+ * 编解码都在调用者提供的缓冲区内完成。
+ */
+class SampleCodec
+{
+public:
+    /**
+     * @brief count个样本编码后的最大字节数
+     */
+    static int maxEncodedBytes(int count);
+
+    /**
+     * @brief 编码一块样本
+     * @param samples 样本，按时间升序
+     * @param count 样本数，大于0
+     * @param out 输出缓冲区，至少maxEncodedBytes(count)字节
+     * @return 编码后的字节数
+     */
+    static int encode(const TimeSeriesStore::Sample *samples, int count, char *out);
+
+    /**
+     * @brief 解码一块样本
+     * @param data 编码数据
+     * @param bytes 编码数据的字节数
+     * @param count 样本数（块头中记录）
+     * @param samples 输出缓冲区，至少count个元素
+     * @return false表示数据不完整或已损坏
+     */
+    static bool decode(const char *data, int bytes, int count, TimeSeriesStore::Sample *samples);
+};
+
+#endif // SAMPLECODEC_H
@@ -0,0 +1,304 @@
+/**
+ * @file serialtransport.cpp
+ * @brief RS485串口传输实现
+ *
+ * 本文件实现了非阻塞termios串口的打开、配置和Modbus RTU事务收发。
+ * 接收时：收满预期长度立即返回；收到异常响应（5字节）立即返回；
+ * 已收到部分字节后出现t3.5静默视为帧结束；首字节前才使用响应超时。
+ */
+
+#include "serialtransport.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+// 规范规定：波特率高于19200时t3.5固定为1750us
+static const int FIXED_T35_US = 1750;
+
+/**
+ * @brief 获取单调时钟（纳秒）
+ */
+static qint64 monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * @brief 波特率转换为termios速度常量
+ * @return 不支持时返回0
+ */
+static speed_t baudToSpeed(int baudRate)
+{
+    switch (baudRate) {
+    case 1200:   return B1200;
+    case 2400:   return B2400;
+    case 4800:   return B4800;
+    case 9600:   return B9600;
+    case 19200:  return B19200;
+    case 38400:  return B38400;
+    case 57600:  return B57600;
+    case 115200: return B115200;
+    default:     return 0;
+    }
+}
+
+SerialTransport::SerialTransport()
+    : m_fd(-1)
+    , m_charTimeUs(0)
+    , m_t35Us(FIXED_T35_US)
+    , m_lastActivityNs(0)
+    , m_reopenable(false)
+    , m_nextReopenNs(0)
+{
+}
+
+SerialTransport::~SerialTransport()
+{
+    close();
+}
+
+void SerialTransport::frameTiming(const SerialConfig &cfg, int *charTimeUs, int *t35Us)
+{
+    // 起始位 + 数据位 + 校验位 + 停止位
+    int bits = 1 + cfg.dataBits + (cfg.parity != 0 ? 1 : 0) + cfg.stopBits;
+    int baud = cfg.baudRate > 0 ? cfg.baudRate : 9600;
+    int charUs = (bits * 1000000 + baud - 1) / baud;
+
+    if (charTimeUs) {
+        *charTimeUs = charUs;
+    }
+    if (t35Us) {
+        *t35Us = (baud > 19200) ? FIXED_T35_US : qMax(FIXED_T35_US, (charUs * 7 + 1) / 2);
+    }
+}
+
+Result SerialTransport::open(const SerialConfig &cfg)
+{
+    close();
+
+    // 打开失败（如USB转RS485尚未插入）时之后的事务也按间隔重试
+    m_config = cfg;
+    m_reopenable = true;
+
+    speed_t speed = baudToSpeed(cfg.baudRate);
+    if (speed == 0) {
+        return Result::error(1, QString("不支持的波特率：%1").arg(cfg.baudRate));
+    }
+
+    QByteArray path = cfg.port.toLocal8Bit();
+    int fd = ::open(path.constData(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) {
+        return Result::error(2, QString("无法打开串口 %1：%2").arg(cfg.port).arg(strerror(errno)));
+    }
+
+    struct termios tio;
+    if (tcgetattr(fd, &tio) != 0) {
+        ::close(fd);
+        return Result::error(3, QString("串口 %1 不是终端设备").arg(cfg.port));
+    }
+
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+
+    tio.c_cflag &= ~CSIZE;
+    switch (cfg.dataBits) {
+    case 5:  tio.c_cflag |= CS5; break;
+    case 6:  tio.c_cflag |= CS6; break;
+    case 7:  tio.c_cflag |= CS7; break;
+    default: tio.c_cflag |= CS8; break;
+    }
+
+    tio.c_cflag &= ~(PARENB | PARODD);
+    if (cfg.parity == 1) {
+        tio.c_cflag |= PARENB;
+    } else if (cfg.parity == 2) {
+        tio.c_cflag |= PARENB | PARODD;
+    }
+
+    if (cfg.stopBits == 2) {
+        tio.c_cflag |= CSTOPB;
+    } else {
+        tio.c_cflag &= ~CSTOPB;
+    }
+
+    // 非阻塞读：由ppoll负责等待
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+
+    if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+        ::close(fd);
+        return Result::error(3, QString("配置串口 %1 失败：%2").arg(cfg.port).arg(strerror(errno)));
+    }
+    tcflush(fd, TCIOFLUSH);
+
+    m_fd = fd;
+    frameTiming(cfg, &m_charTimeUs, &m_t35Us);
+    m_lastActivityNs = monotonicNs();
+    return Result::success();
+}
+
+void SerialTransport::close()
+{
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool SerialTransport::isOpen() const
+{
+    return m_fd >= 0;
+}
+
+int SerialTransport::waitReadable(qint64 timeoutUs)
+{
+    qint64 deadlineNs = monotonicNs() + timeoutUs * 1000;
+
+    for (;;) {
+        qint64 remainNs = deadlineNs - monotonicNs();
+        if (remainNs <= 0) {
+            return 0;
+        }
+
+        struct pollfd pfd;
+        pfd.fd = m_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        struct timespec ts;
+        ts.tv_sec = remainNs / 1000000000LL;
+        ts.tv_nsec = remainNs % 1000000000LL;
+
+        int rc = ppoll(&pfd, 1, &ts, nullptr);
+        if (rc > 0) {
+            if (pfd.revents & POLLIN) {
+                return 1;
+            }
+            // 没有数据却有事件：设备出错或已断开，再poll也会立即返回
+            return (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) ? -1 : 0;
+        }
+        if (rc == 0) {
+            return 0;
+        }
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+}
+
+void SerialTransport::waitInterFrameGap()
+{
+    // 两帧之间至少保持t3.5静默
+    qint64 remainNs = m_lastActivityNs + static_cast<qint64>(m_t35Us) * 1000 - monotonicNs();
+    if (remainNs > 0) {
+        struct timespec ts;
+        ts.tv_sec = 0;
+        ts.tv_nsec = remainNs;
+        while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+        }
+    }
+}
+
+ModbusRtu::Status SerialTransport::transact(const ModbusFrame &request, ModbusFrame &response,
+                                            int expectedLength, int timeoutMs)
+{
+    response.length = 0;
+    if (m_fd < 0) {
+        qint64 now = monotonicNs();
+        if (!m_reopenable || now < m_nextReopenNs) {
+            return ModbusRtu::ErrIo;
+        }
+        m_nextReopenNs = now + ReopenIntervalMs * 1000000LL;
+        if (!open(m_config).isSuccess()) {
+            return ModbusRtu::ErrIo;
+        }
+    }
+
+    waitInterFrameGap();
+
+    // 丢弃上一事务残留的字节，避免错位
+    tcflush(m_fd, TCIFLUSH);
+
+    int written = 0;
+    while (written < request.length) {
+        ssize_t n = ::write(m_fd, request.data + written, request.length - written);
+        if (n > 0) {
+            written += static_cast<int>(n);
+            continue;
+        }
+        if (n < 0 && errno != EAGAIN && errno != EINTR) {
+            return ModbusRtu::ErrIo;
+        }
+        struct pollfd pfd;
+        pfd.fd = m_fd;
+        pfd.events = POLLOUT;
+        pfd.revents = 0;
+        if (::poll(&pfd, 1, timeoutMs) <= 0) {
+            return ModbusRtu::ErrIo;
+        }
+    }
+
+    // 等待请求真正发送到线路上，再开始计算响应超时
+    tcdrain(m_fd);
+
+    qint64 deadlineNs = monotonicNs() + static_cast<qint64>(timeoutMs) * 1000000LL;
+    int capacity = qMin(static_cast<int>(ModbusFrame::Capacity),
+                        expectedLength > 0 ? expectedLength : static_cast<int>(ModbusFrame::Capacity));
+
+    for (;;) {
+        qint64 waitUs;
+        if (response.length == 0) {
+            waitUs = (deadlineNs - monotonicNs()) / 1000;
+            if (waitUs <= 0) {
+                m_lastActivityNs = monotonicNs();
+                return ModbusRtu::ErrTimeout;
+            }
+        } else {
+            waitUs = m_t35Us;
+        }
+
+        int readable = waitReadable(waitUs);
+        if (readable < 0) {
+            close();
+            return ModbusRtu::ErrIo;
+        }
+        if (readable == 0) {
+            if (response.length == 0) {
+                continue;   // 回到循环顶部判断是否已超时
+            }
+            break;          // 已收到部分字节后出现t3.5静默：帧结束
+        }
+
+        ssize_t n = ::read(m_fd, response.data + response.length, capacity - response.length);
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+            continue;
+        }
+        if (n <= 0) {
+            // 可读却读到0字节表示设备已断开，关闭后由下一次事务重新打开
+            close();
+            return ModbusRtu::ErrIo;
+        }
+        response.length += static_cast<int>(n);
+
+        // 收满预期长度或收到完整异常帧时无需再等t3.5
+        if (response.length >= capacity) {
+            break;
+        }
+        if (response.length == ModbusRtu::ExceptionFrameLength && (response.data[1] & 0x80)) {
+            break;
+        }
+    }
+
+    m_lastActivityNs = monotonicNs();
+    return ModbusRtu::Ok;
+}
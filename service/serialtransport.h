@@ -0,0 +1,85 @@
+/**
+ * @file serialtransport.h
+ * @brief RS485串口传输定义
+ *
+ * 本文件定义了基于termios的非阻塞串口传输。响应帧结束的判定依据
+ * 预期响应长度和Modbus RTU规定的t3.5帧间静默，而不是固定延时或整段超时。
+ */
+
+#ifndef SERIALTRANSPORT_H
+#define SERIALTRANSPORT_H
+
+#include "modbustransport.h"
+#include "systemservice.h"
+
+/**
+ * @class SerialTransport
+ * @brief RS485串口传输类
+ *
+ * 以O_NONBLOCK方式打开tty，使用ppoll等待可读，微秒级计算帧间隔。
+ * 设备出错或断开（如USB转RS485被拔出）时关闭串口并返回ErrIo；串口未打开时
+ * （包括一开始就打开失败）事务返回ErrIo，并每隔ReopenIntervalMs按上次open的配置重新打开一次。
+ * 一个实例只应由一个线程使用。
+ */
+class SerialTransport : public ModbusTransport
+{
+public:
+    enum { ReopenIntervalMs = 1000 };   ///< 断开后两次重新打开的最小间隔
+
+    SerialTransport();
+    ~SerialTransport() override;
+
+    /**
+     * @brief 按串口配置打开串口
+     * @param cfg 串口配置（设备文件、波特率、数据位、校验位、停止位）
+     * @return Result 打开结果
+     */
+    Result open(const SerialConfig &cfg);
+
+    /**
+     * @brief 关闭串口
+     */
+    void close();
+
+    bool isOpen() const override;
+    ModbusRtu::Status transact(const ModbusFrame &request, ModbusFrame &response,
+                               int expectedLength, int timeoutMs) override;
+
+    /**
+     * @brief 获取当前配置下一个字符的传输时间
+     * @return 字符时间（微秒）
+     */
+    int charTimeUs() const { return m_charTimeUs; }
+
+    /**
+     * @brief 获取当前配置下的t3.5帧间静默时间
+     * @return t3.5（微秒）
+     */
+    int t35Us() const { return m_t35Us; }
+
+    /**
+     * @brief 计算指定串口参数下的字符时间和t3.5
+     * @param cfg 串口配置
+     * @param charTimeUs 输出字符时间（微秒）
+     * @param t35Us 输出t3.5（微秒），波特率高于19200时按规范固定为1750us
+     */
+    static void frameTiming(const SerialConfig &cfg, int *charTimeUs, int *t35Us);
+
+private:
+    /**
+     * @brief 等待串口可读
+     * @return 1表示可读，0表示超时，-1表示设备出错或已断开（如USB转RS485被拔出）
+     */
+    int waitReadable(qint64 timeoutUs);
+    void waitInterFrameGap();
+
+    int m_fd;               ///< 串口文件描述符
+    int m_charTimeUs;       ///< 字符时间（微秒）
+    int m_t35Us;            ///< t3.5帧间静默（微秒）
+    qint64 m_lastActivityNs;///< 上一次总线活动的单调时间（纳秒）
+    SerialConfig m_config;  ///< 上次打开时的配置
+    bool m_reopenable;      ///< 是否调用过open（关闭后事务可按该配置重新打开）
+    qint64 m_nextReopenNs;  ///< 下次允许重新打开的单调时间（纳秒）
+};
+
+#endif // SERIALTRANSPORT_H
@@ -0,0 +1,67 @@
+# 服务层源文件，主程序和tests下的测试、基准程序共用（不依赖界面）
+SOURCES += $$PWD/acquisitionservice.cpp \
+           $$PWD/alarmservice.cpp \
+           $$PWD/alloccounter.cpp \
+           $$PWD/busscanner.cpp \
+           $$PWD/busworker.cpp \
+           $$PWD/commandqueue.cpp \
+           $$PWD/databaseservice.cpp \
+           $$PWD/datapipeline.cpp \
+           $$PWD/deviceservice.cpp \
+           $$PWD/eventbus.cpp \
+           $$PWD/formula.cpp \
+           $$PWD/linkhealth.cpp \
+           $$PWD/modbusrtu.cpp \
+           $$PWD/modbusservice.cpp \
+           $$PWD/modbussimulator.cpp \
+           $$PWD/modbustransport.cpp \
+           $$PWD/mqttservice.cpp \
+           $$PWD/networkservice.cpp \
+           $$PWD/pollingscheduler.cpp \
+           $$PWD/pollingtask.cpp \
+           $$PWD/readplanner.cpp \
+           $$PWD/realtimecache.cpp \
+           $$PWD/registerdecoder.cpp \
+           $$PWD/rtthistogram.cpp \
+           $$PWD/samplecodec.cpp \
+           $$PWD/serialtransport.cpp \
+           $$PWD/systemservice.cpp \
+           $$PWD/tcptransport.cpp \
+           $$PWD/timeseriesstore.cpp \
+           $$PWD/writeplanner.cpp
+
+HEADERS += $$PWD/acquisitionservice.h \
+           $$PWD/alarmservice.h \
+           $$PWD/alloccounter.h \
+           $$PWD/busscanner.h \
+           $$PWD/busworker.h \
+           $$PWD/commandqueue.h \
+           $$PWD/databaseservice.h \
+           $$PWD/datapipeline.h \
+           $$PWD/deviceservice.h \
+           $$PWD/eventbus.h \
+           $$PWD/formula.h \
+           $$PWD/linkhealth.h \
+           $$PWD/modbusrtu.h \
+           $$PWD/modbusservice.h \
+           $$PWD/modbussimulator.h \
+           $$PWD/modbustransport.h \
+           $$PWD/mqttservice.h \
+           $$PWD/networkservice.h \
+           $$PWD/pointbitset.h \
+           $$PWD/pollingscheduler.h \
+           $$PWD/pollingtask.h \
+           $$PWD/readplanner.h \
+           $$PWD/realtimecache.h \
+           $$PWD/registerdecoder.h \
+           $$PWD/registersnapshot.h \
+           $$PWD/rtthistogram.h \
+           $$PWD/samplecodec.h \
+           $$PWD/serialtransport.h \
+           $$PWD/systemservice.h \
+           $$PWD/tcptransport.h \
+           $$PWD/timeseriesstore.h \
+           $$PWD/writeplanner.h
+
+# 调试：qmake CONFIG+=alloc_counter 按线程统计堆分配次数，检查采集线程稳态是否分配
+alloc_counter: DEFINES += ALLOC_COUNTER
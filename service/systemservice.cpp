@@ -3,13 +3,20 @@
  * @brief 系统服务实现
  *
  * 本文件实现了系统级别服务的所有功能，包括获取系统信息、通信状态、
- * 串口配置、日志管理等。当前为模拟数据，实际部署时需替换为真实系统调用。
+ * 串口配置、数据保留期、日志管理等。当前为模拟数据，实际部署时需替换为真实系统调用。
  */
 
 #include "systemservice.h"
-#include <QDateTime>
+#include "databaseservice.h"
+#include "eventbus.h"
+#include "modbusservice.h"
+#include "pollingscheduler.h"
+#include "timeseriesstore.h"
 #include <QRandomGenerator>
 
+// 当前串口配置
+static SerialConfig s_serialConfig;
+
 Result SystemService::getSystemInfo()
 {
     // 模拟数据 - 实际部署时替换为真实系统调用
@@ -18,6 +25,8 @@ Result SystemService::getSystemInfo()
     info["mem"] = QRandomGenerator::global()->bounded(30, 70);
     info["uptime"] = "3天 12小时 45分钟";
     info["version"] = "1.0.0";
+    info["history"] = TimeSeriesStore::stats().data;
+    info["database"] = DatabaseService::stats().data;
 
     return Result::success(info);
 }
@@ -28,38 +37,92 @@ Result SystemService::getCommStatus()
     QVariantMap status;
     status["network"] = true;
     status["rs485"] = true;
-    status["commRate"] = QRandomGenerator::global()->bounded(85, 100);
-    status["lastUpdate"] = QDateTime::currentDateTime().toString("hh:mm:ss");
+    status["commRate"] = EventBus::instance()->counters().commRate;     // -1表示尚无采集设备
+    status["lastUpdateNs"] = PollingScheduler::wallClockNs();
 
     return Result::success(status);
 }
 
 Result SystemService::getSerialConfig()
 {
-    // 模拟数据 - 实际部署时替换为真实配置
     QVariantMap config;
-    config["port"] = "COM1";
-    config["baudRate"] = 9600;
-    config["dataBits"] = 8;
-    config["parity"] = 0;
-    config["stopBits"] = 1;
+    config["port"] = s_serialConfig.port;
+    config["baudRate"] = s_serialConfig.baudRate;
+    config["dataBits"] = s_serialConfig.dataBits;
+    config["parity"] = s_serialConfig.parity;
+    config["stopBits"] = s_serialConfig.stopBits;
 
     return Result::success(config);
 }
 
 Result SystemService::setSerialConfig(const SerialConfig &cfg)
 {
-    Q_UNUSED(cfg)
-    // TODO: 实现实际的串口配置保存
+    if (cfg.port.trimmed().isEmpty()) {
+        return Result::error(1, "串口名称不能为空");
+    }
+    if (cfg.dataBits < 5 || cfg.dataBits > 8) {
+        return Result::error(2, "数据位必须在5-8之间");
+    }
+    if (cfg.parity < 0 || cfg.parity > 2) {
+        return Result::error(3, "无效的校验位");
+    }
+    if (cfg.stopBits != 1 && cfg.stopBits != 2) {
+        return Result::error(4, "停止位必须为1或2");
+    }
+
+    s_serialConfig = cfg;
+    // TODO: 持久化串口配置
     return Result::success();
 }
 
-Result SystemService::restartCommService()
+SerialConfig SystemService::currentSerialConfig()
+{
+    return s_serialConfig;
+}
+
+SerialConfig SystemService::serialConfigFor(const QString &port)
+{
+    SerialConfig cfg = s_serialConfig;
+    if (!port.isEmpty()) {
+        cfg.port = port;
+    }
+    return cfg;
+}
+
+Result SystemService::getRetentionDays()
+{
+    return Result::success(TimeSeriesStore::retentionDays());
+}
+
+Result SystemService::setRetentionDays(int days)
 {
-    // TODO: 实现实际的服务重启
+    if (days < 1 || days > 3650) {
+        return Result::error(1, "保留天数必须在1-3650之间");
+    }
+
+    TimeSeriesStore::setRetentionDays(days);
+    DatabaseService::setRetentionDays(days);
+    DatabaseService::writeConfig("retention_days", QString::number(days));
     return Result::success();
 }
 
+void SystemService::loadRetention()
+{
+    Result saved = DatabaseService::readConfig("retention_days");
+    int days = saved.isSuccess() ? saved.data.toString().toInt() : 0;
+    if (days < 1 || days > 3650) {
+        days = TimeSeriesStore::DefaultRetentionDays;
+    }
+    TimeSeriesStore::setRetentionDays(days);
+    DatabaseService::setRetentionDays(days);
+}
+
+Result SystemService::restartCommService()
+{
+    // 按当前串口配置重新打开传输层
+    return ModbusService::resetTransport();
+}
+
 Result SystemService::getSystemLog()
 {
     // 模拟日志数据
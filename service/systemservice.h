@@ -3,7 +3,7 @@
  * @brief 系统服务定义
  *
  * 本文件定义了系统级别的服务接口，包括获取系统信息、通信状态、
- * 串口配置、日志管理等功能。
+ * 串口配置、数据保留期、日志管理等功能。
  */
 
 #ifndef SYSTEMSERVICE_H
@@ -16,7 +16,7 @@
  * @brief 串口配置结构体
  */
 struct SerialConfig {
-    QString port;       ///< 串口名称（如COM1、/dev/ttyS1）
+    QString port;       ///< 串口名称（如COM1、/dev/ttyS1），sim:// 表示使用模拟从站
     int baudRate;       ///< 波特率
     int dataBits;       ///< 数据位
     int parity;         ///< 校验位：0=无校验，1=偶校验，2=奇校验
@@ -37,13 +37,13 @@ class SystemService
 public:
     /**
      * @brief 获取系统信息
-     * @return Result 包含CPU使用率、内存使用率、运行时间、版本号等信息
+     * @return Result 包含CPU使用率、内存使用率、运行时间、版本号、历史存储统计（history）以及数据库写入统计（database）等信息
      */
     static Result getSystemInfo();
 
     /**
      * @brief 获取通信状态
-     * @return Result 包含网络状态、RS485状态、通信正常率等信息
+     * @return Result 包含网络状态、RS485状态、通信正常率（调度中设备在线的百分比）等信息
      */
     static Result getCommStatus();
 
@@ -60,6 +60,42 @@ public:
      */
     static Result setSerialConfig(const SerialConfig &cfg);
 
+    /**
+     * @brief 获取当前生效的串口配置结构体（供传输层打开串口）
+     * @return SerialConfig 当前串口配置
+     */
+    static SerialConfig currentSerialConfig();
+
+    /**
+     * @brief 获取指定总线的串口配置
+     *
+     * 各总线共用当前串口配置的波特率、数据位、校验位和停止位，只替换串口名称。
+     * @param port 串口名称，为空表示默认总线
+     * @return SerialConfig 该总线的串口配置
+     */
+    static SerialConfig serialConfigFor(const QString &port);
+
+    /**
+     * @brief 获取历史数据保留天数
+     * @return Result data为天数
+     */
+    static Result getRetentionDays();
+
+    /**
+     * @brief 设置历史数据保留天数并保存到数据库
+     *
+     * 同时作用于历史存储的分段和数据库的realtime_data表，超出保留期的数据在后台
+     * 分步删除，不影响采集和界面。
+     * @param days 保留天数（1-3650）
+     * @return Result 设置结果
+     */
+    static Result setRetentionDays(int days);
+
+    /**
+     * @brief 应用数据库中保存的保留天数（启动时在打开数据库后调用，未保存时使用默认的90天）
+     */
+    static void loadRetention();
+
     /**
      * @brief 重启通信服务
      * @return Result 重启结果
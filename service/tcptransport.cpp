@@ -0,0 +1,427 @@
+/**
+ * @file tcptransport.cpp
+ * @brief Modbus TCP / RTU over TCP传输实现
+ *
+ * 本文件实现了TCP连接管理和两种封装的收发：
+ * - Modbus TCP：把RTU请求帧去掉地址和CRC后加上MBAP报文头发出，收到的响应
+ *   按事务ID找到对应事务，再补回地址和CRC还原成RTU帧，编解码器无需改动；
+ * - RTU over TCP：原样收发RTU帧，按功能码和字节数判定响应帧结束。
+ */
+
+#include "tcptransport.h"
+#include "pollingscheduler.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * @brief 等待socket可读或可写
+ * @return true表示就绪
+ */
+static bool waitSocket(int fd, short events, qint64 timeoutUs)
+{
+    if (timeoutUs < 0) {
+        timeoutUs = 0;
+    }
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = events;
+    pfd.revents = 0;
+    int timeoutMs = static_cast<int>((timeoutUs + 999) / 1000);
+    int n;
+    do {
+        n = ::poll(&pfd, 1, timeoutMs);
+    } while (n < 0 && errno == EINTR);
+    return n > 0;
+}
+
+TcpTransport::TcpTransport()
+    : m_fd(-1)
+    , m_port(DefaultPort)
+    , m_framing(Mbap)
+    , m_maxInFlight(1)
+    , m_nextTid(1)
+    , m_rxLength(0)
+{
+}
+
+TcpTransport::~TcpTransport()
+{
+    close();
+}
+
+bool TcpTransport::isEndpoint(const QString &endpoint)
+{
+    return endpoint.startsWith("tcp://") || endpoint.startsWith("rtutcp://");
+}
+
+bool TcpTransport::parseEndpoint(const QString &endpoint, QString *host, int *port, Framing *framing)
+{
+    QString rest;
+    Framing f;
+    if (endpoint.startsWith("tcp://")) {
+        f = Mbap;
+        rest = endpoint.mid(6);
+    } else if (endpoint.startsWith("rtutcp://")) {
+        f = RtuOverTcp;
+        rest = endpoint.mid(9);
+    } else {
+        return false;
+    }
+
+    QString h = rest;
+    int p = DefaultPort;
+    int colon = rest.lastIndexOf(':');
+    if (colon >= 0) {
+        bool ok = false;
+        h = rest.left(colon);
+        p = rest.mid(colon + 1).toInt(&ok);
+        if (!ok || p < 1 || p > 65535) {
+            return false;
+        }
+    }
+    if (h.isEmpty()) {
+        return false;
+    }
+
+    if (host) {
+        *host = h;
+    }
+    if (port) {
+        *port = p;
+    }
+    if (framing) {
+        *framing = f;
+    }
+    return true;
+}
+
+Result TcpTransport::open(const QString &endpoint, int maxInFlight)
+{
+    close();
+    if (!parseEndpoint(endpoint, &m_host, &m_port, &m_framing)) {
+        return Result::error(1, QString("无效的TCP地址：%1").arg(endpoint));
+    }
+    m_maxInFlight = m_framing == RtuOverTcp ? 1 : qBound(1, maxInFlight, static_cast<int>(MaxInFlight));
+    return connectSocket();
+}
+
+void TcpTransport::close()
+{
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_rxLength = 0;
+}
+
+bool TcpTransport::isOpen() const
+{
+    return m_fd >= 0;
+}
+
+Result TcpTransport::connectSocket()
+{
+    close();
+    if (m_host.isEmpty()) {
+        return Result::error(1, "未设置TCP地址");
+    }
+
+    struct addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo *addr = nullptr;
+    QByteArray host = m_host.toLocal8Bit();
+    QByteArray service = QByteArray::number(m_port);
+    if (::getaddrinfo(host.constData(), service.constData(), &hints, &addr) != 0 || !addr) {
+        return Result::error(2, QString("无法解析主机：%1").arg(m_host));
+    }
+
+    int fd = ::socket(addr->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        ::freeaddrinfo(addr);
+        return Result::error(3, QString("创建socket失败：%1").arg(std::strerror(errno)));
+    }
+
+    int rc = ::connect(fd, addr->ai_addr, addr->ai_addrlen);
+    ::freeaddrinfo(addr);
+    if (rc < 0 && errno == EINPROGRESS) {
+        int err = ETIMEDOUT;
+        socklen_t len = sizeof(err);
+        if (waitSocket(fd, POLLOUT, ConnectTimeoutMs * 1000LL)) {
+            ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        }
+        rc = err == 0 ? 0 : -1;
+        errno = err;
+    }
+    if (rc < 0) {
+        QString reason = std::strerror(errno);
+        ::close(fd);
+        return Result::error(4, QString("连接%1:%2失败：%3").arg(m_host).arg(m_port).arg(reason));
+    }
+
+    // 请求帧很小，关闭Nagle以免流水线上的请求被合并延迟
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    m_fd = fd;
+    m_rxLength = 0;
+    return Result::success();
+}
+
+bool TcpTransport::sendAll(const quint8 *data, int length, int timeoutMs)
+{
+    int written = 0;
+    while (written < length) {
+        ssize_t n = ::send(m_fd, data + written, length - written, MSG_NOSIGNAL);
+        if (n > 0) {
+            written += static_cast<int>(n);
+            continue;
+        }
+        if (n < 0 && errno != EAGAIN && errno != EINTR) {
+            return false;
+        }
+        if (!waitSocket(m_fd, POLLOUT, timeoutMs * 1000LL)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TcpTransport::failAll(ModbusTransaction *items, int from, int count, ModbusRtu::Status status)
+{
+    for (int i = from; i < count; ++i) {
+        items[i].status = status;
+        items[i].response.length = 0;
+    }
+}
+
+ModbusRtu::Status TcpTransport::transact(const ModbusFrame &request, ModbusFrame &response,
+                                         int expectedLength, int timeoutMs)
+{
+    ModbusTransaction t;
+    t.request = request;
+    t.expectedLength = expectedLength;
+    transactBatch(&t, 1, timeoutMs);
+    response = t.response;
+    return t.status;
+}
+
+void TcpTransport::transactRtu(ModbusTransaction &t, int timeoutMs)
+{
+    t.response.length = 0;
+
+    // 丢弃上一事务超时后迟到的字节，避免错位
+    quint8 stale[64];
+    while (::recv(m_fd, stale, sizeof(stale), MSG_DONTWAIT) > 0) {
+    }
+
+    qint64 sentNs = PollingScheduler::monotonicNs();
+    if (!sendAll(t.request.data, t.request.length, timeoutMs)) {
+        close();
+        t.status = ModbusRtu::ErrIo;
+        return;
+    }
+
+    qint64 deadlineNs = sentNs + static_cast<qint64>(timeoutMs) * 1000000LL;
+    int need = 0;
+    while (need == 0 || t.response.length < need) {
+        if (!waitSocket(m_fd, POLLIN, (deadlineNs - PollingScheduler::monotonicNs()) / 1000)) {
+            t.status = ModbusRtu::ErrTimeout;
+            return;
+        }
+        ssize_t n = ::recv(m_fd, t.response.data + t.response.length,
+                           ModbusFrame::Capacity - t.response.length, 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+            close();
+            t.status = ModbusRtu::ErrIo;
+            return;
+        }
+        if (n > 0) {
+            t.response.length += static_cast<int>(n);
+        }
+
+        // TCP上没有t3.5，只能按功能码和字节数确定帧长
+        if (need == 0 && t.response.length >= 3) {
+            quint8 fc = t.response.data[1];
+            if (fc & 0x80) {
+                need = ModbusRtu::ExceptionFrameLength;
+            } else if (ModbusRtu::isReadFunction(fc)) {
+                need = 5 + t.response.data[2];
+            } else {
+                need = 8;   // 写操作的回显
+            }
+        }
+        if (t.response.length >= ModbusFrame::Capacity) {
+            break;
+        }
+    }
+
+    t.rttUs = (PollingScheduler::monotonicNs() - sentNs) / 1000;
+    t.status = ModbusRtu::Ok;
+}
+
+void TcpTransport::transactBatch(ModbusTransaction *items, int count, int timeoutMs)
+{
+    if (m_fd < 0 && !connectSocket().isSuccess()) {
+        failAll(items, 0, count, ModbusRtu::ErrIo);
+        return;
+    }
+
+    if (m_framing == RtuOverTcp) {
+        // 串口服务器后面仍是一问一答的RS485总线
+        for (int i = 0; i < count; ++i) {
+            transactRtu(items[i], timeoutMs);
+            if (items[i].status != ModbusRtu::Ok) {
+                failAll(items, i + 1, count, items[i].status);
+                return;
+            }
+        }
+        return;
+    }
+
+    // 在途事务：槽位 → 事务下标、事务ID、发送时间
+    int slotIndex[MaxInFlight];
+    quint16 slotTid[MaxInFlight];
+    qint64 slotSentNs[MaxInFlight];
+    int inFlight = 0;
+    int next = 0;
+    int done = 0;
+    qint64 timeoutNs = static_cast<qint64>(timeoutMs) * 1000000LL;
+
+    while (done < count) {
+        // 填满发送窗口
+        while (next < count && inFlight < m_maxInFlight) {
+            ModbusTransaction &t = items[next];
+            t.response.length = 0;
+            int pduLength = t.request.length - 3;   // 去掉地址和CRC
+            if (pduLength < 1) {
+                t.status = ModbusRtu::ErrInvalidArgument;
+                next++;
+                done++;
+                continue;
+            }
+
+            quint8 adu[MbapHeaderLength + ModbusFrame::Capacity];
+            quint16 tid = m_nextTid++;
+            adu[0] = static_cast<quint8>(tid >> 8);
+            adu[1] = static_cast<quint8>(tid & 0xFF);
+            adu[2] = 0;     // 协议标识：Modbus
+            adu[3] = 0;
+            adu[4] = static_cast<quint8>((pduLength + 1) >> 8);
+            adu[5] = static_cast<quint8>((pduLength + 1) & 0xFF);
+            adu[6] = t.request.data[0];     // 单元标识 = 从站地址
+            std::memcpy(adu + MbapHeaderLength, t.request.data + 1, pduLength);
+
+            slotIndex[inFlight] = next;
+            slotTid[inFlight] = tid;
+            slotSentNs[inFlight] = PollingScheduler::monotonicNs();
+            inFlight++;
+            next++;
+
+            if (!sendAll(adu, MbapHeaderLength + pduLength, timeoutMs)) {
+                close();
+                for (int s = 0; s < inFlight; ++s) {
+                    failAll(items, slotIndex[s], slotIndex[s] + 1, ModbusRtu::ErrIo);
+                }
+                failAll(items, next, count, ModbusRtu::ErrIo);
+                return;
+            }
+        }
+        if (inFlight == 0) {
+            continue;
+        }
+
+        // 超时的在途事务出队；迟到的响应之后按事务ID找不到槽位而被丢弃
+        qint64 now = PollingScheduler::monotonicNs();
+        qint64 earliest = slotSentNs[0];
+        for (int s = 1; s < inFlight; ++s) {
+            earliest = qMin(earliest, slotSentNs[s]);
+        }
+        if (earliest + timeoutNs <= now) {
+            for (int s = 0; s < inFlight; ) {
+                if (slotSentNs[s] + timeoutNs <= now) {
+                    failAll(items, slotIndex[s], slotIndex[s] + 1, ModbusRtu::ErrTimeout);
+                    inFlight--;
+                    slotIndex[s] = slotIndex[inFlight];
+                    slotTid[s] = slotTid[inFlight];
+                    slotSentNs[s] = slotSentNs[inFlight];
+                    done++;
+                } else {
+                    ++s;
+                }
+            }
+            continue;
+        }
+
+        if (!waitSocket(m_fd, POLLIN, (earliest + timeoutNs - now) / 1000)) {
+            continue;
+        }
+        ssize_t n = ::recv(m_fd, m_rx + m_rxLength, sizeof(m_rx) - m_rxLength, 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+            close();
+            for (int s = 0; s < inFlight; ++s) {
+                failAll(items, slotIndex[s], slotIndex[s] + 1, ModbusRtu::ErrIo);
+            }
+            failAll(items, next, count, ModbusRtu::ErrIo);
+            return;
+        }
+        if (n < 0) {
+            continue;
+        }
+        m_rxLength += static_cast<int>(n);
+
+        // 拆出完整的MBAP报文，按事务ID交给对应事务
+        int pos = 0;
+        while (m_rxLength - pos >= MbapHeaderLength) {
+            const quint8 *h = m_rx + pos;
+            int length = (h[4] << 8) | h[5];    // 单元标识 + PDU
+            if (h[2] != 0 || h[3] != 0 || length < 2 || length > ModbusFrame::Capacity - 2) {
+                // 报文流已错位，只能断开重连
+                close();
+                for (int s = 0; s < inFlight; ++s) {
+                    failAll(items, slotIndex[s], slotIndex[s] + 1, ModbusRtu::ErrFrameLength);
+                }
+                failAll(items, next, count, ModbusRtu::ErrFrameLength);
+                return;
+            }
+            if (m_rxLength - pos < 6 + length) {
+                break;
+            }
+
+            quint16 tid = static_cast<quint16>((h[0] << 8) | h[1]);
+            for (int s = 0; s < inFlight; ++s) {
+                if (slotTid[s] != tid) {
+                    continue;
+                }
+                ModbusTransaction &t = items[slotIndex[s]];
+                t.response.data[0] = h[6];
+                std::memcpy(t.response.data + 1, h + MbapHeaderLength, length - 1);
+                t.response.length = length;
+                ModbusRtu::appendCrc(t.response);   // 还原为RTU帧，复用同一解码器
+                t.status = ModbusRtu::Ok;
+                t.rttUs = (PollingScheduler::monotonicNs() - slotSentNs[s]) / 1000;
+
+                inFlight--;
+                slotIndex[s] = slotIndex[inFlight];
+                slotTid[s] = slotTid[inFlight];
+                slotSentNs[s] = slotSentNs[inFlight];
+                done++;
+                break;
+            }
+            pos += 6 + length;
+        }
+        if (pos > 0) {
+            std::memmove(m_rx, m_rx + pos, m_rxLength - pos);
+            m_rxLength -= pos;
+        }
+    }
+}
@@ -0,0 +1,95 @@
+/**
+ * @file tcptransport.h
+ * @brief Modbus TCP / RTU over TCP传输定义
+ *
+ * 本文件定义了基于非阻塞socket的TCP传输，支持两种封装：
+ * - Modbus TCP：MBAP报文头 + PDU，按事务ID匹配响应，一个连接上可同时
+ *   有多个事务在途（流水线），响应可以乱序返回；
+ * - RTU over TCP：串口服务器透传的RTU帧，只能一问一答。
+ * 设备的busPort写成 tcp://主机:端口 或 rtutcp://主机:端口 即走此传输。
+ */
+
+#ifndef TCPTRANSPORT_H
+#define TCPTRANSPORT_H
+
+#include "../common/result.h"
+#include "modbustransport.h"
+
+/**
+ * @class TcpTransport
+ * @brief Modbus TCP传输类
+ *
+ * 连接断开后在下一次事务时自动重连。一个实例只应由一个线程使用。
+ */
+class TcpTransport : public ModbusTransport
+{
+public:
+    /**
+     * @brief 报文封装方式
+     */
+    enum Framing {
+        Mbap,           ///< Modbus TCP（MBAP报文头）
+        RtuOverTcp      ///< RTU帧透传
+    };
+
+    enum Limits {
+        DefaultPort = 502,
+        MaxInFlight = 16,           ///< 单连接同时在途事务数上限
+        ConnectTimeoutMs = 3000,    ///< 连接超时
+        MbapHeaderLength = 7        ///< MBAP报文头长度（含单元标识）
+    };
+
+    TcpTransport();
+    ~TcpTransport() override;
+
+    /**
+     * @brief 判断总线名称是否为TCP端点
+     * @param endpoint 总线名称（DeviceConfig::busPort）
+     */
+    static bool isEndpoint(const QString &endpoint);
+
+    /**
+     * @brief 解析TCP端点
+     * @param endpoint tcp://主机[:端口] 或 rtutcp://主机[:端口]
+     * @param host 输出主机名或IP
+     * @param port 输出端口（缺省502）
+     * @param framing 输出封装方式
+     * @return false表示格式错误
+     */
+    static bool parseEndpoint(const QString &endpoint, QString *host, int *port, Framing *framing);
+
+    /**
+     * @brief 设置端点并尝试连接
+     * @param endpoint TCP端点
+     * @param maxInFlight 同时在途事务数（RTU over TCP固定为1）
+     * @return Result 连接结果；失败时端点仍保留，之后的事务会重试连接
+     */
+    Result open(const QString &endpoint, int maxInFlight = 4);
+
+    /**
+     * @brief 关闭连接
+     */
+    void close();
+
+    bool isOpen() const override;
+    ModbusRtu::Status transact(const ModbusFrame &request, ModbusFrame &response,
+                               int expectedLength, int timeoutMs) override;
+    void transactBatch(ModbusTransaction *items, int count, int timeoutMs) override;
+
+private:
+    Result connectSocket();
+    bool sendAll(const quint8 *data, int length, int timeoutMs);
+    void transactRtu(ModbusTransaction &t, int timeoutMs);
+    static void failAll(ModbusTransaction *items, int from, int count, ModbusRtu::Status status);
+
+    int m_fd;                   ///< socket描述符
+    QString m_host;             ///< 主机
+    int m_port;                 ///< 端口
+    Framing m_framing;          ///< 封装方式
+    int m_maxInFlight;          ///< 同时在途事务数
+    quint16 m_nextTid;          ///< 下一个事务ID
+    quint8 m_rx[4 * ModbusFrame::Capacity]; ///< 接收缓冲区
+    int m_rxLength;             ///< 接收缓冲区有效字节数
+};
+
+#endif // TCPTRANSPORT_H
@@ -0,0 +1,912 @@
+/**
+ * @file timeseriesstore.cpp
+ * @brief 历史数据时序存储实现
+ *
+ * 每级数据各有一组分段文件，文件名为“<分区起始秒>.<后缀>”：原始样本为.seg（每小时一个），
+ * 分钟汇总为.min（每天一个），小时汇总为.hour（每30天一个）。文件内容是首尾相接的块：
+ * 块头（BlockHeader）之后，原始样本块是SampleCodec压缩的位流（早期版本写入的未压缩块
+ * 依次是count个时间戳、count个值和count个标志，仍可读取），汇总块是count个Bucket。
+ * 块只追加不修改，块头在前，断电时最多丢失末尾一个不完整的块。
+ */
+
+#include "timeseriesstore.h"
+#include "pollingscheduler.h"
+#include "realtimecache.h"
+#include "registersnapshot.h"
+#include "samplecodec.h"
+
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <limits>
+
+namespace {
+
+typedef TimeSeriesStore::Sample Sample;
+typedef TimeSeriesStore::Bucket Bucket;
+
+const quint32 BlockMagic = 0x31425354;      // "TSB1"，块内容未压缩
+const quint32 CompressedMagic = 0x32425354; // "TSB2"，原始样本块按SampleCodec压缩
+const qint64 NsPerSecond = Q_INT64_C(1000000000);
+const int SampleBytes = sizeof(qint64) + sizeof(double) + sizeof(quint8);
+
+static_assert(sizeof(Bucket) == 48, "Bucket按原样写入分段文件，不能有填充");
+
+/**
+ * @brief 分段文件中的块头
+ */
+struct BlockHeader {
+    quint32 magic;          ///< BlockMagic或CompressedMagic
+    qint32 deviceId;        ///< 设备ID
+    qint32 address;         ///< 地址
+    qint32 count;           ///< 样本数或桶数
+    qint64 firstNs;         ///< 第一个样本的时间（汇总块为第一个桶的起始时间）
+    qint64 lastNs;          ///< 最后一个样本的时间（汇总块为最后一个桶的起始时间）
+    quint32 payloadBytes;   ///< 块头之后的字节数
+    quint32 tier;           ///< 数据级别（TimeSeriesStore::Tier）
+};
+
+/**
+ * @brief 各级数据的存放方式
+ */
+struct TierSpec {
+    const char *suffix;         ///< 分段文件后缀
+    qint64 partitionSeconds;    ///< 每个分段覆盖的时间
+    int blockEntries;           ///< 每块的样本数或桶数
+    int entryBytes;             ///< 未压缩块中每个样本或桶占的字节数
+};
+
+const TierSpec Tiers[TimeSeriesStore::TierCount] = {
+    { "seg",  TimeSeriesStore::SegmentSeconds, TimeSeriesStore::BlockSamples, SampleBytes },
+    { "min",  86400,                           60,                            sizeof(Bucket) },
+    { "hour", 30 * 86400,                      12,                            sizeof(Bucket) }
+};
+
+/**
+ * @brief 检查块头与所在分段的级别是否一致、块长度是否合理
+ */
+bool validHeader(const BlockHeader &header, int tier)
+{
+    if (header.tier != static_cast<quint32>(tier) || header.count <= 0 || header.count > Tiers[tier].blockEntries) {
+        return false;
+    }
+    if (header.magic == CompressedMagic) {
+        return tier == TimeSeriesStore::Raw && header.payloadBytes > 0
+                && header.payloadBytes <= static_cast<quint32>(SampleCodec::maxEncodedBytes(header.count));
+    }
+    return header.magic == BlockMagic
+            && header.payloadBytes == static_cast<quint32>(header.count * Tiers[tier].entryBytes);
+}
+
+/**
+ * @brief 磁盘块在内存中的索引项
+ */
+struct BlockRef {
+    qint64 partition;       ///< 所在分段的分区起始秒
+    qint64 offset;          ///< 块头在分段中的偏移
+    qint64 firstNs;         ///< 块头的firstNs
+    qint64 lastNs;          ///< 块头的lastNs
+    qint32 count;           ///< 块头的count
+};
+
+/**
+ * @brief 一级汇总的当前桶和已结束桶的环
+ */
+struct Rollup {
+    enum { Capacity = 128 };    ///< 环容量，不小于每块桶数的两倍
+
+    Bucket open;                ///< 当前桶，count为0表示没有
+    qint64 head;                ///< 已结束的桶数
+    qint64 flushed;             ///< 已交给刷盘线程的桶数
+    qint64 written;             ///< 已写入分段并建立索引的桶数，查询只从环中取此后的桶
+    Bucket ring[Capacity];      ///< 已结束的桶
+};
+
+/**
+ * @brief 一个点的内存环
+ *
+ * head和flushed是自追加开始的累计个数，第i个样本位于ring[i % RingCapacity]。
+ * rollups[t - 1]是第t级汇总。
+ */
+struct Series {
+    QMutex mutex;                                   ///< 保护以下字段
+    int deviceId;                                   ///< 设备ID
+    int address;                                    ///< 地址
+    qint64 head;                                    ///< 已追加的样本数
+    qint64 flushed;                                 ///< 已交给刷盘线程的样本数
+    qint64 lost;                                    ///< 刷盘不及被覆盖的样本数和桶数
+    Sample ring[TimeSeriesStore::RingCapacity];     ///< 样本环
+    Rollup rollups[TimeSeriesStore::TierCount - 1]; ///< 各级汇总
+};
+
+inline quint64 seriesKey(int deviceId, int address)
+{
+    return (static_cast<quint64>(static_cast<quint32>(deviceId)) << 32) | static_cast<quint32>(address);
+}
+
+inline qint64 partitionOf(int tier, qint64 timestampNs)
+{
+    qint64 seconds = timestampNs / NsPerSecond;
+    return seconds - seconds % Tiers[tier].partitionSeconds;
+}
+
+inline qint64 bucketStart(qint64 timestampNs, qint64 widthNs)
+{
+    qint64 r = timestampNs % widthNs;
+    return timestampNs - (r < 0 ? r + widthNs : r);
+}
+
+/**
+ * @brief 把当前桶移入已结束的环
+ */
+void closeBucket(Rollup &r)
+{
+    if (r.open.count > 0) {
+        r.ring[r.head % Rollup::Capacity] = r.open;
+        r.head++;
+        r.open.count = 0;
+    }
+}
+
+std::atomic<Series *> s_series[RealtimeCache::Capacity];
+
+QMutex s_indexMutex;                                            ///< 保护以下索引状态
+QString s_directory;                                            ///< 数据目录，为空表示未打开
+QHash<quint64, QVector<BlockRef>> s_index[TimeSeriesStore::TierCount];  ///< 点 → 磁盘块（按firstNs升序）
+QMap<qint64, qint64> s_segments[TimeSeriesStore::TierCount];    ///< 分区起始秒 → 分段文件大小
+qint64 s_blockCount = 0;                                        ///< 磁盘块数
+qint64 s_diskSamples = 0;                                       ///< 已落盘的原始样本数
+qint64 s_droppedSegments = 0;                                   ///< 因超出保留期删除的分段数
+
+std::atomic<int> s_retentionDays(TimeSeriesStore::DefaultRetentionDays);   ///< 保留天数，0表示不删除
+
+QString segmentPath(const QString &directory, int tier, qint64 partition)
+{
+    return QString("%1/%2.%3").arg(directory).arg(partition).arg(Tiers[tier].suffix);
+}
+
+void insertBlock(int tier, quint64 key, const BlockRef &ref)
+{
+    QVector<BlockRef> &blocks = s_index[tier][key];
+    auto pos = std::upper_bound(blocks.begin(), blocks.end(), ref.firstNs,
+                                [](qint64 ns, const BlockRef &b) { return ns < b.firstNs; });
+    blocks.insert(pos, ref);
+}
+
+/**
+ * @brief 把查询起点限制在保留期内
+ *
+ * 分段整个过期才删除，各级分段的时间跨度不同，已过期但尚未删除的数据不返回，
+ * 各级数据的可见范围保持一致。
+ */
+qint64 retainedFrom(qint64 fromNs)
+{
+    int days = s_retentionDays.load(std::memory_order_relaxed);
+    if (days <= 0) {
+        return fromNs;
+    }
+    return qMax(fromNs, PollingScheduler::wallClockNs() - days * 86400 * NsPerSecond);
+}
+
+/**
+ * @brief 从索引中去掉一个分段的所有块（调用者持有s_indexMutex）
+ *
+ * 块按firstNs排列，分区由firstNs决定，所以一个点在最早分段中的块总在最前面。
+ */
+void removePartition(int tier, qint64 partition)
+{
+    QHash<quint64, QVector<BlockRef>> &index = s_index[tier];
+    for (auto it = index.begin(); it != index.end();) {
+        QVector<BlockRef> &blocks = *it;
+        int n = 0;
+        while (n < blocks.size() && blocks[n].partition == partition) {
+            if (tier == TimeSeriesStore::Raw) {
+                s_diskSamples -= blocks[n].count;
+            }
+            n++;
+        }
+        s_blockCount -= n;
+        blocks.remove(0, n);
+        if (blocks.isEmpty()) {
+            it = index.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    s_segments[tier].remove(partition);
+    s_droppedSegments++;
+}
+
+/**
+ * @brief 取出一个点在某级与区间重叠的磁盘块
+ * @param diskUntilNs 输出该点该级最后一个磁盘块的lastNs，没有块时为最小值
+ * @return 数据目录
+ */
+QString overlappingBlocks(int tier, int deviceId, int address, qint64 fromNs, qint64 toNs,
+                          QVector<BlockRef> *blocks, qint64 *diskUntilNs)
+{
+    // 块按时间排列且互不重叠，lastNs同样有序
+    QMutexLocker locker(&s_indexMutex);
+    *diskUntilNs = std::numeric_limits<qint64>::min();
+    auto it = s_index[tier].constFind(seriesKey(deviceId, address));
+    if (it != s_index[tier].constEnd() && !it->isEmpty()) {
+        *diskUntilNs = it->last().lastNs;
+        auto first = std::lower_bound(it->constBegin(), it->constEnd(), fromNs,
+                                      [](const BlockRef &b, qint64 ns) { return b.lastNs < ns; });
+        for (auto b = first; b != it->constEnd() && b->firstNs <= toNs; ++b) {
+            blocks->append(*b);
+        }
+    }
+    return s_directory;
+}
+
+/**
+ * @brief 依次读取各块的内容
+ * @param visit 对每块调用，参数为块头和块内容，返回false表示块内容已损坏
+ */
+Result readBlocks(const QString &directory, int tier, int deviceId, int address, const QVector<BlockRef> &blocks,
+                  const std::function<bool(const BlockHeader &, const char *)> &visit)
+{
+    Result result = Result::success();
+    QFile file;
+    qint64 openPartition = -1;
+    QByteArray payload;
+    for (const BlockRef &ref : blocks) {
+        if (ref.partition != openPartition) {
+            file.close();
+            file.setFileName(segmentPath(directory, tier, ref.partition));
+            if (!file.open(QIODevice::ReadOnly)) {
+                openPartition = -1;
+                result = Result::error(1, QString("无法读取历史数据分段%1").arg(file.fileName()));
+                continue;
+            }
+            openPartition = ref.partition;
+        }
+
+        BlockHeader header;
+        if (!file.seek(ref.offset)
+                || file.read(reinterpret_cast<char *>(&header), sizeof(header)) != sizeof(header)
+                || header.deviceId != deviceId || header.address != address || !validHeader(header, tier)) {
+            result = Result::error(2, QString("历史数据分段%1已损坏").arg(file.fileName()));
+            continue;
+        }
+        payload = file.read(header.payloadBytes);
+        if (payload.size() != static_cast<int>(header.payloadBytes) || !visit(header, payload.constData())) {
+            result = Result::error(2, QString("历史数据分段%1已损坏").arg(file.fileName()));
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief 查找点的内存环
+ */
+Series *findSeries(int deviceId, int address)
+{
+    int slot = RealtimeCache::findSlot(deviceId, address);
+    return slot >= 0 ? s_series[slot].load(std::memory_order_acquire) : nullptr;
+}
+
+/**
+ * @class Flusher
+ * @brief 刷盘线程：周期性地把各点各级攒满的块写入当前分区的分段
+ */
+class Flusher : public QThread
+{
+public:
+    Flusher()
+        : m_stopping(false)
+    {
+        for (int t = 0; t < TimeSeriesStore::TierCount; ++t) {
+            m_partitions[t] = -1;
+        }
+    }
+
+    void stop()
+    {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_stopping = true;
+            m_wakeup.wakeAll();
+        }
+        wait();
+    }
+
+protected:
+    void run() override
+    {
+        m_samples.resize(TimeSeriesStore::BlockSamples);
+        m_buckets.resize(Rollup::Capacity);
+        for (;;) {
+            bool stopping;
+            {
+                QMutexLocker locker(&m_mutex);
+                if (!m_stopping) {
+                    m_wakeup.wait(&m_mutex, TimeSeriesStore::FlushIntervalMs);
+                }
+                stopping = m_stopping;
+            }
+            flushAll(stopping);
+            if (stopping) {
+                break;
+            }
+            dropExpired(PollingScheduler::wallClockNs());
+        }
+        for (int t = 0; t < TimeSeriesStore::TierCount; ++t) {
+            m_files[t].close();
+        }
+    }
+
+private:
+    void flushAll(bool force)
+    {
+        qint64 nowNs = PollingScheduler::wallClockNs();
+        for (int slot = 0; slot < RealtimeCache::Capacity; ++slot) {
+            Series *s = s_series[slot].load(std::memory_order_acquire);
+            if (!s) {
+                continue;
+            }
+            if (force) {
+                QMutexLocker locker(&s->mutex);
+                for (Rollup &r : s->rollups) {
+                    closeBucket(r);
+                }
+            }
+            while (takeSamples(s, force, nowNs)) {}
+            for (int t = TimeSeriesStore::Minute; t < TimeSeriesStore::TierCount; ++t) {
+                while (takeBuckets(s, t, force)) {}
+            }
+        }
+    }
+
+    /**
+     * @brief 删除已整个超出保留期的分段（每个周期最多MaxDropsPerTick个）
+     *
+     * 先从索引中去掉再删除文件，之后的查询不会再读到它；正在读它的查询仍持有打开的文件。
+     */
+    void dropExpired(qint64 nowNs)
+    {
+        int days = s_retentionDays.load(std::memory_order_relaxed);
+        if (days <= 0) {
+            return;
+        }
+        qint64 cutoff = nowNs / NsPerSecond - static_cast<qint64>(days) * 86400;
+        int dropped = 0;
+        for (int t = 0; t < TimeSeriesStore::TierCount; ++t) {
+            while (dropped < TimeSeriesStore::MaxDropsPerTick) {
+                QString directory;
+                qint64 partition;
+                {
+                    QMutexLocker locker(&s_indexMutex);
+                    if (s_directory.isEmpty() || s_segments[t].isEmpty()
+                            || s_segments[t].firstKey() + Tiers[t].partitionSeconds > cutoff) {
+                        break;
+                    }
+                    directory = s_directory;
+                    partition = s_segments[t].firstKey();
+                    removePartition(t, partition);
+                }
+                if (partition == m_partitions[t]) {
+                    m_files[t].close();
+                    m_partitions[t] = -1;
+                }
+                QFile::remove(segmentPath(directory, t, partition));
+                dropped++;
+            }
+        }
+    }
+
+    /**
+     * @brief 从样本环中取出一块并写盘
+     * @return false表示没有可刷的块
+     */
+    bool takeSamples(Series *s, bool force, qint64 nowNs)
+    {
+        int n;
+        {
+            QMutexLocker locker(&s->mutex);
+            qint64 pending = s->head - s->flushed;
+            if (pending > TimeSeriesStore::RingCapacity) {
+                s->lost += pending - TimeSeriesStore::RingCapacity;
+                s->flushed = s->head - TimeSeriesStore::RingCapacity;
+                pending = TimeSeriesStore::RingCapacity;
+            }
+            if (pending == 0) {
+                return false;
+            }
+            const Sample &oldest = s->ring[s->flushed % TimeSeriesStore::RingCapacity];
+            if (pending < TimeSeriesStore::BlockSamples && !force
+                    && nowNs - oldest.timestampNs < TimeSeriesStore::MaxBufferedSeconds * NsPerSecond) {
+                return false;
+            }
+            n = static_cast<int>(qMin<qint64>(pending, TimeSeriesStore::BlockSamples));
+            for (int i = 0; i < n; ++i) {
+                m_samples[i] = s->ring[(s->flushed + i) % TimeSeriesStore::RingCapacity];
+            }
+            s->flushed += n;
+        }
+
+        m_payload.resize(SampleCodec::maxEncodedBytes(n));
+        m_payload.resize(SampleCodec::encode(m_samples.constData(), n, m_payload.data()));
+        writeBlock(TimeSeriesStore::Raw, s, n, m_samples[0].timestampNs, m_samples[n - 1].timestampNs, 0);
+        return true;
+    }
+
+    /**
+     * @brief 从汇总环中取出一块并写盘（只写满块，停止时写出全部）
+     * @return false表示没有可刷的块
+     */
+    bool takeBuckets(Series *s, int tier, bool force)
+    {
+        int blockEntries = Tiers[tier].blockEntries;
+        int n;
+        qint64 end;
+        {
+            QMutexLocker locker(&s->mutex);
+            Rollup &r = s->rollups[tier - 1];
+            qint64 pending = r.head - r.flushed;
+            if (pending > Rollup::Capacity) {
+                s->lost += pending - Rollup::Capacity;
+                r.flushed = r.head - Rollup::Capacity;
+                pending = Rollup::Capacity;
+            }
+            if (pending == 0 || (pending < blockEntries && !force)) {
+                return false;
+            }
+            n = static_cast<int>(qMin<qint64>(pending, blockEntries));
+            for (int i = 0; i < n; ++i) {
+                m_buckets[i] = r.ring[(r.flushed + i) % Rollup::Capacity];
+            }
+            r.flushed += n;
+            end = r.flushed;
+        }
+
+        m_payload.resize(n * sizeof(Bucket));
+        memcpy(m_payload.data(), m_buckets.constData(), n * sizeof(Bucket));
+        writeBlock(tier, s, n, m_buckets[0].startNs, m_buckets[n - 1].startNs, end);
+        return true;
+    }
+
+    /**
+     * @brief 把m_payload作为一块追加到所在分区的分段
+     * @param end 汇总块写完后该级的written值（原始样本块不用）
+     */
+    void writeBlock(int tier, Series *s, int n, qint64 firstNs, qint64 lastNs, qint64 end)
+    {
+        QString directory;
+        {
+            QMutexLocker locker(&s_indexMutex);
+            directory = s_directory;
+        }
+        if (directory.isEmpty()) {
+            return;     // 未打开目录，只保留内存中的数据
+        }
+
+        BlockHeader header;
+        header.magic = tier == TimeSeriesStore::Raw ? CompressedMagic : BlockMagic;
+        header.deviceId = s->deviceId;
+        header.address = s->address;
+        header.count = n;
+        header.firstNs = firstNs;
+        header.lastNs = lastNs;
+        header.payloadBytes = static_cast<quint32>(m_payload.size());
+        header.tier = static_cast<quint32>(tier);
+
+        QFile &file = m_files[tier];
+        qint64 partition = partitionOf(tier, firstNs);
+        if (partition != m_partitions[tier] || !file.isOpen()) {
+            file.close();
+            file.setFileName(segmentPath(directory, tier, partition));
+            if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+                m_partitions[tier] = -1;
+                return;
+            }
+            m_partitions[tier] = partition;
+        }
+
+        qint64 offset = file.size();
+        if (file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != sizeof(header)
+                || file.write(m_payload) != m_payload.size() || !file.flush()) {
+            file.resize(offset);    // 不留下不完整的块
+            return;
+        }
+
+        // 汇总块的索引与written一起更新，查询不会同时从磁盘和环中取到同一个桶
+        QMutexLocker seriesLocker(&s->mutex);
+        QMutexLocker locker(&s_indexMutex);
+        insertBlock(tier, seriesKey(s->deviceId, s->address), { partition, offset, firstNs, lastNs, n });
+        if (tier != TimeSeriesStore::Raw) {
+            s->rollups[tier - 1].written = end;
+        }
+        s_segments[tier][partition] = file.size();
+        s_blockCount++;
+        if (tier == TimeSeriesStore::Raw) {
+            s_diskSamples += n;
+        }
+    }
+
+    QMutex m_mutex;                                 ///< 保护m_stopping
+    QWaitCondition m_wakeup;                        ///< 停止时唤醒
+    bool m_stopping;                                ///< 是否正在停止
+    QVector<Sample> m_samples;                      ///< 待写的一块样本
+    QVector<Bucket> m_buckets;                      ///< 待写的一块汇总桶
+    QByteArray m_payload;                           ///< 待写的块内容
+    QFile m_files[TimeSeriesStore::TierCount];      ///< 各级当前分区的分段
+    qint64 m_partitions[TimeSeriesStore::TierCount];    ///< m_files对应的分区起始秒
+};
+
+Flusher *s_flusher = nullptr;
+
+/**
+ * @brief 读取一个分段的块头建立索引，截掉末尾不完整的块
+ */
+void scanSegment(const QString &path, int tier, qint64 partition)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadWrite)) {
+        return;
+    }
+    qint64 size = file.size();
+    qint64 offset = 0;
+    BlockHeader header;
+    while (offset + static_cast<qint64>(sizeof(header)) <= size) {
+        if (!file.seek(offset)
+                || file.read(reinterpret_cast<char *>(&header), sizeof(header)) != sizeof(header)
+                || !validHeader(header, tier)
+                || offset + static_cast<qint64>(sizeof(header)) + header.payloadBytes > size) {
+            break;
+        }
+        insertBlock(tier, seriesKey(header.deviceId, header.address),
+                    { partition, offset, header.firstNs, header.lastNs, header.count });
+        s_blockCount++;
+        if (tier == TimeSeriesStore::Raw) {
+            s_diskSamples += header.count;
+        }
+        offset += sizeof(header) + header.payloadBytes;
+    }
+    if (offset < size) {
+        file.resize(offset);
+    }
+    s_segments[tier].insert(partition, offset);
+}
+
+/**
+ * @brief 统计原始样本
+ */
+Result rawStatistics(int deviceId, int address, qint64 fromNs, qint64 toNs, Bucket *result)
+{
+    QVector<Sample> samples;
+    Result r = TimeSeriesStore::query(deviceId, address, fromNs, toNs, &samples);
+    for (const Sample &s : samples) {
+        if (RegisterSnapshot::qualityOf(s.flags) != RegisterSnapshot::Bad) {
+            result->add(s.value);
+        }
+    }
+    return r;
+}
+
+/**
+ * @brief 用第tier级的整桶统计区间，两端和缺桶处递归到下一级
+ */
+Result tierStatistics(int deviceId, int address, int tier, qint64 fromNs, qint64 toNs, Bucket *result)
+{
+    if (fromNs > toNs) {
+        return Result::success();
+    }
+    if (tier == TimeSeriesStore::Raw) {
+        return rawStatistics(deviceId, address, fromNs, toNs, result);
+    }
+
+    // 完整落在区间内的桶为[first, end)
+    qint64 widthNs = TimeSeriesStore::bucketSeconds(tier) * NsPerSecond;
+    qint64 first = bucketStart(fromNs + widthNs - 1, widthNs);
+    qint64 end = bucketStart(toNs + 1, widthNs);
+    if (first >= end) {
+        return tierStatistics(deviceId, address, tier - 1, fromNs, toNs, result);
+    }
+
+    Result r = tierStatistics(deviceId, address, tier - 1, fromNs, first - 1, result);
+    QVector<Bucket> buckets;
+    Result q = TimeSeriesStore::queryBuckets(deviceId, address, tier, first, end - 1, &buckets);
+    if (!q.isSuccess()) {
+        r = q;
+    }
+    qint64 cursor = first;
+    for (const Bucket &b : buckets) {
+        if (b.startNs > cursor) {
+            q = tierStatistics(deviceId, address, tier - 1, cursor, b.startNs - 1, result);
+            if (!q.isSuccess()) r = q;
+        }
+        result->merge(b);
+        cursor = b.startNs + widthNs;
+    }
+    q = tierStatistics(deviceId, address, tier - 1, cursor, toNs, result);
+    if (!q.isSuccess()) {
+        r = q;
+    }
+    return r;
+}
+
+} // namespace
+
+qint64 TimeSeriesStore::bucketSeconds(int tier)
+{
+    switch (tier) {
+    case Minute: return 60;
+    case Hour:   return 3600;
+    default:     return 0;
+    }
+}
+
+void TimeSeriesStore::setRetentionDays(int days)
+{
+    s_retentionDays.store(qMax(0, days), std::memory_order_relaxed);
+}
+
+int TimeSeriesStore::retentionDays()
+{
+    return s_retentionDays.load(std::memory_order_relaxed);
+}
+
+QString TimeSeriesStore::defaultDirectory()
+{
+    return "/data/history";
+}
+
+Result TimeSeriesStore::open(const QString &directory)
+{
+    close();
+
+    QDir dir(directory);
+    if (!dir.mkpath(".")) {
+        return Result::error(1, QString("无法创建历史数据目录%1").arg(directory));
+    }
+
+    {
+        QMutexLocker locker(&s_indexMutex);
+        s_blockCount = 0;
+        s_diskSamples = 0;
+        for (int t = 0; t < TierCount; ++t) {
+            s_index[t].clear();
+            s_segments[t].clear();
+            QString suffix = QString(".") + Tiers[t].suffix;
+            for (const QString &name : dir.entryList(QStringList() << "*" + suffix, QDir::Files)) {
+                bool ok;
+                qint64 partition = name.left(name.size() - suffix.size()).toLongLong(&ok);
+                if (ok) {
+                    scanSegment(dir.filePath(name), t, partition);
+                }
+            }
+        }
+        s_directory = dir.absolutePath();
+    }
+
+    s_flusher = new Flusher();
+    s_flusher->start(QThread::LowPriority);
+    return Result::success();
+}
+
+void TimeSeriesStore::close()
+{
+    if (s_flusher) {
+        s_flusher->stop();      // 退出前结束当前桶，把未落盘的数据全部写入
+        delete s_flusher;
+        s_flusher = nullptr;
+    }
+    QMutexLocker locker(&s_indexMutex);
+    s_directory.clear();
+}
+
+void TimeSeriesStore::attach(int slot, int deviceId, int address)
+{
+    if (slot < 0 || slot >= RealtimeCache::Capacity || s_series[slot].load(std::memory_order_acquire)) {
+        return;
+    }
+    Series *series = new Series();
+    series->deviceId = deviceId;
+    series->address = address;
+    series->head = 0;
+    series->flushed = 0;
+    series->lost = 0;
+    for (Rollup &r : series->rollups) {
+        r.open.count = 0;
+        r.head = 0;
+        r.flushed = 0;
+        r.written = 0;
+    }
+
+    // 槽与实时值缓存一样不回收
+    Series *expected = nullptr;
+    if (!s_series[slot].compare_exchange_strong(expected, series, std::memory_order_acq_rel)) {
+        delete series;
+    }
+}
+
+void TimeSeriesStore::append(int slot, double value, qint64 timestampNs, quint8 flags)
+{
+    if (slot < 0 || slot >= RealtimeCache::Capacity) {
+        return;
+    }
+    Series *s = s_series[slot].load(std::memory_order_acquire);
+    if (!s) {
+        return;
+    }
+    QMutexLocker locker(&s->mutex);
+    Sample &sample = s->ring[s->head % RingCapacity];
+    sample.timestampNs = timestampNs;
+    sample.value = value;
+    sample.flags = flags;
+    s->head++;
+
+    if (RegisterSnapshot::qualityOf(flags) == RegisterSnapshot::Bad) {
+        return;     // 无效值不进入汇总
+    }
+    for (int t = Minute; t < TierCount; ++t) {
+        Rollup &r = s->rollups[t - 1];
+        qint64 start = bucketStart(timestampNs, bucketSeconds(t) * NsPerSecond);
+        if (r.open.count > 0 && r.open.startNs != start) {
+            closeBucket(r);
+        }
+        if (r.open.count == 0) {
+            r.open.startNs = start;
+        }
+        r.open.add(value);
+    }
+}
+
+Result TimeSeriesStore::query(int deviceId, int address, qint64 fromNs, qint64 toNs, QVector<Sample> *samples)
+{
+    samples->clear();
+    fromNs = retainedFrom(fromNs);
+
+    QVector<BlockRef> blocks;
+    qint64 diskUntilNs;
+    QString directory = overlappingBlocks(Raw, deviceId, address, fromNs, toNs, &blocks, &diskUntilNs);
+    QVector<Sample> decoded(BlockSamples);
+    Result result = readBlocks(directory, Raw, deviceId, address, blocks,
+                               [&](const BlockHeader &header, const char *p) {
+        int n = header.count;
+        if (header.magic == CompressedMagic) {
+            if (!SampleCodec::decode(p, header.payloadBytes, n, decoded.data())) {
+                return false;
+            }
+            for (int i = 0; i < n; ++i) {
+                if (decoded[i].timestampNs >= fromNs && decoded[i].timestampNs <= toNs) {
+                    samples->append(decoded[i]);
+                }
+            }
+            return true;
+        }
+        const qint64 *timestamps = reinterpret_cast<const qint64 *>(p);
+        const double *values = reinterpret_cast<const double *>(p + n * sizeof(qint64));
+        const quint8 *flags = reinterpret_cast<const quint8 *>(p + n * (sizeof(qint64) + sizeof(double)));
+        for (int i = 0; i < n; ++i) {
+            if (timestamps[i] >= fromNs && timestamps[i] <= toNs) {
+                samples->append({ timestamps[i], values[i], flags[i] });
+            }
+        }
+        return true;
+    });
+
+    // 环中比最后一个磁盘块更新的样本（含已交给刷盘线程、尚未写完的）
+    Series *s = findSeries(deviceId, address);
+    if (s) {
+        QMutexLocker locker(&s->mutex);
+        for (qint64 i = qMax<qint64>(0, s->head - RingCapacity); i < s->head; ++i) {
+            const Sample &sample = s->ring[i % RingCapacity];
+            if (sample.timestampNs > diskUntilNs && sample.timestampNs >= fromNs && sample.timestampNs <= toNs) {
+                samples->append(sample);
+            }
+        }
+    }
+    return result;
+}
+
+Result TimeSeriesStore::queryBuckets(int deviceId, int address, int tier, qint64 fromNs, qint64 toNs,
+                                     QVector<Bucket> *buckets)
+{
+    buckets->clear();
+    if (tier != Minute && tier != Hour) {
+        return Result::error(3, "无效的汇总级别");
+    }
+    fromNs = retainedFrom(fromNs);
+
+    // 重启后同一个桶可能被写成两段，起始时间相同的相邻桶合并为一个
+    auto add = [&](const Bucket &b) {
+        if (b.count == 0 || b.startNs < fromNs || b.startNs > toNs) {
+            return;
+        }
+        if (!buckets->isEmpty() && buckets->last().startNs == b.startNs) {
+            buckets->last().merge(b);
+        } else {
+            buckets->append(b);
+        }
+    };
+
+    // 在点的锁内同时取磁盘块和环中尚未写入分段的桶，与刷盘线程更新索引互斥
+    QVector<BlockRef> blocks;
+    QVector<Bucket> pending;
+    QString directory;
+    qint64 diskUntilNs;
+    Series *s = findSeries(deviceId, address);
+    if (s) {
+        QMutexLocker locker(&s->mutex);
+        directory = overlappingBlocks(tier, deviceId, address, fromNs, toNs, &blocks, &diskUntilNs);
+        const Rollup &r = s->rollups[tier - 1];
+        for (qint64 i = qMax(r.written, r.head - Rollup::Capacity); i < r.head; ++i) {
+            pending.append(r.ring[i % Rollup::Capacity]);
+        }
+        pending.append(r.open);
+    } else {
+        directory = overlappingBlocks(tier, deviceId, address, fromNs, toNs, &blocks, &diskUntilNs);
+    }
+
+    Result result = readBlocks(directory, tier, deviceId, address, blocks,
+                               [&](const BlockHeader &header, const char *p) {
+        const Bucket *entries = reinterpret_cast<const Bucket *>(p);
+        for (int i = 0; i < header.count; ++i) {
+            add(entries[i]);
+        }
+        return true;
+    });
+    for (const Bucket &b : pending) {
+        add(b);
+    }
+    return result;
+}
+
+Result TimeSeriesStore::statistics(int deviceId, int address, qint64 fromNs, qint64 toNs, Bucket *result)
+{
+    result->startNs = fromNs;
+    result->count = 0;
+    result->min = result->max = result->sum = result->last = 0.0;
+    return tierStatistics(deviceId, address, Hour, retainedFrom(fromNs), toNs, result);
+}
+
+Result TimeSeriesStore::stats()
+{
+    int seriesCount = 0;
+    qint64 lost = 0;
+    for (int slot = 0; slot < RealtimeCache::Capacity; ++slot) {
+        Series *s = s_series[slot].load(std::memory_order_acquire);
+        if (s) {
+            QMutexLocker locker(&s->mutex);
+            seriesCount++;
+            lost += s->lost;
+        }
+    }
+
+    QMutexLocker locker(&s_indexMutex);
+    qint64 diskBytes = 0;
+    qint64 rawBytes = 0;
+    QVariantList segments;
+    for (int t = 0; t < TierCount; ++t) {
+        for (qint64 size : s_segments[t]) {
+            diskBytes += size;
+            if (t == Raw) {
+                rawBytes += size;
+            }
+        }
+        segments.append(s_segments[t].size());
+    }
+    QVariantMap data;
+    data["directory"] = s_directory;
+    data["seriesCount"] = seriesCount;
+    data["segmentCount"] = segments;     // 依次为原始、分钟、小时
+    data["blockCount"] = s_blockCount;
+    data["diskSamples"] = s_diskSamples;
+    data["diskBytes"] = diskBytes;
+    data["bytesPerSample"] = s_diskSamples > 0 ? static_cast<double>(rawBytes) / s_diskSamples : 0.0;
+    data["lostSamples"] = lost;
+    data["retentionDays"] = s_retentionDays.load(std::memory_order_relaxed);
+    data["droppedSegments"] = s_droppedSegments;
+    return Result::success(data);
+}
@@ -0,0 +1,206 @@
+/**
+ * @file timeseriesstore.h
+ * @brief 历史数据时序存储定义
+ *
+ * 本文件定义了按点存放的历史数据：
+ * - 最近的样本在每点一个的定长内存环中，采集线程追加，O(1)且不分配内存；
+ * - 刷盘线程把攒满的块压缩（见SampleCodec）后写入数据分区上只追加的分段文件，
+ *   每个分段覆盖一个时间分区，过期数据按整个分段删除；
+ * - 每个点在内存中保存其磁盘块的时间范围索引，区间查询只读取重叠的块，再拼上环中尚未
+ *   落盘的样本。
+ * 追加样本时同时增量维护1分钟和1小时两级汇总（最小、最大、和、个数、最后值），
+ * 汇总按同样的方式落盘。长窗口的统计和趋势读取几百个汇总桶，而不是数百万个原始样本。
+ * 点与实时值缓存共用槽下标，采集线程追加时不需要查表。
+ */
+
+#ifndef TIMESERIESSTORE_H
+#define TIMESERIESSTORE_H
+
+#include "../common/result.h"
+
+#include <QString>
+#include <QVector>
+
+/**
+ * @class TimeSeriesStore
+ * @brief 历史数据时序存储类
+ *
+ * 每个点只应有一个写者（设备所在总线的采集线程）；查询可在任意线程进行。
+ * 未调用open()或目录不可用时只保留内存中的数据。
+ */
+class TimeSeriesStore
+{
+public:
+    enum Limits {
+        RingCapacity = 512,         ///< 每点内存环的样本数
+        BlockSamples = 256,         ///< 每个磁盘块的样本数，攒满即刷盘
+        FlushIntervalMs = 5000,     ///< 刷盘线程的检查周期
+        MaxBufferedSeconds = 300,   ///< 最早的未落盘样本超过该时长时不足一块也刷盘
+        SegmentSeconds = 3600,      ///< 每个原始样本分段覆盖的时间分区
+        DefaultRetentionDays = 90,  ///< 默认保留天数
+        MaxDropsPerTick = 8         ///< 刷盘线程每个周期最多删除的过期分段数，大量删除分摊到多个周期
+    };
+
+    /**
+     * @brief 数据级别
+     */
+    enum Tier {
+        Raw = 0,        ///< 原始样本
+        Minute = 1,     ///< 1分钟汇总
+        Hour = 2,       ///< 1小时汇总
+        TierCount = 3
+    };
+
+    /**
+     * @struct Sample
+     * @brief 一个历史样本
+     */
+    struct Sample {
+        qint64 timestampNs;     ///< 采集时间（自1970年起的纳秒数）
+        double value;           ///< 工程值
+        quint8 flags;           ///< 标志（RegisterSnapshot::Flag的组合）
+    };
+
+    /**
+     * @struct Bucket
+     * @brief 一个汇总桶（只统计质量不是无效的样本）
+     */
+    struct Bucket {
+        qint64 startNs;     ///< 桶的起始时间（按级别对齐）
+        double min;         ///< 最小值
+        double max;         ///< 最大值
+        double sum;         ///< 和
+        qint64 count;       ///< 样本数，0表示空桶
+        double last;        ///< 时间上最后一个样本的值
+
+        /**
+         * @brief 计入一个样本
+         */
+        void add(double value)
+        {
+            if (count == 0) {
+                min = max = value;
+                sum = 0.0;
+            } else {
+                if (value < min) min = value;
+                if (value > max) max = value;
+            }
+            sum += value;
+            count++;
+            last = value;
+        }
+
+        /**
+         * @brief 合并时间上在本桶之后的另一个桶
+         */
+        void merge(const Bucket &other)
+        {
+            if (other.count == 0) {
+                return;
+            }
+            if (count == 0) {
+                qint64 start = startNs;
+                *this = other;
+                startNs = start;
+                return;
+            }
+            if (other.min < min) min = other.min;
+            if (other.max > max) max = other.max;
+            sum += other.sum;
+            count += other.count;
+            last = other.last;
+        }
+    };
+
+    /**
+     * @brief 汇总级别的桶宽（秒），Raw返回0
+     */
+    static qint64 bucketSeconds(int tier);
+
+    /**
+     * @brief 设置保留天数（可在任意线程调用）
+     *
+     * 刷盘线程按整个分段删除已全部超出保留期的数据，不改写仍在保留期内的分段；
+     * 超出保留期但所在分段尚未删除的数据，查询时也不再返回。
+     * @param days 保留天数，0表示不删除
+     */
+    static void setRetentionDays(int days);
+
+    /**
+     * @brief 当前的保留天数
+     */
+    static int retentionDays();
+
+    /**
+     * @brief 默认的数据目录（数据分区上）
+     */
+    static QString defaultDirectory();
+
+    /**
+     * @brief 打开数据目录，读取已有分段的块索引并启动刷盘线程
+     *
+     * 末尾不完整的块（断电时写了一半）被截掉。
+     * @param directory 分段文件所在目录，不存在时创建
+     * @return Result 失败时只保留内存中的数据
+     */
+    static Result open(const QString &directory);
+
+    /**
+     * @brief 结束各点未满的汇总桶，把所有未落盘的数据写入分段并停止刷盘线程
+     *
+     * 应在采集线程停止后调用。
+     */
+    static void close();
+
+    /**
+     * @brief 为实时值缓存槽分配内存环（采集任务绑定缓存时调用，已分配时直接返回）
+     * @param slot 实时值缓存槽
+     * @param deviceId 设备ID
+     * @param address 地址
+     */
+    static void attach(int slot, int deviceId, int address);
+
+    /**
+     * @brief 追加一个样本并更新各级汇总（仅该槽的写者调用，不分配内存）
+     */
+    static void append(int slot, double value, qint64 timestampNs, quint8 flags);
+
+    /**
+     * @brief 按时间区间读取一个点的原始样本
+     * @param deviceId 设备ID
+     * @param address 地址
+     * @param fromNs 起始时间（含）
+     * @param toNs 结束时间（含）
+     * @param samples 输出，按时间升序
+     * @return Result 读取分段文件失败时返回错误，samples中保留已读出的部分
+     */
+    static Result query(int deviceId, int address, qint64 fromNs, qint64 toNs, QVector<Sample> *samples);
+
+    /**
+     * @brief 按时间区间读取一个点的汇总桶
+     * @param tier Minute或Hour
+     * @param fromNs 起始时间（含），按桶的起始时间比较
+     * @param toNs 结束时间（含）
+     * @param buckets 输出，按时间升序；包括尚未结束的当前桶
+     */
+    static Result queryBuckets(int deviceId, int address, int tier, qint64 fromNs, qint64 toNs,
+                               QVector<Bucket> *buckets);
+
+    /**
+     * @brief 统计一个点在时间区间内的最小、最大、和、个数和最后值
+     *
+     * 完整落在区间内的小时用小时桶，其余的整分钟用分钟桶，两端不足一分钟的部分读原始样本；
+     * 某级缺少桶时（如断电丢失了未落盘的汇总）改用下一级补齐。
+     * @param result 输出，startNs为fromNs，count为0表示区间内没有有效样本
+     */
+    static Result statistics(int deviceId, int address, qint64 fromNs, qint64 toNs, Bucket *result);
+
+    /**
+     * @brief 获取存储统计
+     * @return Result 包含目录、点数、各级分段数、磁盘块数、已落盘样本数、磁盘占用、
+     *         原始样本平均每个占用的字节数（含块头）、丢失的样本数、保留天数和已删除的过期分段数
+     */
+    static Result stats();
+};
+
+#endif // TIMESERIESSTORE_H
@@ -0,0 +1,84 @@
+/**
+ * @file writeplanner.cpp
+ * @brief Modbus写入合并规划器实现
+ *
+ * 本文件实现了写入合并：先按地址展开所有命令，同一地址保留命令ID最大的值；
+ * 再按地址顺序把连续的地址切成不超过协议上限的写请求，
+ * 最后把每条命令挂到与其地址区间相交的写请求上，被覆盖的旧命令随新值一起确认。
+ */
+
+#include "writeplanner.h"
+#include "modbusrtu.h"
+
+#include <QMap>
+
+int WritePlanner::maxGroupSize(bool coils)
+{
+    return coils ? static_cast<int>(ModbusRtu::MaxWriteBits)
+                 : static_cast<int>(ModbusRtu::MaxWriteRegisters);
+}
+
+/**
+ * @brief 合并一种地址空间（线圈或寄存器）的写命令
+ */
+static void planSpace(const QVector<WriteRequest> &requests, bool coils, QVector<WriteGroup> &groups)
+{
+    struct Cell {
+        quint16 value;
+        qint64 commandId;
+    };
+
+    // 地址 → 最新的写入值
+    QMap<int, Cell> cells;
+    for (const WriteRequest &r : requests) {
+        if (r.coils != coils) {
+            continue;
+        }
+        for (int i = 0; i < r.values.size(); ++i) {
+            auto it = cells.find(r.address + i);
+            if (it == cells.end() || it->commandId < r.commandId) {
+                cells.insert(r.address + i, Cell{ r.values[i], r.commandId });
+            }
+        }
+    }
+
+    int first = groups.size();
+    int maxSize = WritePlanner::maxGroupSize(coils);
+    for (auto it = cells.constBegin(); it != cells.constEnd(); ++it) {
+        if (groups.size() > first) {
+            WriteGroup &current = groups.last();
+            if (it.key() == current.start + current.values.size() && current.values.size() < maxSize) {
+                current.values.append(it->value);
+                continue;
+            }
+        }
+        WriteGroup group;
+        group.start = it.key();
+        group.values.append(it->value);
+        groups.append(group);
+    }
+
+    for (int g = first; g < groups.size(); ++g) {
+        WriteGroup &group = groups[g];
+        if (coils) {
+            group.functionCode = group.values.size() == 1 ? 5 : 15;
+        } else {
+            group.functionCode = group.values.size() == 1 ? 6 : 16;
+        }
+
+        int end = group.start + group.values.size();
+        for (const WriteRequest &r : requests) {
+            if (r.coils == coils && r.address < end && r.address + r.values.size() > group.start) {
+                group.commandIds.append(r.commandId);
+            }
+        }
+    }
+}
+
+QVector<WriteGroup> WritePlanner::plan(const QVector<WriteRequest> &requests)
+{
+    QVector<WriteGroup> groups;
+    planSpace(requests, true, groups);
+    planSpace(requests, false, groups);
+    return groups;
+}
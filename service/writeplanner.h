@@ -0,0 +1,65 @@
+/**
+ * @file writeplanner.h
+ * @brief Modbus写入合并规划器定义
+ *
+ * 本文件定义了写入规划器：把同一设备排队中的多条写命令合并为尽量少的写请求。
+ * 同一地址被多条命令写入时以最后一条为准；地址连续的寄存器合并为一次FC16，
+ * 连续的线圈合并为一次FC15，单个寄存器/线圈使用FC06/FC05。
+ * 与读取不同，写入不能填充空洞，只合并严格相邻的地址。
+ */
+
+#ifndef WRITEPLANNER_H
+#define WRITEPLANNER_H
+
+#include <QtGlobal>
+#include <QVector>
+
+/**
+ * @struct WriteRequest
+ * @brief 一条写命令
+ */
+struct WriteRequest {
+    qint64 commandId;           ///< 命令队列中的ID
+    int deviceId;               ///< 设备ID
+    int slave;                  ///< 从站地址
+    bool coils;                 ///< true写线圈，false写保持寄存器
+    int address;                ///< 起始地址
+    QVector<quint16> values;    ///< 写入值；写线圈时非0表示ON
+
+    WriteRequest() : commandId(-1), deviceId(-1), slave(1), coils(false), address(0) {}
+};
+
+/**
+ * @struct WriteGroup
+ * @brief 合并后的一次写请求
+ */
+struct WriteGroup {
+    int functionCode;               ///< 功能码（05/06/15/16）
+    int start;                      ///< 起始地址
+    QVector<quint16> values;        ///< 写入值
+    QVector<qint64> commandIds;     ///< 涉及的命令ID（一条命令可能拆到多个写请求中）
+};
+
+/**
+ * @class WritePlanner
+ * @brief 写入合并规划器类
+ */
+class WritePlanner
+{
+public:
+    /**
+     * @brief 将同一设备的写命令合并为写请求
+     * @param requests 写命令（按提交顺序，commandId越大越新）
+     * @return 写请求列表，线圈在前，各自按地址升序
+     */
+    static QVector<WriteGroup> plan(const QVector<WriteRequest> &requests);
+
+    /**
+     * @brief 获取单次写入的最大数量
+     * @param coils true表示线圈
+     * @return 线圈1968，寄存器123
+     */
+    static int maxGroupSize(bool coils);
+};
+
+#endif // WRITEPLANNER_H
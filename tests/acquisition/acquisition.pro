@@ -0,0 +1,11 @@
+# 采集链路测试：串口传输和RTU编解码经伪终端收发，并打印编解码每帧耗时；
+# 检查采集线程预热后的完整周期不再分配内存，须在包含tests.pri之前打开alloc_counter
+TARGET = tst_acquisition
+CONFIG += testcase alloc_counter
+
+include(../tests.pri)
+
+SOURCES += tst_acquisition.cpp
+
+# glibc 2.34之前openpty()在libutil中
+LIBS += -lutil
@@ -0,0 +1,330 @@
+/**
+ * @file tst_acquisition.cpp
+ * @brief 采集链路测试
+ *
+ * - SerialTransport + ModbusRtu经openpty()伪终端对收发FC03/FC04读请求，
+ *   检查正常响应、异常响应和CRC错误响应的解码结果；
+ * - 伪终端主端关闭（相当于USB转RS485被拔出）后、串口打不开时，事务返回ErrIo；
+ * - 打印读请求编码（含CRC）和125个寄存器读响应解码（含CRC校验）的每帧耗时；
+ * - BusWorker在模拟总线上采集满BusWorker::WarmupCycles轮后，之后的完整采集周期
+ *   （事务、流水线、结果入队、调度和链路统计）不再分配内存（本程序以CONFIG+=alloc_counter构建）。
+ * 任一检查失败时返回非0。
+ */
+
+#include "alloccounter.h"
+#include "busworker.h"
+#include "modbusrtu.h"
+#include "pollingscheduler.h"
+#include "serialtransport.h"
+
+#include <QCoreApplication>
+#include <QThread>
+#include <cstdio>
+#include <limits>
+#include <poll.h>
+#include <pty.h>
+#include <unistd.h>
+
+namespace {
+
+int s_failures = 0;
+volatile quint32 s_sink = 0;    ///< 基准循环的结果写到这里，避免被优化掉
+
+void check(bool ok, const QString &what)
+{
+    printf("%s %s\n", ok ? "PASS" : "FAIL", what.toLocal8Bit().constData());
+    if (!ok) {
+        s_failures++;
+    }
+}
+
+/**
+ * @brief 伪终端从站返回的寄存器值（功能码不同值不同，用来发现功能码错位）
+ */
+quint16 registerValue(quint8 functionCode, int address)
+{
+    return static_cast<quint16>((functionCode == 3 ? 0x3000 : 0x4000) + address);
+}
+
+/**
+ * @class PtySlave
+ * @brief 伪终端主端上的从站：收一个读请求，按指定方式应答一次后退出
+ */
+class PtySlave : public QThread
+{
+public:
+    enum Reply {
+        Normal,     ///< 正常响应
+        Exception,  ///< 异常响应（异常码2：非法数据地址）
+        BadCrc      ///< 正常响应但CRC错误
+    };
+
+    PtySlave(int fd, Reply reply) : m_fd(fd), m_reply(reply) {}
+
+protected:
+    void run() override
+    {
+        ModbusFrame request;
+        while (request.length < 8) {
+            struct pollfd pfd;
+            pfd.fd = m_fd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            if (::poll(&pfd, 1, 1000) <= 0) {
+                return;
+            }
+            ssize_t n = ::read(m_fd, request.data + request.length, 8 - request.length);
+            if (n <= 0) {
+                return;
+            }
+            request.length += static_cast<int>(n);
+        }
+
+        quint8 fc = request.data[1];
+        ModbusFrame response;
+        response.data[0] = request.data[0];
+        if (m_reply == Exception) {
+            response.data[1] = fc | 0x80;
+            response.data[2] = 0x02;
+            response.length = 3;
+        } else {
+            int start = (request.data[2] << 8) | request.data[3];
+            int count = (request.data[4] << 8) | request.data[5];
+            response.data[1] = fc;
+            response.data[2] = static_cast<quint8>(count * 2);
+            response.length = 3;
+            for (int i = 0; i < count; ++i) {
+                quint16 value = registerValue(fc, start + i);
+                response.data[response.length++] = static_cast<quint8>(value >> 8);
+                response.data[response.length++] = static_cast<quint8>(value & 0xFF);
+            }
+        }
+        ModbusRtu::appendCrc(response);
+        if (m_reply == BadCrc) {
+            response.data[response.length - 1] ^= 0xFF;
+        }
+        if (::write(m_fd, response.data, response.length) != response.length) {
+            return;
+        }
+    }
+
+private:
+    int m_fd;           ///< 伪终端主端
+    Reply m_reply;      ///< 应答方式
+};
+
+/**
+ * @brief 经伪终端做一次读事务并检查解码结果
+ */
+void roundTrip(SerialTransport &serial, int master, quint8 functionCode, PtySlave::Reply reply)
+{
+    const quint16 Start = 40;
+    const quint16 Count = 10;
+    static const char *ReplyNames[] = { "normal", "exception", "bad CRC" };
+    QString what = QString("FC%1 %2 reply").arg(int(functionCode), 2, 10, QChar('0')).arg(ReplyNames[reply]);
+
+    ModbusFrame request;
+    ModbusFrame response;
+    ModbusRtu::encodeReadRequest(request, 1, functionCode, Start, Count);
+
+    PtySlave slave(master, reply);
+    slave.start();
+    ModbusRtu::Status status = serial.transact(request, response,
+                                               ModbusRtu::expectedReadResponseLength(functionCode, Count), 1000);
+    slave.wait();
+
+    quint16 values[Count] = {};
+    quint8 exceptionCode = 0;
+    if (status == ModbusRtu::Ok) {
+        status = ModbusRtu::decodeReadResponse(response, 1, functionCode, Count, values, &exceptionCode);
+    }
+
+    switch (reply) {
+    case PtySlave::Normal: {
+        bool match = true;
+        for (int i = 0; i < Count; ++i) {
+            match = match && values[i] == registerValue(functionCode, Start + i);
+        }
+        check(status == ModbusRtu::Ok && match, what);
+        break;
+    }
+    case PtySlave::Exception:
+        check(status == ModbusRtu::ErrException && exceptionCode == 0x02, what);
+        break;
+    case PtySlave::BadCrc:
+        check(status == ModbusRtu::ErrCrc, what);
+        break;
+    }
+}
+
+/**
+ * @brief 编解码每帧耗时
+ */
+void benchmarkCodec()
+{
+    const int EncodeFrames = 1000000;
+    const int DecodeFrames = 200000;
+    quint32 sink = 0;
+
+    ModbusFrame request;
+    qint64 start = PollingScheduler::monotonicNs();
+    for (int i = 0; i < EncodeFrames; ++i) {
+        ModbusRtu::encodeReadRequest(request, 1, 3, static_cast<quint16>(i & 0xFFF), ModbusRtu::MaxReadRegisters);
+        sink += request.data[7];
+    }
+    qint64 encodeNs = PollingScheduler::monotonicNs() - start;
+
+    ModbusFrame response;
+    response.data[0] = 1;
+    response.data[1] = 3;
+    response.data[2] = ModbusRtu::MaxReadRegisters * 2;
+    response.length = 3;
+    for (int i = 0; i < ModbusRtu::MaxReadRegisters; ++i) {
+        response.data[response.length++] = static_cast<quint8>(i);
+        response.data[response.length++] = static_cast<quint8>(i * 7);
+    }
+    ModbusRtu::appendCrc(response);
+
+    quint16 values[ModbusRtu::MaxReadRegisters];
+    start = PollingScheduler::monotonicNs();
+    for (int i = 0; i < DecodeFrames; ++i) {
+        ModbusRtu::decodeReadResponse(response, 1, 3, ModbusRtu::MaxReadRegisters, values);
+        sink += values[i % ModbusRtu::MaxReadRegisters];
+    }
+    qint64 decodeNs = PollingScheduler::monotonicNs() - start;
+    s_sink = sink;
+
+    printf("encode+CRC, %d-byte request:  %.1f ns/frame\n", request.length, double(encodeNs) / EncodeFrames);
+    printf("decode+CRC, %d-byte response: %.1f ns/frame\n", response.length, double(decodeNs) / DecodeFrames);
+}
+
+/**
+ * @brief 预热后的完整采集周期不分配内存
+ *
+ * 在模拟总线上运行BusWorker，计量范围覆盖采集线程的一整轮：取出到期设备、传输层事务、
+ * 流水线各级、分发级经SPSC队列入队、调度器complete/markFresh和链路统计更新，
+ * 稳态周期有分配时计入steadyAllocCycles。本线程像界面线程一样随时取走结果。
+ * 模拟从站的值每秒变化一次，稳态阶段至少持续SteadyMs，保证稳态周期中有结果入队。
+ */
+void checkSteadyStateAllocations()
+{
+    const int SteadyCycles = 50;
+    const qint64 SteadyMs = 2100;
+    const qint64 TimeoutMs = 30000;
+    const int Slaves[] = { 1, 2, 5, 10 };
+
+    SerialConfig bus;
+    bus.port = "sim://tst_acquisition";
+    bus.baudRate = 115200;
+    BusWorker worker(bus);
+    worker.setResponseTimeout(100);
+    int devices = 0;
+    for (int slave : Slaves) {
+        DeviceConfig cfg;
+        cfg.id = ++devices;
+        cfg.modbusAddress = slave;
+        cfg.pollInterval = 10;
+        RegisterPoint voltage(3, 0, 2);
+        voltage.dataType = RegisterDecoder::Float32;
+        cfg.points << voltage << RegisterPoint(3, 2, 8) << RegisterPoint(4, 100, 4) << RegisterPoint(1, 0, 16);
+        worker.addDevice(cfg);
+    }
+    worker.start();
+
+    bool success = true;
+    int steadyResults = 0;
+    qint64 fewestRuns = 0;
+    qint64 startNs = PollingScheduler::monotonicNs();
+    qint64 steadyNs = -1;   // 所有设备都过了预热的时刻
+    for (;;) {
+        PollResult item;
+        while (worker.takeResult(item)) {
+            success = success && item.result.isSuccess();
+            if (steadyNs >= 0) {
+                steadyResults++;
+            }
+        }
+
+        QList<PollingStats> stats = worker.pollingStats();
+        fewestRuns = stats.size() == devices ? std::numeric_limits<qint64>::max() : 0;
+        for (const PollingStats &s : stats) {
+            fewestRuns = qMin(fewestRuns, s.runs);
+        }
+        qint64 now = PollingScheduler::monotonicNs();
+        if (steadyNs < 0 && fewestRuns > BusWorker::WarmupCycles) {
+            steadyNs = now;
+        }
+        if (steadyNs >= 0 && fewestRuns >= BusWorker::WarmupCycles + SteadyCycles
+                && now - steadyNs >= SteadyMs * 1000000) {
+            break;
+        }
+        if (now - startNs >= TimeoutMs * 1000000) {
+            break;
+        }
+        QThread::msleep(5);
+    }
+    worker.stop();
+
+    check(AllocCounter::isEnabled(), "built with CONFIG+=alloc_counter");
+    check(worker.isSimulated() && success, "BusWorker against sim://");
+    check(fewestRuns >= BusWorker::WarmupCycles + SteadyCycles,
+          QString("%1 cycles per device after warm-up (got %2)")
+          .arg(SteadyCycles).arg(fewestRuns - BusWorker::WarmupCycles));
+    check(steadyResults >= devices, QString("results published in steady state (got %1)").arg(steadyResults));
+    check(worker.steadyAllocCycles() == 0, QString("no allocations in steady worker cycles (got %1 in %2 cycles)")
+          .arg(worker.steadyAllocations()).arg(worker.steadyAllocCycles()));
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    int master = -1;
+    int slaveFd = -1;
+    char name[64];
+    if (openpty(&master, &slaveFd, name, nullptr, nullptr) != 0) {
+        fprintf(stderr, "openpty failed\n");
+        return 1;
+    }
+
+    // 从端按设备文件路径打开，与真实串口走同一条路径
+    SerialConfig cfg;
+    cfg.port = QString::fromLocal8Bit(name);
+    cfg.baudRate = 115200;
+    SerialTransport serial;
+    Result opened = serial.open(cfg);
+    ::close(slaveFd);
+    check(opened.isSuccess(), QString("open %1").arg(cfg.port));
+
+    if (serial.isOpen()) {
+        for (quint8 fc : { quint8(3), quint8(4) }) {
+            roundTrip(serial, master, fc, PtySlave::Normal);
+            roundTrip(serial, master, fc, PtySlave::Exception);
+            roundTrip(serial, master, fc, PtySlave::BadCrc);
+        }
+
+        ::close(master);
+        ModbusFrame request;
+        ModbusFrame response;
+        ModbusRtu::encodeReadRequest(request, 1, 3, 0, 1);
+        check(serial.transact(request, response, ModbusRtu::expectedReadResponseLength(3, 1), 200)
+              == ModbusRtu::ErrIo, "hang-up returns ErrIo");
+    }
+
+    // 打不开的串口不退回模拟从站：事务返回ErrIo，由采集线程按通信中断上报
+    SerialConfig missing;
+    missing.port = "/dev/tst_acquisition_missing";
+    SerialTransport absent;
+    check(!absent.open(missing).isSuccess(), "open a missing port fails");
+    ModbusFrame request;
+    ModbusFrame response;
+    ModbusRtu::encodeReadRequest(request, 1, 3, 0, 1);
+    check(absent.transact(request, response, ModbusRtu::expectedReadResponseLength(3, 1), 200)
+          == ModbusRtu::ErrIo, "missing port returns ErrIo");
+
+    checkSteadyStateAllocations();
+    benchmarkCodec();
+    return s_failures == 0 ? 0 : 1;
+}
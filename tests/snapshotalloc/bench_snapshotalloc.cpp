@@ -0,0 +1,123 @@
+/**
+ * @file bench_snapshotalloc.cpp
+ * @brief 采集结果表示方式基准（以CONFIG+=alloc_counter构建）
+ *
+ * 同一设备配置的PollingTask对模拟从站采集（不模拟线路耗时），比较预热后每周期
+ * 采集线程的堆分配次数和耗时：
+ * - QVariantList：采集后按RegisterSnapshot引入前的方式，每个值组成一个QVariantMap
+ *   （地址、名称、值、单位、更新时间）放进列表，作为Result的数据；
+ * - RegisterSnapshot：采集任务写入复用的快照，Result中只带快照指针。
+ * 两者都包含采集本身，差值即旧的结果表示的开销。
+ */
+
+#include "alloccounter.h"
+#include "busworker.h"
+#include "modbussimulator.h"
+#include "pollingscheduler.h"
+#include "pollingtask.h"
+#include "readplanner.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <cstdio>
+
+namespace {
+
+const int MeasuredCycles = 2000;
+
+/**
+ * @brief 每周期的平均值
+ */
+struct Measurement {
+    double allocations;     ///< 堆分配次数
+    double ns;              ///< 耗时（纳秒）
+};
+
+/**
+ * @brief 按旧方式把一次采集的值组成QVariantList（与引入RegisterSnapshot之前的PollingTask相同）
+ */
+Result toVariantList(const QVector<RegisterPoint> &points, const RegisterSnapshot &snapshot)
+{
+    QString updateTime = QDateTime::currentDateTime().toString("hh:mm:ss");
+    QVariantList registers;
+    int index = 0;
+    for (const RegisterPoint &p : points) {
+        int width = RegisterDecoder::registerWidth(p.dataType);
+        int valueCount = p.valueCount();
+        for (int k = 0; k < valueCount; ++k) {
+            int address = p.address + k * width;
+            QVariantMap reg;
+            reg["address"] = address;
+            if (p.name.isEmpty()) {
+                reg["name"] = QString("寄存器 %1").arg(address);
+            } else {
+                reg["name"] = valueCount > 1 ? QString("%1[%2]").arg(p.name).arg(k) : p.name;
+            }
+            reg["value"] = snapshot.values[index++];
+            reg["unit"] = p.unit;
+            reg["updateTime"] = updateTime;
+            registers.append(reg);
+        }
+    }
+    return Result::success(registers);
+}
+
+/**
+ * @brief 预热BusWorker::WarmupCycles轮后测量MeasuredCycles轮
+ * @param variantList true按旧方式组成QVariantList，false发布快照
+ */
+Measurement measure(const DeviceConfig &cfg, bool variantList)
+{
+    PollingTask task(cfg);
+    ModbusSimulator simulator;
+    const QVector<RegisterPoint> points = ReadPlanner::devicePoints(cfg);
+
+    Result published;   // 最近发布的结果，与采集线程一样在下一轮采集期间仍被持有
+    quint64 allocations = 0;
+    qint64 startNs = 0;
+    for (int cycle = 0; cycle < BusWorker::WarmupCycles + MeasuredCycles; ++cycle) {
+        if (cycle == BusWorker::WarmupCycles) {
+            allocations = AllocCounter::threadCount();
+            startNs = PollingScheduler::monotonicNs();
+        }
+        QExplicitlySharedDataPointer<RegisterSnapshot> snapshot;
+        Result result = task.execute(&simulator, 100, &snapshot);
+        if (!result.isSuccess()) {
+            published = result;
+        } else if (variantList) {
+            published = toVariantList(points, *snapshot);
+        } else {
+            published = Result::success(QVariant::fromValue(RegisterSnapshotPtr(snapshot)));
+        }
+    }
+
+    Measurement m;
+    m.allocations = double(AllocCounter::threadCount() - allocations) / MeasuredCycles;
+    m.ns = double(PollingScheduler::monotonicNs() - startNs) / MeasuredCycles;
+    return m;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    if (!AllocCounter::isEnabled()) {
+        fprintf(stderr, "build with CONFIG+=alloc_counter\n");
+        return 1;
+    }
+
+    printf("registers  representation    allocs/cycle  ns/cycle\n");
+    for (int registers : { 10, 100 }) {
+        DeviceConfig cfg;
+        cfg.id = 1;
+        cfg.modbusAddress = 1;
+        cfg.registerCount = registers;
+
+        Measurement old = measure(cfg, true);
+        Measurement snapshot = measure(cfg, false);
+        printf("%9d  QVariantList/Map  %12.1f  %8.0f\n", registers, old.allocations, old.ns);
+        printf("%9d  RegisterSnapshot  %12.1f  %8.0f\n", registers, snapshot.allocations, snapshot.ns);
+    }
+    return 0;
+}
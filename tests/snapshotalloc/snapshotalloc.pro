@@ -0,0 +1,8 @@
+# 基准：旧的QVariantList/QVariantMap结果与RegisterSnapshot每周期的堆分配次数和耗时，
+# 须在包含tests.pri之前打开alloc_counter
+TARGET = bench_snapshotalloc
+CONFIG += alloc_counter
+
+include(../tests.pri)
+
+SOURCES += bench_snapshotalloc.cpp
@@ -0,0 +1,188 @@
+/**
+ * @file bench_snapshotbatch.cpp
+ * @brief 采集结果交付方式基准
+ *
+ * 生产线程每个周期交付N个设备的结果，界面线程的事件循环处理完全部结果算一个周期：
+ * - 逐设备：每个设备一次排队信号，槽函数按设备ID到最新结果表中查询（旧的deviceDataUpdated方式）；
+ * - 批量：一个SnapshotBatch一次排队信号，槽函数遍历批（dataBatchUpdated方式）。
+ * 分别在N=100和N=500时打印每周期耗时（从生产线程开始交付到界面线程处理完）。
+ */
+
+#include "pollingscheduler.h"
+#include "registersnapshot.h"
+#include "../common/result.h"
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QMutex>
+#include <QSemaphore>
+#include <QThread>
+#include <cstdio>
+
+namespace {
+
+const int WarmupCycles = 50;
+const int MeasuredCycles = 1000;
+const int ValuesPerDevice = 20;
+
+} // namespace
+
+/**
+ * @class Receiver
+ * @brief 界面线程中的订阅者
+ */
+class Receiver : public QObject
+{
+    Q_OBJECT
+
+public:
+    Receiver(const QHash<int, Result> *latest, QMutex *mutex, QSemaphore *done)
+        : m_latest(latest), m_mutex(mutex), m_done(done), m_expected(0), m_received(0), m_sum(0) {}
+
+    void expect(int devices) { m_expected = devices; }
+    double sum() const { return m_sum; }
+
+public slots:
+    void onDeviceDataUpdated(int deviceId)
+    {
+        Result result;
+        {
+            QMutexLocker locker(m_mutex);
+            result = m_latest->value(deviceId);
+        }
+        m_sum += result.data.value<RegisterSnapshotPtr>()->values[0];
+        if (++m_received == m_expected) {
+            m_received = 0;
+            m_done->release();
+        }
+    }
+
+    void onDataBatchUpdated(const SnapshotBatchPtr &batch)
+    {
+        for (const RegisterSnapshotPtr &snapshot : batch->snapshots) {
+            m_sum += snapshot->values[0];
+        }
+        m_done->release();
+    }
+
+private:
+    const QHash<int, Result> *m_latest; ///< 设备ID → 最新结果（逐设备方式）
+    QMutex *m_mutex;                    ///< 保护m_latest
+    QSemaphore *m_done;                 ///< 每处理完一个周期释放一次
+    int m_expected;                     ///< 逐设备方式每周期的信号数
+    int m_received;                     ///< 本周期已收到的信号数
+    double m_sum;                       ///< 读到的值之和，避免读取被优化掉
+};
+
+/**
+ * @class Producer
+ * @brief 生产线程，相当于采集线程交付结果
+ */
+class Producer : public QThread
+{
+    Q_OBJECT
+
+public:
+    Producer()
+        : m_receiver(&m_latest, &m_mutex, &m_done)
+    {
+        connect(this, &Producer::deviceDataUpdated, &m_receiver, &Receiver::onDeviceDataUpdated,
+                Qt::QueuedConnection);
+        connect(this, &Producer::dataBatchUpdated, &m_receiver, &Receiver::onDataBatchUpdated,
+                Qt::QueuedConnection);
+    }
+
+signals:
+    void deviceDataUpdated(int deviceId);
+    void dataBatchUpdated(const SnapshotBatchPtr &batch);
+
+protected:
+    void run() override
+    {
+        for (int devices : { 100, 500 }) {
+            QVector<RegisterSnapshotPtr> snapshots = makeSnapshots(devices);
+            double perDeviceUs = measure(snapshots, false);
+            double batchUs = measure(snapshots, true);
+            printf("N=%-4d per-device signals: %8.1f us/cycle   one SnapshotBatch: %6.1f us/cycle\n",
+                   devices, perDeviceUs, batchUs);
+        }
+        printf("(checksum %.0f)\n", m_receiver.sum());
+    }
+
+private:
+    static QVector<RegisterSnapshotPtr> makeSnapshots(int devices)
+    {
+        QSharedPointer<RegisterLayout> layout = QSharedPointer<RegisterLayout>::create();
+        for (int i = 0; i < ValuesPerDevice; ++i) {
+            layout->addresses.append(i);
+            layout->names.append(QString("寄存器 %1").arg(i));
+            layout->units.append(QString());
+        }
+        layout->physicalCount = ValuesPerDevice;
+
+        QVector<RegisterSnapshotPtr> snapshots;
+        for (int d = 0; d < devices; ++d) {
+            QExplicitlySharedDataPointer<RegisterSnapshot> s(new RegisterSnapshot());
+            s->deviceId = d + 1;
+            s->layout = layout;
+            s->values.fill(d, ValuesPerDevice);
+            s->resetFlags(ValuesPerDevice);
+            s->timestampsNs.fill(PollingScheduler::wallClockNs(), ValuesPerDevice);
+            snapshots.append(RegisterSnapshotPtr(s));
+        }
+        return snapshots;
+    }
+
+    /**
+     * @return 每周期平均耗时（微秒）
+     */
+    double measure(const QVector<RegisterSnapshotPtr> &snapshots, bool batched)
+    {
+        m_receiver.expect(snapshots.size());
+        qint64 totalNs = 0;
+        for (int cycle = 0; cycle < WarmupCycles + MeasuredCycles; ++cycle) {
+            qint64 start = PollingScheduler::monotonicNs();
+            if (batched) {
+                QSharedPointer<SnapshotBatch> batch = QSharedPointer<SnapshotBatch>::create();
+                batch->reserve(snapshots.size());
+                for (const RegisterSnapshotPtr &s : snapshots) {
+                    batch->append(s->deviceId, s);
+                }
+                emit dataBatchUpdated(batch);
+            } else {
+                {
+                    QMutexLocker locker(&m_mutex);
+                    for (const RegisterSnapshotPtr &s : snapshots) {
+                        m_latest.insert(s->deviceId, Result::success(QVariant::fromValue(s)));
+                    }
+                }
+                for (const RegisterSnapshotPtr &s : snapshots) {
+                    emit deviceDataUpdated(s->deviceId);
+                }
+            }
+            m_done.acquire();
+            if (cycle >= WarmupCycles) {
+                totalNs += PollingScheduler::monotonicNs() - start;
+            }
+        }
+        return totalNs / 1000.0 / MeasuredCycles;
+    }
+
+    QHash<int, Result> m_latest;    ///< 设备ID → 最新结果（逐设备方式）
+    QMutex m_mutex;                 ///< 保护m_latest
+    QSemaphore m_done;              ///< 界面线程处理完一个周期
+    Receiver m_receiver;            ///< 界面线程中的订阅者（属于主线程）
+};
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    qRegisterMetaType<SnapshotBatchPtr>();
+
+    Producer producer;
+    QObject::connect(&producer, &QThread::finished, &app, &QCoreApplication::quit);
+    producer.start();
+    return app.exec();
+}
+
+#include "bench_snapshotbatch.moc"
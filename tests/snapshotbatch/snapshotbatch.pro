@@ -0,0 +1,6 @@
+# 基准：逐设备排队信号与一次SnapshotBatch经事件循环交付的每周期耗时
+TARGET = bench_snapshotbatch
+
+include(../tests.pri)
+
+SOURCES += bench_snapshotbatch.cpp
@@ -0,0 +1,8 @@
+# TCP传输测试：本机回环上的Modbus TCP从站乱序应答、关闭连接，
+# 检查事务ID匹配、MaxInFlight个请求同时在途和断开后的自动重连
+TARGET = tst_tcptransport
+CONFIG += testcase
+
+include(../tests.pri)
+
+SOURCES += tst_tcptransport.cpp
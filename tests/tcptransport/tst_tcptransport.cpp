@@ -0,0 +1,333 @@
+/**
+ * @file tst_tcptransport.cpp
+ * @brief TCP传输测试
+ *
+ * TcpTransport连接本机回环上的Modbus TCP从站线程：
+ * - 一批2×MaxInFlight个读请求：从站攒齐在途请求后倒序应答，检查每个事务按事务ID
+ *   拿到自己的响应，且同时在途的请求数正好是MaxInFlight；
+ * - 从站收到请求后不应答就关闭连接：事务返回ErrIo，传输层处于断开状态；
+ * - 之后的事务自动重连，从站先发一个未知事务ID的响应再正常应答，多余的响应被丢弃。
+ * 任一检查失败时返回非0。
+ */
+
+#include "modbusrtu.h"
+#include "tcptransport.h"
+
+#include <QCoreApplication>
+#include <QThread>
+#include <QVector>
+#include <cstdio>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+const int BatchSize = 2 * TcpTransport::MaxInFlight;
+const quint16 RegisterCount = 4;
+const int TimeoutMs = 2000;
+
+int s_failures = 0;
+
+void check(bool ok, const QString &what)
+{
+    printf("%s %s\n", ok ? "PASS" : "FAIL", what.toLocal8Bit().constData());
+    if (!ok) {
+        s_failures++;
+    }
+}
+
+/**
+ * @brief 从站返回的寄存器值（从站地址不同值不同，用来发现响应交错）
+ */
+quint16 registerValue(int slave, int address)
+{
+    return static_cast<quint16>(slave * 1000 + address);
+}
+
+/**
+ * @struct MbapRequest
+ * @brief 从站收到的一个FC03读请求
+ */
+struct MbapRequest {
+    quint16 tid;        ///< 事务ID
+    quint8 unit;        ///< 单元标识
+    quint16 start;      ///< 起始地址
+    quint16 count;      ///< 寄存器个数
+};
+
+/**
+ * @class MbapSlave
+ * @brief 回环上的Modbus TCP从站，依次服务两个连接后退出
+ *
+ * - 第一个连接：在途请求攒齐（IdleMs内没有新请求）后倒序应答，共应答BatchSize个；
+ *   再收到一个请求时不应答，直接关闭连接；
+ * - 第二个连接（重连）：每个请求先用未知事务ID应答一次，再正常应答，直到对端关闭。
+ */
+class MbapSlave : public QThread
+{
+public:
+    enum Limits {
+        IdleMs = 100    ///< 多长时间没有新请求算攒齐
+    };
+
+    explicit MbapSlave(int listenFd)
+        : m_listenFd(listenFd), m_maxPending(0), m_answered(0), m_connections(0), m_malformed(false) {}
+
+    int maxPending() const { return m_maxPending; }
+    int answered() const { return m_answered; }
+    int connections() const { return m_connections; }
+    bool malformed() const { return m_malformed; }
+
+protected:
+    void run() override
+    {
+        int fd = accept();
+        if (fd < 0) {
+            return;
+        }
+        QVector<MbapRequest> pending;
+        int idleMs = 0;     // 没有在途请求时的空等时间，超过TimeoutMs说明传输层不再发送
+        while (m_answered < BatchSize) {
+            MbapRequest request;
+            int rc = readRequest(fd, &request, IdleMs);
+            if (rc == 0 && pending.isEmpty()) {
+                idleMs += IdleMs;
+                rc = idleMs >= TimeoutMs ? -1 : 0;
+            }
+            if (rc < 0) {
+                ::close(fd);
+                return;
+            }
+            if (rc > 0) {
+                idleMs = 0;
+                pending.append(request);
+                m_maxPending = qMax(m_maxPending, pending.size());
+                continue;
+            }
+            while (!pending.isEmpty()) {
+                reply(fd, pending.last(), pending.last().tid);
+                pending.removeLast();
+                m_answered++;
+            }
+        }
+        MbapRequest dropped;
+        readRequest(fd, &dropped, TimeoutMs);
+        ::close(fd);
+
+        fd = accept();
+        if (fd < 0) {
+            return;
+        }
+        MbapRequest request;
+        while (readRequest(fd, &request, TimeoutMs) > 0) {
+            reply(fd, request, static_cast<quint16>(request.tid ^ 0x8000));
+            reply(fd, request, request.tid);
+            m_answered++;
+        }
+        ::close(fd);
+    }
+
+private:
+    int accept()
+    {
+        struct pollfd pfd;
+        pfd.fd = m_listenFd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (::poll(&pfd, 1, TimeoutMs) <= 0) {
+            return -1;
+        }
+        int fd = ::accept(m_listenFd, nullptr, nullptr);
+        if (fd >= 0) {
+            m_connections++;
+        }
+        return fd;
+    }
+
+    /**
+     * @brief 读满length字节
+     * @return false表示超时或连接关闭
+     */
+    bool readExactly(int fd, quint8 *data, int length, int timeoutMs)
+    {
+        int received = 0;
+        while (received < length) {
+            struct pollfd pfd;
+            pfd.fd = fd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            if (::poll(&pfd, 1, timeoutMs) <= 0) {
+                return false;
+            }
+            ssize_t n = ::read(fd, data + received, length - received);
+            if (n <= 0) {
+                return false;
+            }
+            received += static_cast<int>(n);
+        }
+        return true;
+    }
+
+    /**
+     * @brief 读一个FC03请求（MBAP报文头 + 5字节PDU）
+     * @return 1读到请求，0在timeoutMs内没有新请求，-1连接关闭或报文错误
+     */
+    int readRequest(int fd, MbapRequest *request, int timeoutMs)
+    {
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (::poll(&pfd, 1, timeoutMs) <= 0) {
+            return 0;
+        }
+
+        quint8 adu[TcpTransport::MbapHeaderLength + 5];
+        if (!readExactly(fd, adu, sizeof(adu), TimeoutMs)) {
+            return -1;
+        }
+        int length = (adu[4] << 8) | adu[5];
+        if (adu[2] != 0 || adu[3] != 0 || length != 6 || adu[7] != 3) {
+            m_malformed = true;
+            return -1;
+        }
+        request->tid = static_cast<quint16>((adu[0] << 8) | adu[1]);
+        request->unit = adu[6];
+        request->start = static_cast<quint16>((adu[8] << 8) | adu[9]);
+        request->count = static_cast<quint16>((adu[10] << 8) | adu[11]);
+        return 1;
+    }
+
+    /**
+     * @brief 以指定事务ID应答；事务ID与请求不同时值取反，被误收时解码结果不对
+     */
+    void reply(int fd, const MbapRequest &request, quint16 tid)
+    {
+        quint8 adu[TcpTransport::MbapHeaderLength + 2 + 2 * ModbusRtu::MaxReadRegisters];
+        int pduLength = 2 + 2 * request.count;
+        adu[0] = static_cast<quint8>(tid >> 8);
+        adu[1] = static_cast<quint8>(tid & 0xFF);
+        adu[2] = 0;
+        adu[3] = 0;
+        adu[4] = static_cast<quint8>((pduLength + 1) >> 8);
+        adu[5] = static_cast<quint8>((pduLength + 1) & 0xFF);
+        adu[6] = request.unit;
+        adu[7] = 3;
+        adu[8] = static_cast<quint8>(request.count * 2);
+        for (int i = 0; i < request.count; ++i) {
+            quint16 value = registerValue(request.unit, request.start + i);
+            if (tid != request.tid) {
+                value = static_cast<quint16>(~value);
+            }
+            adu[9 + 2 * i] = static_cast<quint8>(value >> 8);
+            adu[10 + 2 * i] = static_cast<quint8>(value & 0xFF);
+        }
+        int length = TcpTransport::MbapHeaderLength + pduLength;
+        if (::write(fd, adu, length) != length) {
+            m_malformed = true;
+        }
+    }
+
+    int m_listenFd;     ///< 监听socket
+    int m_maxPending;   ///< 同时在途请求数的最大值
+    int m_answered;     ///< 已正常应答的请求数
+    int m_connections;  ///< 已接受的连接数
+    bool m_malformed;   ///< 是否收到错误的请求报文或发送失败
+};
+
+/**
+ * @brief 编码一个读请求：从站地址和起始地址随下标变化
+ */
+void encodeRequest(ModbusTransaction &t, int index)
+{
+    ModbusRtu::encodeReadRequest(t.request, static_cast<quint8>(1 + index % 5), 3,
+                                 static_cast<quint16>(index * 10), RegisterCount);
+    t.expectedLength = ModbusRtu::expectedReadResponseLength(3, RegisterCount);
+}
+
+/**
+ * @brief 检查一个事务拿到的是自己请求的值
+ */
+bool matches(const ModbusTransaction &t, int index)
+{
+    if (t.status != ModbusRtu::Ok) {
+        return false;
+    }
+    quint8 slave = static_cast<quint8>(1 + index % 5);
+    quint16 values[RegisterCount];
+    if (ModbusRtu::decodeReadResponse(t.response, slave, 3, RegisterCount, values) != ModbusRtu::Ok) {
+        return false;
+    }
+    for (int i = 0; i < RegisterCount; ++i) {
+        if (values[i] != registerValue(slave, index * 10 + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    int listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t addrLength = sizeof(addr);
+    if (listenFd < 0 || ::bind(listenFd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0
+            || ::listen(listenFd, 4) != 0
+            || ::getsockname(listenFd, reinterpret_cast<struct sockaddr *>(&addr), &addrLength) != 0) {
+        fprintf(stderr, "cannot listen on loopback\n");
+        return 1;
+    }
+
+    MbapSlave slave(listenFd);
+    slave.start();
+
+    TcpTransport tcp;
+    QString endpoint = QString("tcp://127.0.0.1:%1").arg(ntohs(addr.sin_port));
+    check(tcp.open(endpoint, TcpTransport::MaxInFlight).isSuccess(), QString("open %1").arg(endpoint));
+
+    // 倒序应答：每个事务都要按事务ID拿到自己的响应
+    ModbusTransaction batch[BatchSize];
+    for (int i = 0; i < BatchSize; ++i) {
+        encodeRequest(batch[i], i);
+    }
+    tcp.transactBatch(batch, BatchSize, TimeoutMs);
+    int matched = 0;
+    for (int i = 0; i < BatchSize; ++i) {
+        matched += matches(batch[i], i) ? 1 : 0;
+    }
+    check(matched == BatchSize, QString("out-of-order replies matched by transaction ID (%1/%2)")
+          .arg(matched).arg(BatchSize));
+
+    // 从站攒齐后才应答，少于MaxInFlight说明没有流水线，多于说明窗口失控
+    check(slave.maxPending() == TcpTransport::MaxInFlight, QString("%1 requests in flight (got %2)")
+          .arg(int(TcpTransport::MaxInFlight)).arg(slave.maxPending()));
+
+    // 对端关闭连接
+    ModbusTransaction t;
+    encodeRequest(t, 1);
+    tcp.transactBatch(&t, 1, TimeoutMs);
+    check(t.status == ModbusRtu::ErrIo && !tcp.isOpen(), "peer close returns ErrIo");
+
+    // 下一个事务自动重连，未知事务ID的响应被丢弃
+    encodeRequest(t, 2);
+    tcp.transactBatch(&t, 1, TimeoutMs);
+    check(matches(t, 2) && tcp.isOpen(), "reconnect after peer close, unknown transaction ID ignored");
+
+    tcp.close();
+    slave.wait();
+    ::close(listenFd);
+    check(slave.connections() == 2 && slave.answered() == BatchSize + 1 && !slave.malformed(),
+          "slave saw two connections and well-formed requests");
+    return s_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,12 @@
+# 各测试、基准程序的公共设置：控制台程序，链接整个服务层
+QT = core network sql
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+include($$PWD/../service/service.pri)
+
+INCLUDEPATH += $$PWD/../common \
+               $$PWD/../service
+
+OBJECTS_DIR = build/.obj
+MOC_DIR = build/.moc
@@ -0,0 +1,8 @@
+# 测试和基准程序（只依赖服务层，不含界面）
+# 构建并运行测试：qmake tests/tests.pro && make && make check
+TEMPLATE = subdirs
+
+SUBDIRS += acquisition \
+           snapshotalloc \
+           snapshotbatch \
+           tcptransport